@@ -0,0 +1,233 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Benchmark harness for HashTbl and its companions.
+//
+// Usage: bench_hash [--filter <text>] [--n <size>] [--threads <t>] [--repeat <r>] [--no-counters] [--list]
+//        bench_hash --gate <baseline.json> [--tolerance <percent>] [--update-baseline] [--n <size>] [--repeat <r>]
+//
+// The gate mode runs a fixed subset of the cases, compares the median ns/op of every benchmark with the baseline and
+// exits with a non-zero status when one regressed. --update-baseline rewrites the baseline from the current run.
+
+#include "bench.h"
+#include "gate.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <utility>
+
+namespace bench {
+namespace {
+std::vector<std::pair<std::string, CaseFn> >& registry() {
+    static std::vector<std::pair<std::string, CaseFn> > cases;
+    return cases;
+}
+
+/// Cases run by the regression gate. Changing the list (or their code) calls for --update-baseline.
+const char* gate_cases[] = {"hashtbl_int", "hashtbl_acct"};
+/// Defaults of the gate: smaller than the cases' own sizes, with more repeats, to get stable medians quickly.
+const std::size_t gate_n = 200000;
+const unsigned gate_repeat = 7;
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog
+              << " [--filter <text>] [--n <size>] [--threads <t>] [--repeat <r>] [--no-counters] [--list]\n"
+              << "       " << prog
+              << " --gate <baseline.json> [--tolerance <percent>] [--update-baseline] [--n <size>] [--repeat <r>]\n";
+}
+
+/// Prints one line per sample name: median time per operation and median counters per operation.
+void report(const std::vector<Sample>& samples, std::ostream& os) {
+    std::vector<std::string> order;
+    std::map<std::string, std::vector<const Sample*> > by_name;
+    for (const auto& s : samples) {
+        if (by_name[s.name].empty()) order.push_back(s.name);
+        by_name[s.name].push_back(&s);
+    }
+
+    for (const auto& name : order) {
+        const auto& runs = by_name[name];
+        std::vector<double> ns;
+        for (auto s : runs) ns.push_back(s->seconds * 1e9 / std::max<std::size_t>(1, s->ops));
+        double ns_op = median(ns);
+        os << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(2) << std::setw(12)
+           << ns_op << std::setw(12) << (ns_op > 0 ? 1e3 / ns_op : 0);
+
+        for (int e{0}; e < static_cast<int>(PerfEvent::n_events); e++) {
+            std::vector<double> per_op;
+            for (auto s : runs)
+                if (s->counters.valid[e]) per_op.push_back(static_cast<double>(s->counters.value[e]) / s->ops);
+            os << std::setw(18);
+            if (per_op.empty())
+                os << "-";
+            else
+                os << std::setprecision(e == 0 or e == 1 ? 1 : 3) << median(per_op);
+        }
+        os << "\n";
+    }
+    os << std::defaultfloat;
+}
+}  // namespace
+
+unsigned Context::threads() const {
+    if (m_opt.threads) return m_opt.threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+Registrar::Registrar(const char* name_, CaseFn fn_) { registry().emplace_back(name_, fn_); }
+
+namespace {
+/// Regression gate mode; returns the process exit code.
+int run_gate(Options opt, bool repeat_given) {
+    Baseline base;
+    if (!opt.update_baseline) {
+        std::ifstream ifs(opt.gate);
+        if (!ifs) {
+            std::cerr << "Cannot open " << opt.gate << " (create it with --update-baseline)\n";
+            return EXIT_FAILURE;
+        }
+        try {
+            base = read_baseline(ifs);
+        } catch (const std::runtime_error& e) {
+            std::cerr << opt.gate << ": " << e.what() << "\n";
+            return EXIT_FAILURE;
+        }
+        // Timings only compare at the same problem size.
+        if (opt.n and opt.n != base.n) {
+            std::cerr << "The baseline was taken with --n " << base.n << "; refresh it to gate another size.\n";
+            return EXIT_FAILURE;
+        }
+        opt.n = base.n;
+    }
+    if (!opt.n) opt.n = gate_n;
+    if (!repeat_given) opt.repeat = gate_repeat;
+
+    std::cout << ">>> Regression gate: " << opt.repeat << " runs of each case, n = " << opt.n << "\n";
+    std::vector<Sample> samples;
+    for (const auto& c : registry()) {
+        if (std::find_if(std::begin(gate_cases), std::end(gate_cases),
+                         [&](const char* name) { return c.first == name; }) == std::end(gate_cases))
+            continue;
+        CaseOutput out;
+        for (unsigned r{0}; r < opt.repeat; r++) {
+            Context ctx(opt, nullptr, c.first, out);
+            c.second(ctx);
+        }
+        samples.insert(samples.end(), out.samples.begin(), out.samples.end());
+    }
+    auto current = summarize(samples, opt.n);
+
+    if (opt.update_baseline) {
+        std::ofstream ofs(opt.gate);
+        write_baseline(ofs, current);
+        if (!ofs) {
+            std::cerr << "Cannot write " << opt.gate << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << ">>> Baseline with " << current.benchmarks.size() << " benchmarks written to " << opt.gate
+                  << "\n";
+        return EXIT_SUCCESS;
+    }
+    return report_gate(compare(base, current, opt.tolerance), opt.tolerance, std::cout) ? EXIT_SUCCESS
+                                                                                         : EXIT_FAILURE;
+}
+}  // namespace
+
+int run(int argc, char* argv[]) {
+    Options opt;
+    bool list{false}, repeat_given{false};
+    for (int i{1}; i < argc; i++) {
+        std::string arg{argv[i]};
+        if (arg == "--no-counters") {
+            opt.counters = false;
+            continue;
+        }
+        if (arg == "--list") {
+            list = true;
+            continue;
+        }
+        if (arg == "--update-baseline") {
+            opt.update_baseline = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        std::string value{argv[++i]};
+        try {
+            if (arg == "--filter")
+                opt.filter = value;
+            else if (arg == "--n")
+                opt.n = std::stoul(value);
+            else if (arg == "--threads")
+                opt.threads = static_cast<unsigned>(std::stoul(value));
+            else if (arg == "--repeat") {
+                opt.repeat = std::max(1u, static_cast<unsigned>(std::stoul(value)));
+                repeat_given = true;
+            } else if (arg == "--gate")
+                opt.gate = value;
+            else if (arg == "--tolerance")
+                opt.tolerance = std::stod(value) / 100;
+            else {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } catch (const std::exception&) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (opt.update_baseline and opt.gate.empty()) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (!opt.gate.empty()) return run_gate(opt, repeat_given);
+
+    auto cases = registry();
+    std::sort(cases.begin(), cases.end(),
+              [](const std::pair<std::string, CaseFn>& a, const std::pair<std::string, CaseFn>& b) {
+                  return a.first < b.first;
+              });
+    if (list) {
+        for (const auto& c : cases) std::cout << c.first << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    PerfCounters counters;
+    PerfCounters* active = nullptr;
+    if (opt.counters) {
+        if (!counters.status().empty()) std::cout << ">>> Note: " << counters.status() << "\n";
+        if (counters.available()) active = &counters;
+    }
+
+    std::cout << std::left << std::setw(40) << "benchmark" << std::right << std::setw(12) << "ns/op" << std::setw(12)
+              << "Mops/s";
+    for (auto name : perf_event_names) std::cout << std::setw(18) << (std::string(name) + "/op");
+    std::cout << "\n";
+
+    for (const auto& c : cases) {
+        if (c.first.find(opt.filter) == std::string::npos) continue;
+        CaseOutput out;
+        for (unsigned r{0}; r < opt.repeat; r++) {
+            Context ctx(opt, active, c.first, out);
+            c.second(ctx);
+        }
+        report(out.samples, std::cout);
+        for (const auto& l : out.latencies)
+            std::cout << std::left << std::setw(40) << l.name << std::right << "  latency ns: " << l.hist << "\n";
+        for (const auto& n : out.notes)
+            std::cout << std::left << std::setw(40) << n.first << std::right << "  " << n.second << "\n";
+        std::cout.flush();
+    }
+    return EXIT_SUCCESS;
+}
+
+}  // namespace bench
+
+int main(int argc, char* argv[]) { return bench::run(argc, argv); }
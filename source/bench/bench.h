@@ -0,0 +1,136 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <chrono>      // std::chrono::steady_clock
+#include <cstddef>     // std::size_t
+#include <functional>  // std::function
+#include <string>      // std::string
+#include <utility>     // std::pair
+#include <vector>      // std::vector
+
+#include "../include/latency_histogram.h"
+#include "perf_counters.h"
+
+namespace bench {
+/// One timed region of a benchmark case.
+struct Sample {
+    std::string name;    //!< "case/label".
+    std::size_t ops;     //!< Operations performed in the region.
+    double seconds;      //!< Wall time of the region.
+    PerfSample counters;  //!< Hardware counters of the region (may be all invalid).
+};
+
+/// Per-operation latency distribution reported by a case.
+struct LatencySample {
+    std::string name;           //!< "case/label".
+    ac::LatencyHistogram hist;  //!< Latencies in ns.
+};
+
+/// Everything a case reports, accumulated over its repeats.
+struct CaseOutput {
+    std::vector<Sample> samples;                                //!< Timed regions.
+    std::vector<LatencySample> latencies;                       //!< Latency distributions, merged across repeats.
+    std::vector<std::pair<std::string, std::string> > notes;  //!< Free-form results, the last repeat wins.
+};
+
+/// Command line settings shared by all cases.
+struct Options {
+    std::size_t n{0};             //!< Problem size override; 0 keeps the default of each case.
+    unsigned threads{0};          //!< Thread count override; 0 means hardware concurrency.
+    unsigned repeat{3};           //!< How many times every case is run.
+    std::string filter;           //!< Only cases whose name contains this text are run.
+    bool counters{true};          //!< Collect hardware counters when available.
+    std::string gate;             //!< Baseline file: run the regression gate against it instead of the normal report.
+    bool update_baseline{false};  //!< With gate: rewrite the baseline from this run instead of comparing.
+    double tolerance{0.10};       //!< With gate: relative slowdown allowed before failing.
+};
+
+/**
+ * @brief Handed to every benchmark case. The case builds its input outside of measure() and wraps the operations it
+ * wants timed in measure(); each call produces one sample, normalized by the number of operations it declares.
+ */
+class Context {
+   public:
+    Context(const Options& opt_, PerfCounters* counters_, const std::string& case_, CaseOutput& out_)
+        : m_opt(opt_), m_counters(counters_), m_case(case_), m_out(out_) {}
+
+    /// Problem size: the --n override, or the default given by the case.
+    std::size_t size(std::size_t default_) const { return m_opt.n ? m_opt.n : default_; }
+    /// Number of threads for multi-threaded cases.
+    unsigned threads() const;
+
+    /// Times fn_, which performs ops_ operations, and records it under "case/label_".
+    template <class Fn>
+    void measure(const std::string& label_, std::size_t ops_, Fn fn_) {
+        if (m_counters) m_counters->start();
+        auto start = std::chrono::steady_clock::now();
+        fn_();
+        auto end = std::chrono::steady_clock::now();
+        Sample s{m_case + "/" + label_, ops_, std::chrono::duration<double>(end - start).count(), PerfSample()};
+        if (m_counters) s.counters = m_counters->stop();
+        m_out.samples.push_back(s);
+    }
+
+    /// Reports a latency distribution (e.g. filled with ac::timed()) under "case/label_"; repeats are merged.
+    void record_latency(const std::string& label_, const ac::LatencyHistogram& hist_) {
+        auto name = m_case + "/" + label_;
+        for (auto& l : m_out.latencies) {
+            if (l.name == name) {
+                l.hist.merge(hist_);
+                return;
+            }
+        }
+        m_out.latencies.push_back(LatencySample{name, hist_});
+    }
+
+    /// Reports a free-form result (allocation counts, sizes, ratios...) under "case/label_".
+    void note(const std::string& label_, const std::string& text_) {
+        auto name = m_case + "/" + label_;
+        for (auto& n : m_out.notes) {
+            if (n.first == name) {
+                n.second = text_;
+                return;
+            }
+        }
+        m_out.notes.emplace_back(name, text_);
+    }
+
+   private:
+    const Options& m_opt;
+    PerfCounters* m_counters;
+    std::string m_case;
+    CaseOutput& m_out;
+};
+
+/// Keeps the compiler from optimizing away a value computed by a benchmark.
+template <class T>
+inline void do_not_optimize(const T& value_) {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value_) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value_;
+#endif
+}
+
+using CaseFn = std::function<void(Context&)>;
+
+/// Registers a case at static initialization time; see BENCH_CASE.
+struct Registrar {
+    Registrar(const char* name_, CaseFn fn_);
+};
+
+/// Runs the registered cases according to the command line. Returns the process exit code.
+int run(int argc, char* argv[]);
+
+}  // namespace bench
+
+/// Defines and registers a benchmark case: BENCH_CASE(my_case) { ... ctx.measure(...) ... }
+#define BENCH_CASE(name)                                               \
+    static void bench_case_##name(bench::Context& ctx);                \
+    static bench::Registrar bench_registrar_##name(#name, bench_case_##name); \
+    static void bench_case_##name(bench::Context& ctx)
+
+#endif
@@ -0,0 +1,63 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Group-by aggregation: HashTbl with operator[] per aggregate against AggTable, for several group cardinalities.
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/agg_table.h"
+#include "../include/hashtbl.h"
+#include "../include/thread_pool.h"
+#include "bench.h"
+
+BENCH_CASE(group_by) {
+    // 100M rows take 800 MB of input; the default keeps the case quick, --n 100000000 runs the full size.
+    auto n = ctx.size(10000000);
+    std::mt19937_64 rng(21);
+    std::vector<int> keys(n);
+    std::vector<float> values(n);
+    for (auto& v : values) v = static_cast<float>(rng() % 10000000) / 100.f;
+
+    ac::ThreadPool pool(ctx.threads());
+    // From a handful of banks to one group every four rows; 4000 is about the number of branches.
+    for (std::size_t groups : {std::size_t(16), std::size_t(4000), std::size_t(1) << 20, n / 4}) {
+        for (auto& k : keys) k = static_cast<int>(rng() % groups);
+        auto tag = "_" + std::to_string(groups);
+        double sum{0};
+
+        // What the per-branch report does today: one table per aggregate, each looked up for every row.
+        ac::HashTbl<int, double> sums;
+        ac::HashTbl<int, std::size_t> counts;
+        ctx.measure("hashtbl" + tag, n, [&] {
+            sums.clear();
+            counts.clear();
+            for (std::size_t i{0}; i < n; i++) {
+                sums[keys[i]] += values[i];
+                counts[keys[i]]++;
+            }
+        });
+        ac::AggTable<int, float> table;
+        ctx.measure("aggtable" + tag, n, [&] {
+            table.clear();
+            table.aggregate(keys.data(), values.data(), n);
+        });
+        ac::AggTable<int, float> parallel;
+        ctx.measure("aggtable_parallel" + tag, n, [&] {
+            parallel.clear();
+            parallel.parallel_aggregate(keys.data(), values.data(), n, pool);
+        });
+
+        bool same = table.size() == sums.size() and parallel.size() == sums.size();
+        table.for_each([&](int k, const ac::AggState<float>& s) {
+            auto p = parallel.find(k);
+            same = same and counts.find(k) and *counts.find(k) == s.count and p and p->count == s.count;
+            sum += s.sum;
+        });
+        bench::do_not_optimize(sum);
+        std::ostringstream oss;
+        oss << "groups=" << table.size() << " same_answer=" << (same ? "yes" : "no");
+        ctx.note("check" + tag, oss.str());
+    }
+}
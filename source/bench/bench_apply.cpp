@@ -0,0 +1,92 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Posting a batch of balance adjustments to the account table: one find() per adjustment against apply_batch().
+
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "../driver/account.h"
+#include "../driver/account_gen.h"
+#include "../include/hashtbl.h"
+#include "../include/thread_pool.h"
+#include "bench.h"
+
+namespace {
+/// A balance adjustment on an account.
+template <class Key>
+struct Adjustment {
+    Key account;
+    float amount;
+};
+
+/// Builds `n` adjustments on random stored keys.
+template <class Key>
+std::vector<Adjustment<Key> > make_batch(const std::vector<Key>& keys_, std::size_t n_) {
+    std::mt19937_64 rng(5);
+    std::vector<Adjustment<Key> > batch;
+    batch.reserve(n_);
+    for (std::size_t i{0}; i < n_; i++)
+        batch.push_back({keys_[rng() % keys_.size()], static_cast<float>(rng() % 20001) / 100.f - 100.f});
+    return batch;
+}
+
+/// Posts the batch one adjustment at a time, then sorted by bucket, serially and on ctx.threads() workers. Every strategy
+/// runs on its own copy of the table, and the copies must end up with the same balances.
+template <class Table, class Key, class Balance>
+void apply_all_ways(bench::Context& ctx, const Table& table_, const std::vector<Adjustment<Key> >& batch_,
+                    Balance balance_) {
+    using Adj = Adjustment<Key>;
+    using Data = typename Table::mapped_type;
+    auto key_of = [](const Adj& a) -> const Key& { return a.account; };
+    auto post = [&](const Adj& a, Data& d) { balance_(d) += a.amount; };
+    std::size_t n = batch_.size();
+    Table one(table_), sorted(table_), parallel(table_);
+    ac::ThreadPool pool(ctx.threads());
+
+    ctx.measure("one_by_one", n, [&] {
+        for (const auto& a : batch_) {
+            auto d = one.find(a.account);
+            if (d) post(a, *d);
+        }
+    });
+    ctx.measure("apply_batch", n, [&] { sorted.apply_batch(batch_.begin(), batch_.end(), key_of, post); });
+    ctx.measure("parallel_apply_batch", n,
+                [&] { parallel.parallel_apply_batch(batch_.begin(), batch_.end(), key_of, post, pool); });
+
+    // Each strategy ran once per repetition; with the same order per key, the balances agree to the last bit.
+    bool same{true};
+    one.for_each([&](const Key& k, const Data& d) {
+        Data mine = d, other = *sorted.find(k), third = *parallel.find(k);
+        same = same and balance_(other) == balance_(mine) and balance_(third) == balance_(mine);
+    });
+    std::ostringstream oss;
+    oss << "threads=" << pool.size() << " same_balances=" << (same ? "yes" : "no");
+    ctx.note("check", oss.str());
+}
+}  // namespace
+
+BENCH_CASE(apply_acct) {
+    auto n = ctx.size(1000000);
+    AccountGenerator gen(1);
+    ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual> table;
+    std::vector<Account::AcctKey> keys;
+    for (std::size_t i{0}; i < n; i++) {
+        auto a = gen.next();
+        table.insert(a.getKey(), a);
+        keys.push_back(a.getKey());
+    }
+    apply_all_ways(ctx, table, make_batch(keys, 4 * n), [](Account& a) -> float& { return a.m_balance; });
+}
+
+BENCH_CASE(apply_int) {
+    auto n = ctx.size(4000000);
+    ac::HashTbl<int, float> table;
+    std::vector<int> keys;
+    for (std::size_t i{0}; i < n; i++) {
+        int k = static_cast<int>(i * 2654435761u & 0x7fffffffu);
+        table.insert(k, 0.f);
+        keys.push_back(k);
+    }
+    apply_all_ways(ctx, table, make_batch(keys, 4 * n), [](float& b) -> float& { return b; });
+}
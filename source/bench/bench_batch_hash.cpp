@@ -0,0 +1,109 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Batch key hashing: one operator() call per key against hash_batch(), alone and inside retrieve_many(), for int keys
+// and fixed-length string keys.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/batch_hash.h"
+#include "../include/hashtbl.h"
+#include "bench.h"
+
+namespace {
+using Code = std::array<char, 16>;
+
+/// The same hash as Hash, without its batch form: retrieve_many() then hashes one key at a time.
+template <class Hash>
+struct NoBatch {
+    template <class Key>
+    std::size_t operator()(const Key& key_) const {
+        return Hash()(key_);
+    }
+};
+
+std::vector<Code> make_codes(std::size_t n_) {
+    std::mt19937_64 rng(5);
+    std::vector<Code> codes(n_);
+    for (auto& c : codes) {
+        for (auto& ch : c) ch = static_cast<char>('A' + rng() % 26);
+    }
+    return codes;
+}
+
+/// Hashes keys_ through operator() and through hash_batch(), in groups of 16 as retrieve_many() does.
+template <class Hash, class Key>
+void hash_only(bench::Context& ctx, const std::string& name_, const std::vector<Key>& keys_) {
+    Hash hash;
+    std::size_t out[16], sum{0};
+    ctx.measure(name_ + "_scalar", keys_.size(), [&] {
+        for (std::size_t first{0}; first < keys_.size(); first += 16) {
+            auto m = std::min<std::size_t>(16, keys_.size() - first);
+            for (std::size_t i{0}; i < m; i++) out[i] = hash(keys_[first + i]);
+            sum += out[0] ^ out[m - 1];
+        }
+    });
+    ctx.measure(name_ + "_batch", keys_.size(), [&] {
+        for (std::size_t first{0}; first < keys_.size(); first += 16) {
+            auto m = std::min<std::size_t>(16, keys_.size() - first);
+            hash.hash_batch(keys_.data() + first, m, out);
+            sum += out[0] ^ out[m - 1];
+        }
+    });
+    bench::do_not_optimize(sum);
+}
+
+/// retrieve_many() over probes_ on a table of keys_, with Hash and with the same hash minus its batch form.
+template <class Hash, class Key>
+void lookups(bench::Context& ctx, const std::string& name_, const std::vector<Key>& keys_,
+             const std::vector<Key>& probes_) {
+    ac::HashTbl<Key, int, Hash> batched;
+    ac::HashTbl<Key, int, NoBatch<Hash> > scalar;
+    for (std::size_t i{0}; i < keys_.size(); i++) {
+        batched.insert(keys_[i], static_cast<int>(i));
+        scalar.insert(keys_[i], static_cast<int>(i));
+    }
+    std::vector<const int*> out(probes_.size());
+    std::size_t found_scalar{0}, found_batch{0};
+    ctx.measure(name_ + "_retrieve_many_scalar", probes_.size(), [&] {
+        found_scalar += scalar.retrieve_many(probes_.data(), probes_.size(), out.data());
+    });
+    ctx.measure(name_ + "_retrieve_many_batch", probes_.size(), [&] {
+        found_batch += batched.retrieve_many(probes_.data(), probes_.size(), out.data());
+    });
+    std::ostringstream oss;
+    oss << "found scalar=" << found_scalar << " batch=" << found_batch;
+    ctx.note("check_" + name_, oss.str());
+}
+}  // namespace
+
+BENCH_CASE(batch_hash) {
+    auto n = ctx.size(4000000);
+    std::mt19937_64 rng(1);
+
+    std::vector<int> ints(n);
+    for (auto& k : ints) k = static_cast<int>(rng());
+    hash_only<ac::IntBatchHash<int> >(ctx, "int32", ints);
+    std::vector<std::int64_t> longs(n);
+    for (auto& k : longs) k = static_cast<std::int64_t>(rng());
+    hash_only<ac::IntBatchHash<std::int64_t> >(ctx, "int64", longs);
+    auto codes = make_codes(n);
+    hash_only<ac::FixedStringBatchHash<16> >(ctx, "code16", codes);
+
+    // A table that stays in cache, where hashing is most of a lookup, and one that does not.
+    for (std::size_t table_size : {std::size_t{16384}, n}) {
+        auto tag = table_size == n ? std::string("large") : std::string("small");
+        std::vector<int> int_keys(ints.begin(), ints.begin() + table_size), int_probes(n);
+        for (auto& p : int_probes) p = int_keys[rng() % table_size];
+        lookups<ac::IntBatchHash<int> >(ctx, "int32_" + tag, int_keys, int_probes);
+
+        std::vector<Code> code_keys(codes.begin(), codes.begin() + table_size), code_probes(n);
+        for (auto& p : code_probes) p = code_keys[rng() % table_size];
+        lookups<ac::FixedStringBatchHash<16> >(ctx, "code16_" + tag, code_keys, code_probes);
+    }
+}
@@ -0,0 +1,80 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Analytics over a columnar snapshot, scalar and AVX2, against the same aggregations iterating the table.
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include "../driver/account.h"
+#include "../driver/account_columns.h"
+#include "../driver/account_gen.h"
+#include "../include/hashtbl.h"
+#include "bench.h"
+
+namespace {
+using AcctTable = ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual>;
+
+bool close(double a_, double b_) { return std::fabs(a_ - b_) <= 1e-9 * std::fabs(b_) + 1e-6; }
+}  // namespace
+
+BENCH_CASE(columnar_scan) {
+    auto n = ctx.size(2000000);
+    AccountGenerator gen(1);
+    AcctTable table;
+    for (std::size_t i{0}; i < n; i++) {
+        auto a = gen.next();
+        table.insert(a.getKey(), a);
+    }
+
+    AccountColumns cols;
+    ctx.measure("snapshot", n, [&] { cols = snapshot_columns(table); });
+
+    // Filtered sum: the balance held by one bank.
+    const int bank = 237;
+    double table_sum{0}, scalar_sum{0}, simd_sum{0};
+    ctx.measure("sum_bank_table", n, [&] {
+        table_sum = 0;
+        table.for_each([&](const Account::AcctKey&, const Account& a) {
+            if (a.m_bank_code == bank) table_sum += a.m_balance;
+        });
+    });
+    ctx.measure("sum_bank_scalar", n, [&] { scalar_sum = sum_balance(cols, bank, Isa::scalar); });
+    ctx.measure("sum_bank_avx2", n, [&] { simd_sum = sum_balance(cols, bank, Isa::avx2); });
+
+    // Filtered count: accounts holding less than 100.
+    std::size_t table_count{0}, scalar_count{0}, simd_count{0};
+    ctx.measure("count_low_table", n, [&] {
+        table_count = 0;
+        table.for_each([&](const Account::AcctKey&, const Account& a) {
+            table_count += (a.m_balance >= 0.f and a.m_balance < 100.f);
+        });
+    });
+    ctx.measure("count_low_scalar", n, [&] { scalar_count = count_balance(cols, 0.f, 100.f, Isa::scalar); });
+    ctx.measure("count_low_avx2", n, [&] { simd_count = count_balance(cols, 0.f, 100.f, Isa::avx2); });
+
+    // Group-by: total balance and accounts of every bank. With this many banks totals_by_bank() runs its scalar loop
+    // even when asked for AVX2, so the two lines should match.
+    std::vector<double> table_totals(cols.bank_codes.size());
+    BankTotals scalar_totals, simd_totals;
+    ctx.measure("per_bank_table", n, [&] {
+        std::vector<double> by_code(1024, 0.0);
+        table.for_each([&](const Account::AcctKey&, const Account& a) {
+            by_code[static_cast<std::size_t>(a.m_bank_code) % by_code.size()] += a.m_balance;
+        });
+        for (std::size_t g{0}; g < cols.bank_codes.size(); g++) table_totals[g] = by_code[cols.bank_codes[g]];
+    });
+    ctx.measure("per_bank_scalar", n, [&] { scalar_totals = totals_by_bank(cols, Isa::scalar); });
+    ctx.measure("per_bank_avx2", n, [&] { simd_totals = totals_by_bank(cols, Isa::avx2); });
+
+    bool same = close(scalar_sum, table_sum) and close(simd_sum, table_sum) and scalar_count == table_count and
+                simd_count == table_count;
+    for (std::size_t g{0}; g < cols.bank_codes.size(); g++)
+        same = same and close(scalar_totals.sum[g], table_totals[g]) and close(simd_totals.sum[g], table_totals[g]) and
+               scalar_totals.count[g] == simd_totals.count[g];
+
+    std::ostringstream oss;
+    oss << "banks=" << cols.bank_codes.size() << " avx2=" << (isa_supported(Isa::avx2) ? "yes" : "no (scalar)")
+        << " same_answer=" << (same ? "yes" : "no");
+    ctx.note("check", oss.str());
+}
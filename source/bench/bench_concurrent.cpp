@@ -0,0 +1,238 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Concurrent account updates: transfers through a HashTbl behind one mutex against ConcurrentHashTbl::transact(), and
+// read-compute-write cycles under the stripe lock against optimistic ones on version stamps, a table filled from
+// empty by many writers against one sized beforehand, and skewed reads with and without a per-thread front cache.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+
+#include "../include/concurrent_hashtbl.h"
+#include "../include/front_cache.h"
+#include "../include/hash_utils.h"
+#include "../include/hashtbl.h"
+#include "../include/latency_histogram.h"
+#include "../include/thread_pool.h"
+#include "bench.h"
+
+namespace {
+/// Balance in cents: integer, so the total must come out exact.
+using Cents = long long;
+
+/// The pair of accounts and the amount of transfer i, the same whatever the strategy and the thread running it.
+struct Transfer {
+    int from, to;
+    Cents amount;
+};
+Transfer transfer(std::size_t i_, int accounts_) {
+    // Counter-based: three mixes of i_ instead of a generator whose state would have to be shared or seeded.
+    Transfer t;
+    t.from = static_cast<int>(ac::hash_mix(3 * i_) % accounts_);
+    t.to = static_cast<int>(ac::hash_mix(3 * i_ + 1) % accounts_);
+    t.amount = static_cast<Cents>(ac::hash_mix(3 * i_ + 2) % 10000);
+    return t;
+}
+}  // namespace
+
+BENCH_CASE(transfers) {
+    // Many accounts against a few threads: two transfers rarely meet on a stripe, let alone on an account.
+    auto accounts = static_cast<int>(ctx.size(1000000));
+    const std::size_t n_transfers = 4000000;
+    const Cents opening = 100000;
+    ac::ThreadPool pool(ctx.threads());
+
+    ac::HashTbl<int, Cents> table;
+    std::mutex table_lock;
+    ac::ConcurrentHashTbl<int, Cents> striped(2 * static_cast<std::size_t>(accounts), 1024);
+    for (int i{0}; i < accounts; i++) {
+        table.insert(i, opening);
+        striped.insert(i, opening);
+    }
+
+    ctx.measure("global_mutex", n_transfers, [&] {
+        pool.parallel_for(0, n_transfers, 0, [&](std::size_t lo_, std::size_t hi_, unsigned) {
+            for (auto i{lo_}; i < hi_; i++) {
+                auto t = transfer(i, accounts);
+                std::lock_guard<std::mutex> guard(table_lock);
+                auto from = table.find(t.from);
+                auto to = table.find(t.to);
+                *from -= t.amount;
+                *to += t.amount;
+            }
+        });
+    });
+    ctx.measure("striped_transact", n_transfers, [&] {
+        pool.parallel_for(0, n_transfers, 0, [&](std::size_t lo_, std::size_t hi_, unsigned) {
+            for (auto i{lo_}; i < hi_; i++) {
+                auto t = transfer(i, accounts);
+                striped.transact(t.from, t.to, [&](Cents& from, Cents& to) {
+                    from -= t.amount;
+                    to += t.amount;
+                });
+            }
+        });
+    });
+
+    Cents table_total{0}, striped_total{0};
+    table.for_each([&](const int&, const Cents& b) { table_total += b; });
+    striped.for_each([&](const int&, const Cents& b) { striped_total += b; });
+    std::ostringstream oss;
+    oss << "threads=" << pool.size() << " stripes=" << striped.stripe_count() << " totals_kept="
+        << (table_total == opening * accounts and striped_total == opening * accounts ? "yes" : "no");
+    ctx.note("check", oss.str());
+}
+
+namespace {
+/// Stands for the computation a service does between reading an account and writing it back: some fee or interest,
+/// about a hundred nanoseconds of arithmetic on the balance.
+Cents recompute(Cents balance_) {
+    std::uint64_t x = static_cast<std::uint64_t>(balance_);
+    for (int i{0}; i < 16; i++) x = ac::hash_mix(x);
+    return balance_ + static_cast<Cents>(x % 3) - 1;
+}
+}  // namespace
+
+BENCH_CASE(optimistic_updates) {
+    // A few hot accounts take all the updates, so that concurrent cycles on the same one actually meet. At least four
+    // threads even on a small machine: there, conflicts come from a thread preempted in the middle of its cycle.
+    auto hot = ctx.size(64);
+    const std::size_t n_updates = 2000000;
+    ac::ThreadPool pool(std::max(4u, ctx.threads()));
+    ac::ConcurrentHashTbl<std::size_t, Cents, std::hash<std::size_t>, std::equal_to<std::size_t>, true> accounts;
+    for (std::size_t k{0}; k < hot; k++) accounts.insert(k, 100000);
+
+    ctx.measure("locked_update", n_updates, [&] {
+        // Pessimistic: the computation runs under the stripe lock.
+        pool.parallel_for(0, n_updates, 0, [&](std::size_t lo_, std::size_t hi_, unsigned) {
+            for (auto i{lo_}; i < hi_; i++) accounts.update(ac::hash_mix(i) % hot, [](Cents& b) { b = recompute(b); });
+        });
+    });
+    std::atomic<std::size_t> retries{0};
+    // A reader handle per worker, each made and used by its own thread.
+    std::vector<std::unique_ptr<ac::EpochDomain::Handle> > readers(pool.size());
+    ctx.measure("optimistic_update", n_updates, [&] {
+        // Optimistic: read a copy and its version, compute unlocked, write back only if nobody wrote meanwhile.
+        pool.parallel_for(0, n_updates, 0, [&](std::size_t lo_, std::size_t hi_, unsigned worker_) {
+            if (!readers[worker_]) readers[worker_].reset(new ac::EpochDomain::Handle(accounts.epochs()));
+            std::size_t failed{0};
+            for (auto i{lo_}; i < hi_; i++) {
+                auto key = ac::hash_mix(i) % hot;
+                for (;;) {
+                    Cents copy;
+                    auto version = accounts.retrieve_versioned(key, copy, *readers[worker_]);
+                    Cents updated = recompute(copy);
+                    if (accounts.compare_and_update(key, version, [&](Cents& b) { b = updated; })) break;
+                    failed++;
+                }
+            }
+            retries += failed;
+        });
+    });
+
+    std::ostringstream oss;
+    oss << "threads=" << pool.size() << " hot_keys=" << hot << " retries_per_update="
+        << static_cast<double>(retries.load()) / n_updates;
+    ctx.note("check", oss.str());
+}
+
+BENCH_CASE(concurrent_growth) {
+    // 32 writers fill a table from its initial 1024 buckets: it doubles 12 times on the way, each time while the
+    // writers keep inserting. --n 100000000 for the size the targets are set for, memory permitting (about 6GB).
+    auto n = ctx.size(4000000);
+    ac::ThreadPool pool(std::max(32u, ctx.threads()));
+    auto fill = [&](ac::ConcurrentHashTbl<std::uint64_t, std::uint64_t>& table_, ac::LatencyHistogram& lat_) {
+        pool.parallel_for(0, n, 0, [&](std::size_t lo_, std::size_t hi_, unsigned) {
+            for (auto i{lo_}; i < hi_; i++) ac::timed(lat_, [&] { return table_.insert(ac::hash_mix(i), i); });
+        });
+    };
+
+    ac::LatencyHistogram grow_lat, presized_lat;
+    std::size_t grown_size{0}, buckets{0};
+    ctx.measure("grow_from_empty", n, [&] {
+        ac::ConcurrentHashTbl<std::uint64_t, std::uint64_t> table(1024, 1024);
+        fill(table, grow_lat);
+        grown_size = table.size();
+        buckets = table.bucket_count();
+    });
+    ctx.measure("presized", n, [&] {
+        ac::ConcurrentHashTbl<std::uint64_t, std::uint64_t> table(2 * n, 1024);
+        fill(table, presized_lat);
+    });
+    ctx.record_latency("grow_insert", grow_lat);
+    ctx.record_latency("presized_insert", presized_lat);
+
+    std::ostringstream oss;
+    oss << "threads=" << pool.size() << " size=" << grown_size << " (expected " << n << ") buckets=" << buckets
+        << " max_pause_us grow=" << grow_lat.max() / 1000 << " presized=" << presized_lat.max() / 1000;
+    ctx.note("check", oss.str());
+}
+
+namespace {
+/// n_ draws of account numbers in [0, accounts_) from a Zipf distribution of exponent s_: account k is read in
+/// proportion to 1 / (k + 1)^s_, so a few thousand accounts take most of the reads.
+std::vector<int> zipf_keys(std::size_t n_, int accounts_, double s_) {
+    std::vector<double> cdf(accounts_);
+    double total{0};
+    for (int k{0}; k < accounts_; k++) cdf[k] = total += 1.0 / std::pow(k + 1.0, s_);
+    std::mt19937_64 rng(23);
+    std::uniform_real_distribution<double> u(0, total);
+    std::vector<int> keys(n_);
+    for (auto& k : keys) k = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin());
+    return keys;
+}
+}  // namespace
+
+BENCH_CASE(front_cache) {
+    // Zipfian reads over a million accounts, by every thread; one operation in a thousand is a deposit. With s = 0.99
+    // the 16K hottest accounts take about 70% of the reads; with s = 1.2, over 90%.
+    auto accounts = static_cast<int>(ctx.size(1000000));
+    const std::size_t n_reads = 8000000, slots = 16384;
+    ac::ThreadPool pool(std::max(4u, ctx.threads()));
+    using Table = ac::ConcurrentHashTbl<int, Cents>;
+    Table table(2 * static_cast<std::size_t>(accounts), 1024);
+    for (int i{0}; i < accounts; i++) table.insert(i, 100000);
+
+    std::ostringstream oss;
+    oss << "threads=" << pool.size() << " slots=" << slots << " hit_ratio";
+    for (double s : {0.99, 1.2}) {
+        auto keys = zipf_keys(n_reads, accounts, s);
+        // A cache per worker, kept from one chunk of work to the next as a thread-local one would be.
+        std::vector<std::unique_ptr<ac::FrontCache<Table> > > caches(pool.size());
+        for (auto& c : caches) c.reset(new ac::FrontCache<Table>(table, slots));
+        auto run = [&](bool cached_) {
+            pool.parallel_for(0, n_reads, 0, [&](std::size_t lo_, std::size_t hi_, unsigned worker_) {
+                auto& cache = *caches[worker_];
+                Cents sum{0}, b;
+                for (auto i{lo_}; i < hi_; i++) {
+                    if (i % 1000 == 0) {
+                        table.update(keys[i], [](Cents& c) { c += 100; });
+                    } else {
+                        sum += cached_ ? (cache.retrieve(keys[i], b), b) : (table.retrieve(keys[i], b), b);
+                    }
+                }
+                bench::do_not_optimize(sum);
+            });
+        };
+
+        std::string zipf = s < 1 ? "zipf0.99" : "zipf1.2";
+        ctx.measure(zipf + "_shared_table", n_reads, [&] { run(false); });
+        run(true);  // Warms the caches, as a long-running service has them.
+        for (auto& c : caches) c->clear();
+        ctx.measure(zipf + "_front_cache", n_reads, [&] { run(true); });
+
+        std::size_t hits{0}, misses{0};
+        for (auto& c : caches) {
+            hits += c->hits();
+            misses += c->misses();
+        }
+        oss << " " << zipf << "=" << static_cast<double>(hits) / (hits + misses);
+    }
+    ctx.note("check", oss.str());
+}
@@ -0,0 +1,100 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Streaming deduplication of transaction ids: a HashTbl of every id seen against the windowed fingerprint filter.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "../include/dedup_filter.h"
+#include "../include/hashtbl.h"
+#include "bench.h"
+
+namespace {
+/// An id stream where one id in five repeats one of the last `recent` new ids.
+struct IdStream {
+    std::vector<std::uint64_t> ids;
+    std::vector<std::size_t> first;  //!< Position of the first occurrence of ids[i]; i itself for a new id.
+};
+
+IdStream make_stream(std::size_t n_, std::size_t recent_) {
+    std::mt19937_64 rng(17);
+    IdStream s;
+    s.ids.reserve(n_);
+    s.first.reserve(n_);
+    std::vector<std::size_t> position;  // Of each new id, by sequence number.
+    std::uint64_t next_id{0};
+    for (std::size_t i{0}; i < n_; i++) {
+        bool repeat = next_id > recent_ and rng() % 5 == 0;
+        // Fresh ids are sequence numbers scrambled by an odd multiplier, as ids from several sources would look. A
+        // repeat refers to a first occurrence, not to an earlier repeat: a filter does not refresh the ids it rejects,
+        // so chains of repeats would drift out of the window.
+        auto seq = repeat ? next_id - 1 - rng() % recent_ : next_id++;
+        if (!repeat) position.push_back(i);
+        s.ids.push_back((seq + 1) * UINT64_C(0x9e3779b97f4a7c15));
+        s.first.push_back(position[seq]);
+    }
+    return s;
+}
+
+/// Counts the answers of a filter that disagree with the truth.
+template <class Filter>
+std::string accuracy(const IdStream& s_, const std::vector<char>& fresh_, const Filter& f_) {
+    std::size_t false_pos{0}, false_neg{0}, fresh{0};
+    for (std::size_t i{0}; i < s_.ids.size(); i++) {
+        bool is_new = s_.first[i] == i;
+        fresh += is_new;
+        false_pos += is_new and !fresh_[i];  // New id rejected as a duplicate.
+        // Duplicate let through. A repeat of a false positive does not count: that id was never stored, so once the id
+        // it collided with expires, the repeat is rightly taken as new.
+        false_neg += !is_new and fresh_[i] and fresh_[s_.first[i]];
+    }
+    std::ostringstream oss;
+    oss << "mem=" << f_.memory_bytes() / (1 << 20) << "MB fp_rate=" << static_cast<double>(false_pos) / fresh
+        << " (expected " << f_.expected_false_positive_rate() << ") missed_dups=" << false_neg
+        << " evictions=" << f_.evictions();
+    return oss.str();
+}
+}  // namespace
+
+BENCH_CASE(dedup_stream) {
+    // --n 100000000 for a stream of the size the targets are set for.
+    auto n = ctx.size(20000000);
+    const std::size_t per_generation = 1 << 20, window = 4;
+    // Repeats reach back at most two generations, well inside the window.
+    auto stream = make_stream(n, 2 * per_generation);
+    std::vector<char> fresh(n);
+
+    // Today: a table of every id ever seen. A prefix of the stream is enough to see its cost per id.
+    std::size_t table_ids = std::min<std::size_t>(n, 5000000);
+    std::size_t table_new{0};
+    ctx.measure("hashtbl", table_ids, [&] {
+        ac::HashTbl<std::uint64_t, bool> seen;
+        table_new = 0;
+        for (std::size_t i{0}; i < table_ids; i++) table_new += seen.insert(stream.ids[i], true);
+    });
+
+    std::string acc16, acc32;
+    ctx.measure("filter16_insert", n, [&] {
+        ac::DedupFilter<std::uint16_t> seen(per_generation, window);
+        for (std::size_t i{0}; i < n; i++) fresh[i] = seen.insert(stream.ids[i]);
+    });
+    // The filters are kept past their measure, to check their answers outside of the timing.
+    std::unique_ptr<ac::DedupFilter<std::uint16_t> > seen16;
+    ctx.measure("filter16_batch", n, [&] {
+        seen16.reset(new ac::DedupFilter<std::uint16_t>(per_generation, window));
+        seen16->insert_batch(stream.ids.data(), n, reinterpret_cast<bool*>(fresh.data()));
+    });
+    acc16 = accuracy(stream, fresh, *seen16);
+    std::unique_ptr<ac::DedupFilter<std::uint32_t> > seen32;
+    ctx.measure("filter32_batch", n, [&] {
+        seen32.reset(new ac::DedupFilter<std::uint32_t>(per_generation, window));
+        seen32->insert_batch(stream.ids.data(), n, reinterpret_cast<bool*>(fresh.data()));
+    });
+    acc32 = accuracy(stream, fresh, *seen32);
+    ctx.note("check_16", acc16);
+    ctx.note("check_32", acc32);
+}
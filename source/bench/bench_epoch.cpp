@@ -0,0 +1,100 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Epoch-based reclamation: what a read-side section costs under each protection scheme, and what retiring costs
+// when readers and writers share one node.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+
+#include "../include/epoch_reclaim.h"
+#include "../include/hash_utils.h"
+#include "../include/thread_pool.h"
+#include "bench.h"
+
+namespace {
+struct Node {
+    std::uint64_t value;
+};
+}  // namespace
+
+BENCH_CASE(epoch_read_overhead) {
+    // Each operation is one read-side section around one load of a shared node: the cost of the section itself.
+    auto n = ctx.size(20000000);
+    ac::EpochDomain domain;
+    ac::EpochDomain::Handle h(domain);
+    std::atomic<Node*> shared(new Node{7});
+    std::mutex lock;
+    std::uint64_t sum{0};
+
+    ctx.measure("unprotected", n, [&] {
+        for (std::size_t i{0}; i < n; i++) sum += shared.load(std::memory_order_acquire)->value;
+    });
+    ctx.measure("epoch_pin", n, [&] {
+        for (std::size_t i{0}; i < n; i++) {
+            auto guard = h.pin();
+            sum += shared.load(std::memory_order_acquire)->value;
+        }
+    });
+    ctx.measure("epoch_nested_pin", n, [&] {
+        // Under an outer section, as a lookup called from a batch that already pinned.
+        auto outer = h.pin();
+        for (std::size_t i{0}; i < n; i++) {
+            auto guard = h.pin();
+            sum += shared.load(std::memory_order_acquire)->value;
+        }
+    });
+    ctx.measure("hazard_pointer", n, [&] {
+        for (std::size_t i{0}; i < n; i++) {
+            sum += h.protect(0, shared)->value;
+            h.release(0);
+        }
+    });
+    ctx.measure("mutex", n, [&] {
+        for (std::size_t i{0}; i < n; i++) {
+            std::lock_guard<std::mutex> guard(lock);
+            sum += shared.load(std::memory_order_relaxed)->value;
+        }
+    });
+    bench::do_not_optimize(sum);
+    delete shared.load();
+}
+
+BENCH_CASE(epoch_retire) {
+    // Every thread reads the shared node in a pinned section, and every 8th operation replaces it and retires the old
+    // one: retiring, collecting and freeing, with readers in the way.
+    auto n = ctx.size(8000000);
+    ac::ThreadPool pool(std::max(4u, ctx.threads()));
+    ac::EpochDomain domain;
+    std::atomic<Node*> shared(new Node{0});
+    std::atomic<std::size_t> peak_pending{0};
+
+    ctx.measure("read_and_retire", n, [&] {
+        pool.parallel_for(0, n, 0, [&](std::size_t lo_, std::size_t hi_, unsigned) {
+            ac::EpochDomain::Handle h(domain);
+            std::uint64_t sum{0};
+            std::size_t peak{0};
+            for (auto i{lo_}; i < hi_; i++) {
+                if (ac::hash_mix(i) % 8 == 0) {
+                    h.retire(shared.exchange(new Node{i}));
+                    peak = std::max(peak, h.pending());
+                } else {
+                    auto guard = h.pin();
+                    sum += shared.load(std::memory_order_acquire)->value;
+                }
+            }
+            bench::do_not_optimize(sum);
+            std::size_t seen = peak_pending.load();
+            while (peak > seen and !peak_pending.compare_exchange_weak(seen, peak)) {
+            }
+        });
+    });
+
+    std::ostringstream oss;
+    oss << "threads=" << pool.size() << " freed=" << domain.freed() << " epoch=" << domain.epoch()
+        << " peak_pending_per_thread=" << peak_pending.load();
+    ctx.note("check", oss.str());
+    delete shared.load();
+}
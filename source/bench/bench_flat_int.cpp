@@ -0,0 +1,83 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Integer keys: the generic chained HashTbl<int, int> (std::hash<int>) against the open-addressing FlatIntHashTbl,
+// single-threaded and in its concurrent (CAS insert) mode.
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "../include/flat_int_hashtbl.h"
+#include "../include/hashtbl.h"
+#include "../include/thread_pool.h"
+#include "bench.h"
+
+namespace {
+/// Distinct pseudo-random int keys, in random order.
+std::vector<int> distinct_keys(std::size_t n_, std::uint64_t seed_) {
+    std::vector<int> keys(n_);
+    for (std::size_t i{0}; i < n_; i++) keys[i] = static_cast<int>((i * 2654435761u) & 0x7fffffffu);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(seed_));
+    return keys;
+}
+
+/// Inserts keys_ into table_, then looks them up in another order (lookups_), then looks up the absent keys missing_.
+template <class Table>
+void insert_and_retrieve(bench::Context& ctx, const std::string& name_, Table& table_, const std::vector<int>& keys_,
+                         const std::vector<int>& lookups_, const std::vector<int>& missing_) {
+    ctx.measure(name_ + "_insert", keys_.size(), [&] {
+        for (auto k : keys_) table_.insert(k, k);
+    });
+    long long sum{0};
+    ctx.measure(name_ + "_retrieve_hit", lookups_.size(), [&] {
+        int v;
+        for (auto k : lookups_)
+            if (table_.retrieve(k, v)) sum += v;
+    });
+    ctx.measure(name_ + "_retrieve_miss", missing_.size(), [&] {
+        int v;
+        for (auto k : missing_)
+            if (table_.retrieve(k, v)) sum += v;
+    });
+    bench::do_not_optimize(sum);
+}
+}  // namespace
+
+BENCH_CASE(flat_int) {
+    auto n = ctx.size(4000000);
+    auto keys = distinct_keys(2 * n, 1);
+    std::vector<int> missing(keys.begin() + n, keys.end());
+    keys.resize(n);
+    auto lookups = keys;
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937_64(3));
+
+    {
+        ac::HashTbl<int, int> chained;
+        insert_and_retrieve(ctx, "chained", chained, keys, lookups, missing);
+    }
+    {
+        ac::FlatIntHashTbl<int, int> flat;
+        insert_and_retrieve(ctx, "flat", flat, keys, lookups, missing);
+    }
+    {
+        ac::FlatIntHashTbl<int, int> flat(n);
+        insert_and_retrieve(ctx, "flat_presized", flat, keys, lookups, missing);
+    }
+    {
+        ac::FlatIntHashTbl<int, int, true> flat(n);
+        insert_and_retrieve(ctx, "flat_concurrent", flat, keys, lookups, missing);
+    }
+
+    // Every worker inserts into the same concurrent table at once.
+    ac::ThreadPool pool(ctx.threads());
+    ac::FlatIntHashTbl<int, int, true> shared(n);
+    ctx.measure("flat_concurrent_parallel_insert", n, [&] {
+        pool.parallel_for(0, n, 0, [&](std::size_t lo_, std::size_t hi_, unsigned) {
+            for (auto i{lo_}; i < hi_; i++) shared.insert(keys[i], keys[i]);
+        });
+    });
+    std::ostringstream oss;
+    oss << "threads=" << pool.size() << " size=" << shared.size() << " (expected " << n << ")";
+    ctx.note("check", oss.str());
+}
@@ -0,0 +1,151 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Core HashTbl operations.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "../driver/account.h"
+#include "../driver/account_gen.h"
+#include "../include/hashtbl.h"
+#include "../include/latency_histogram.h"
+#include "../include/thread_pool.h"
+#include "bench.h"
+
+namespace {
+/// Distinct pseudo-random int keys, in random order.
+std::vector<int> random_keys(std::size_t n_, std::uint64_t seed_) {
+    std::vector<int> keys(n_);
+    for (std::size_t i{0}; i < n_; i++) keys[i] = static_cast<int>((i * 2654435761u) & 0x7fffffffu);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(seed_));
+    return keys;
+}
+}  // namespace
+
+BENCH_CASE(hashtbl_int) {
+    auto n = ctx.size(1000000);
+    auto keys = random_keys(n, 1);
+
+    ac::HashTbl<int, int> table;
+    ctx.measure("insert", n, [&] {
+        for (auto k : keys) table.insert(k, k);
+    });
+
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(3));
+    long long sum{0};
+    ctx.measure("retrieve_hit", n, [&] {
+        int v;
+        for (auto k : keys)
+            if (table.retrieve(k, v)) sum += v;
+    });
+    ctx.measure("retrieve_miss", n, [&] {
+        int v;
+        for (auto k : keys)  // Keys are non-negative, so their negatives are never in the table.
+            if (table.retrieve(-1 - k, v)) sum += v;
+    });
+    ctx.measure("operator[]", n, [&] {
+        for (auto k : keys) sum += table[k];
+    });
+    ctx.measure("erase", n, [&] {
+        for (auto k : keys) sum += table.erase(k);
+    });
+    bench::do_not_optimize(sum);
+}
+
+BENCH_CASE(hashtbl_acct) {
+    auto n = ctx.size(500000);
+    AccountGenerator gen(1);
+    auto accounts = gen.generate(n);
+    std::vector<Account::AcctKey> keys;
+    for (const auto& a : accounts) keys.push_back(a.getKey());
+
+    ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual> table;
+    ctx.measure("insert", n, [&] {
+        for (std::size_t i{0}; i < n; i++) table.insert(keys[i], accounts[i]);
+    });
+
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(3));
+    double sum{0};
+    ctx.measure("retrieve_hit", n, [&] {
+        Account a;
+        for (const auto& k : keys)
+            if (table.retrieve(k, a)) sum += a.m_balance;
+    });
+    ctx.measure("erase", n, [&] {
+        for (const auto& k : keys) sum += table.erase(k);
+    });
+    bench::do_not_optimize(sum);
+}
+
+BENCH_CASE(hashtbl_int_latency) {
+    // Per-call latency: the mean hides the rehash() pauses that show up in the tail.
+    auto n = ctx.size(1000000);
+    auto keys = random_keys(n, 1);
+
+    ac::HashTbl<int, int> table;
+    ac::LatencyHistogram insert_lat, retrieve_lat, erase_lat;
+    ctx.measure("insert", n, [&] {
+        for (auto k : keys) ac::timed(insert_lat, [&] { return table.insert(k, k); });
+    });
+    long long sum{0};
+    ctx.measure("retrieve", n, [&] {
+        int v;
+        for (auto k : keys) sum += ac::timed(retrieve_lat, [&] { return table.retrieve(k, v); });
+    });
+    ctx.measure("erase", n, [&] {
+        for (auto k : keys) sum += ac::timed(erase_lat, [&] { return table.erase(k); });
+    });
+    ctx.record_latency("insert", insert_lat);
+    ctx.record_latency("retrieve", retrieve_lat);
+    ctx.record_latency("erase", erase_lat);
+    bench::do_not_optimize(sum);
+}
+
+BENCH_CASE(hashtbl_purge) {
+    // Purging the zero-balance accounts (about 5%): key by key, as a batch of keys, and in one sweep.
+    auto n = ctx.size(500000);
+    AccountGenerator gen(1);
+    auto accounts = gen.generate(n);
+    using AcctTable = ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual>;
+    auto build = [&](AcctTable& table) {
+        for (const auto& a : accounts) table.insert(a.getKey(), a);
+    };
+    auto zero_balance = [](const Account::AcctKey&, const Account& a) { return a.m_balance == 0.f; };
+    std::size_t removed{0};
+
+    {
+        AcctTable table;
+        build(table);
+        ctx.measure("collect_then_erase", n, [&] {
+            std::vector<Account::AcctKey> doomed;
+            table.for_each([&](const Account::AcctKey& k, const Account& a) {
+                if (zero_balance(k, a)) doomed.push_back(k);
+            });
+            for (const auto& k : doomed) removed += table.erase(k);
+        });
+    }
+    {
+        AcctTable table;
+        build(table);
+        ctx.measure("collect_then_erase_range", n, [&] {
+            std::vector<Account::AcctKey> doomed;
+            table.for_each([&](const Account::AcctKey& k, const Account& a) {
+                if (zero_balance(k, a)) doomed.push_back(k);
+            });
+            removed += table.erase(doomed.begin(), doomed.end());
+        });
+    }
+    {
+        AcctTable table;
+        build(table);
+        ctx.measure("erase_if", n, [&] { removed += table.erase_if(zero_balance); });
+    }
+    {
+        AcctTable table;
+        build(table);
+        ac::ThreadPool pool(ctx.threads());
+        ctx.measure("parallel_erase_if", n, [&] { removed += table.parallel_erase_if(zero_balance, pool); });
+    }
+    bench::do_not_optimize(removed);
+}
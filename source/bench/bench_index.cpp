@@ -0,0 +1,183 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Secondary indexes: queries through IndexedHashTbl against full scans, and the upkeep cost.
+
+#include <limits>
+#include <random>
+#include <sstream>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "../driver/account.h"
+#include "../driver/account_gen.h"
+#include "../include/hashtbl.h"
+#include "../include/indexed_hashtbl.h"
+#include "../include/ordered_index.h"
+#include "../include/prefix_index.h"
+#include "bench.h"
+
+namespace {
+using AcctTable = ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual>;
+using AcctIndexed = ac::IndexedHashTbl<Account::AcctKey, Account, KeyHash, KeyEqual>;
+
+int bank_of(const Account& a_) { return a_.m_bank_code; }
+std::pair<int, int> branch_of(const Account& a_) { return std::make_pair(a_.m_bank_code, a_.m_branch_code); }
+std::string name_of(const Account& a_) { return a_.m_name; }
+std::tuple<int, int, int> number_of(const Account& a_) {
+    return std::make_tuple(a_.m_bank_code, a_.m_branch_code, a_.m_number);
+}
+}  // namespace
+
+BENCH_CASE(index_queries) {
+    auto n = ctx.size(1000000);
+    AccountGenerator gen(1);
+    auto accounts = gen.generate(n);
+
+    // Branches to ask for, taken from real accounts so every query finds something.
+    std::mt19937_64 rng(7);
+    std::vector<std::pair<int, int> > queries;
+    for (int q{0}; q < 20; q++) queries.push_back(branch_of(accounts[rng() % n]));
+
+    AcctTable plain;
+    ctx.measure("insert_plain", n, [&] {
+        for (const auto& a : accounts) plain.insert(a.getKey(), a);
+    });
+
+    AcctIndexed indexed;
+    auto& by_bank = indexed.add_index(bank_of);
+    auto& by_branch = indexed.add_index(branch_of, ac::PairHash());
+    auto& by_name = indexed.add_index(name_of);
+    ctx.measure("insert_3_indexes", n, [&] {
+        for (const auto& a : accounts) indexed.insert(a.getKey(), a);
+    });
+
+    // Both answers are consumed so the work cannot be skipped; the op count is the number of queries.
+    std::size_t scan_hits{0}, index_hits{0};
+    double sum{0};
+    ctx.measure("branch_query_scan", queries.size(), [&] {
+        for (const auto& q : queries)
+            plain.for_each([&](const Account::AcctKey&, const Account& a) {
+                if (a.m_bank_code == q.first and a.m_branch_code == q.second) {
+                    sum += a.m_balance;
+                    scan_hits++;
+                }
+            });
+    });
+    ctx.measure("branch_query_index", queries.size(), [&] {
+        for (const auto& q : queries)
+            for (auto a : by_branch.find(q)) {
+                sum += a->m_balance;
+                index_hits++;
+            }
+    });
+    bench::do_not_optimize(sum);
+
+    std::ostringstream oss;
+    oss << "banks=" << by_bank.distinct() << " branches=" << by_branch.distinct() << " names=" << by_name.distinct()
+        << " hits/query=" << index_hits / queries.size() << " same_answer=" << (scan_hits == index_hits ? "yes" : "no");
+    ctx.note("check", oss.str());
+}
+
+BENCH_CASE(range_queries) {
+    // Auditor queries: the accounts of a branch within a band of account numbers (a quarter of the number space).
+    auto n = ctx.size(1000000);
+    AccountGenerator gen(1);
+    auto accounts = gen.generate(n);
+    AcctIndexed indexed;
+    for (const auto& a : accounts) indexed.insert(a.getKey(), a);
+
+    std::mt19937_64 rng(11);
+    std::vector<std::pair<std::tuple<int, int, int>, std::tuple<int, int, int> > > queries;
+    for (int q{0}; q < 20; q++) {
+        const auto& a = accounts[rng() % n];
+        int lo = static_cast<int>(rng() % (3u << 29));
+        queries.emplace_back(std::make_tuple(a.m_bank_code, a.m_branch_code, lo),
+                             std::make_tuple(a.m_bank_code, a.m_branch_code, lo + (1 << 29)));
+    }
+
+    ac::OrderedIndex<Account, decltype(&number_of)>* by_number{nullptr};
+    ctx.measure("attach_index", n, [&] { by_number = &indexed.add_ordered_index(&number_of); });
+
+    std::size_t scan_hits{0}, index_hits{0};
+    double sum{0};
+    ctx.measure("range_query_scan", queries.size(), [&] {
+        for (const auto& q : queries)
+            indexed.primary().for_each([&](const Account::AcctKey&, const Account& a) {
+                auto k = number_of(a);
+                if (!(k < q.first) and !(q.second < k)) {
+                    sum += a.m_balance;
+                    scan_hits++;
+                }
+            });
+    });
+    ctx.measure("range_query_index", queries.size(), [&] {
+        for (const auto& q : queries)
+            for (auto a : by_number->range(q.first, q.second)) {
+                sum += a->m_balance;
+                index_hits++;
+            }
+    });
+
+    // A whole bank in number order: the cost per value of streaming a long range.
+    std::size_t streamed{0};
+    auto lo = std::make_tuple(1, 0, 0);
+    auto hi = std::make_tuple(1, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
+    for (auto a : by_number->range(lo, hi)) streamed += a != nullptr;
+    ctx.measure("range_stream_per_value", streamed, [&] {
+        for (auto a : by_number->range(lo, hi)) sum += a->m_balance;
+    });
+    bench::do_not_optimize(sum);
+
+    std::ostringstream oss;
+    oss << "hits/query=" << index_hits / queries.size() << " bank1=" << streamed
+        << " same_answer=" << (scan_hits == index_hits ? "yes" : "no");
+    ctx.note("check", oss.str());
+}
+
+BENCH_CASE(prefix_queries) {
+    // Customer service: the clients whose name starts with what was typed so far. Run with --n 10000000 for the
+    // full-size table.
+    auto n = ctx.size(1000000);
+    AccountGenerator gen(1);
+    auto accounts = gen.generate(n);
+    AcctIndexed indexed;
+    for (const auto& a : accounts) indexed.insert(a.getKey(), a);
+
+    // Prefixes of 1 to 8 characters of real names: from thousands of matches down to a handful.
+    std::mt19937_64 rng(13);
+    std::vector<std::string> queries;
+    for (int q{0}; q < 20; q++) queries.push_back(accounts[rng() % n].m_name.substr(0, 1 + rng() % 8));
+
+    ac::PrefixIndex<Account, decltype(&name_of)>* by_name{nullptr};
+    ctx.measure("attach_index", n, [&] { by_name = &indexed.add_prefix_index(&name_of); });
+
+    std::size_t scan_hits{0}, index_hits{0}, counted{0};
+    double sum{0};
+    ctx.measure("prefix_query_scan", queries.size(), [&] {
+        for (const auto& q : queries)
+            indexed.primary().for_each([&](const Account::AcctKey&, const Account& a) {
+                if (a.m_name.compare(0, q.size(), q) == 0) {
+                    sum += a.m_balance;
+                    scan_hits++;
+                }
+            });
+    });
+    ctx.measure("prefix_query_index", queries.size(), [&] {
+        for (const auto& q : queries)
+            index_hits += by_name->for_each_prefix(q, [&](const Account* a) { sum += a->m_balance; });
+    });
+    // What a lookup screen does: the number of matches and the first page of them.
+    ctx.measure("prefix_count_first_20", queries.size(), [&] {
+        for (const auto& q : queries) {
+            counted += by_name->count_prefix(q);
+            by_name->for_each_prefix(q, [&](const Account* a) { sum += a->m_balance; }, 20);
+        }
+    });
+    bench::do_not_optimize(sum);
+
+    std::ostringstream oss;
+    oss << "trie_nodes=" << by_name->nodes() << " hits/query=" << index_hits / queries.size()
+        << " same_answer=" << (scan_hits == index_hits and counted == index_hits ? "yes" : "no");
+    ctx.note("check", oss.str());
+}
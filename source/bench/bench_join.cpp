@@ -0,0 +1,129 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Reconciliation: joining a batch of transactions to the account table, one lookup at a time against hash_join().
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "../driver/account.h"
+#include "../driver/account_gen.h"
+#include "../include/hash_join.h"
+#include "../include/hashtbl.h"
+#include "bench.h"
+
+namespace {
+using AcctTable = ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual>;
+
+/// A movement on an account, as it arrives from the transaction stream.
+template <class Key>
+struct Transaction {
+    Key account;
+    float amount;
+};
+
+/// Builds `probes` transactions, nine in ten on stored keys and the rest on unknown ones.
+template <class Key, class Unknown>
+std::vector<Transaction<Key> > make_stream(const std::vector<Key>& keys_, std::size_t probes_, Unknown unknown_) {
+    std::mt19937_64 rng(3);
+    std::vector<Transaction<Key> > txns;
+    txns.reserve(probes_);
+    for (std::size_t i{0}; i < probes_; i++) {
+        float amount = static_cast<float>(rng() % 100000) / 100.f;
+        txns.push_back({rng() % 10 ? keys_[rng() % keys_.size()] : unknown_(i), amount});
+    }
+    return txns;
+}
+
+/// Runs the lookup strategies over the same stream and checks they agree.
+template <class Table, class Key>
+void join_all_ways(bench::Context& ctx, const Table& table_, const std::vector<Transaction<Key> >& txns_) {
+    using Txn = Transaction<Key>;
+    using Data = typename Table::mapped_type;
+    auto key_of = [](const Txn& t) -> const Key& { return t.account; };
+    std::size_t n = txns_.size();
+    std::size_t copy_hits{0}, find_hits{0}, many_hits{0}, pipe_hits{0}, part_hits{0};
+    double sum{0};
+
+    ctx.measure("retrieve_loop", n, [&] {
+        Data d;
+        for (const auto& t : txns_)
+            if (table_.retrieve(t.account, d)) {
+                sum += t.amount;
+                copy_hits++;
+            }
+    });
+    ctx.measure("find_loop", n, [&] {
+        for (const auto& t : txns_)
+            if (table_.find(t.account)) {
+                sum += t.amount;
+                find_hits++;
+            }
+    });
+    ctx.measure("retrieve_many", n, [&] {
+        // The keys have to be gathered first: retrieve_many() takes an array of them.
+        const std::size_t chunk = 4096;
+        std::vector<Key> keys(chunk);
+        std::vector<const Data*> out(chunk);
+        for (std::size_t first{0}; first < n; first += chunk) {
+            std::size_t m = std::min(chunk, n - first);
+            for (std::size_t i{0}; i < m; i++) keys[i] = txns_[first + i].account;
+            many_hits += table_.retrieve_many(keys.data(), m, out.data());
+            for (std::size_t i{0}; i < m; i++)
+                if (out[i]) sum += txns_[first + i].amount;
+        }
+    });
+    ac::JoinOptions partitioned;
+    partitioned.cache_bytes = 1u << 20;
+    ac::JoinStats stats;
+    ctx.measure("hash_join_prefetch", n, [&] {
+        stats = ac::hash_join(table_, txns_.begin(), txns_.end(), key_of,
+                              [&](const Txn& t, const Data&) { sum += t.amount; });
+        pipe_hits += stats.matches;
+    });
+    ctx.measure("hash_join_partitioned", n, [&] {
+        stats = ac::hash_join(table_, txns_.begin(), txns_.end(), key_of,
+                              [&](const Txn& t, const Data&) { sum += t.amount; }, partitioned);
+        part_hits += stats.matches;
+    });
+    bench::do_not_optimize(sum);
+
+    std::ostringstream oss;
+    oss << "partitions=" << stats.partitions << " hit_ratio=" << static_cast<double>(stats.matches) / n
+        << " same_answer="
+        << (copy_hits == find_hits and many_hits == find_hits and pipe_hits == find_hits and part_hits == find_hits
+                ? "yes"
+                : "no");
+    ctx.note("check", oss.str());
+}
+}  // namespace
+
+BENCH_CASE(join_acct) {
+    auto n = ctx.size(1000000);
+    AccountGenerator gen(1);
+    AcctTable table;
+    std::vector<Account::AcctKey> keys;
+    for (std::size_t i{0}; i < n; i++) {
+        auto a = gen.next();
+        table.insert(a.getKey(), a);
+        keys.push_back(a.getKey());
+    }
+    auto txns = make_stream(keys, 4 * n, [](std::size_t i) {
+        return Account::AcctKey("Nobody", 999, 1, static_cast<int>(i));
+    });
+    join_all_ways(ctx, table, txns);
+}
+
+BENCH_CASE(join_int) {
+    auto n = ctx.size(4000000);
+    ac::HashTbl<int, int> table;
+    std::vector<int> keys;
+    for (std::size_t i{0}; i < n; i++) {
+        int k = static_cast<int>(i * 2654435761u & 0x7fffffffu);
+        table.insert(k, static_cast<int>(i));
+        keys.push_back(k);
+    }
+    auto txns = make_stream(keys, 4 * n, [](std::size_t i) { return -1 - static_cast<int>(i); });
+    join_all_ways(ctx, table, txns);
+}
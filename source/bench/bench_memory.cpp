@@ -0,0 +1,60 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Allocations per operation and footprint, measured with CountingAllocator.
+
+#include <sstream>
+#include <vector>
+
+#include "../driver/account.h"
+#include "../driver/account_gen.h"
+#include "../include/counting_allocator.h"
+#include "../include/hashtbl.h"
+#include "bench.h"
+
+namespace {
+struct BenchTag {};
+using CountedAcctTbl = ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual, ac::NullObserver,
+                                   ac::CountingAllocator<ac::HashEntry<Account::AcctKey, Account>, BenchTag> >;
+
+/// Allocations per operation and bytes since the last reset, then resets the counters.
+std::string alloc_report(std::size_t ops_) {
+    auto& stats = ac::alloc_stats<BenchTag>();
+    std::ostringstream oss;
+    oss << "allocs/op=" << static_cast<double>(stats.allocations) / ops_
+        << " frees/op=" << static_cast<double>(stats.deallocations) / ops_ << " in_use=" << stats.bytes_in_use
+        << " peak=" << stats.peak_bytes;
+    stats.reset();
+    return oss.str();
+}
+}  // namespace
+
+BENCH_CASE(hashtbl_memory) {
+    auto n = ctx.size(500000);
+    AccountGenerator gen(1);
+    auto accounts = gen.generate(n);
+    std::vector<Account::AcctKey> keys;
+    for (const auto& a : accounts) keys.push_back(a.getKey());
+
+    ac::alloc_stats<BenchTag>().reset();
+    {
+        CountedAcctTbl table;
+        ctx.measure("insert", n, [&] {
+            for (std::size_t i{0}; i < n; i++) table.insert(keys[i], accounts[i]);
+        });
+        ctx.note("insert", alloc_report(n));
+
+        std::ostringstream mu;
+        mu << table.memory_usage() << " bytes/entry=" << table.memory_usage().total() / n;
+        ctx.note("memory_usage", mu.str());
+
+        ctx.measure("update", n, [&] {
+            for (std::size_t i{0}; i < n; i++) table.insert(keys[i], accounts[i]);
+        });
+        ctx.note("update", alloc_report(n));
+
+        ctx.measure("erase", n, [&] {
+            for (const auto& k : keys) table.erase(k);
+        });
+        ctx.note("erase", alloc_report(n));
+    }
+}
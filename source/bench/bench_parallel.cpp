@@ -0,0 +1,77 @@
+// @author: Jonas, Neylane e Selan.
+//
+// End-of-day style scans: parallel_reduce() and parallel_for_each() against the same traversal on one thread.
+
+#include <atomic>
+#include <cmath>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "../driver/account.h"
+#include "../driver/account_gen.h"
+#include "../include/hashtbl.h"
+#include "../include/thread_pool.h"
+#include "bench.h"
+
+namespace {
+using AcctTable = ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual>;
+
+/// Balance totals indexed by bank code.
+using BankTotals = std::vector<double>;
+const int max_bank_code = 1024;
+
+/// Folds one (bank, balance) pair, or a whole partial, into the totals. Moving the vector keeps the fold copy-free.
+struct AddToBank {
+    BankTotals operator()(BankTotals acc_, const std::pair<int, float>& b_) const {
+        acc_[static_cast<std::size_t>(b_.first) % max_bank_code] += b_.second;
+        return acc_;
+    }
+    BankTotals operator()(BankTotals acc_, const BankTotals& other_) const {
+        for (std::size_t i{0}; i < acc_.size(); i++) acc_[i] += other_[i];
+        return acc_;
+    }
+};
+
+BankTotals balance_per_bank(const AcctTable& table_, ac::ThreadPool& pool_) {
+    return table_.parallel_reduce(
+        BankTotals(max_bank_code, 0.0),
+        [](const Account::AcctKey&, const Account& a) { return std::make_pair(a.m_bank_code, a.m_balance); },
+        AddToBank(), pool_);
+}
+}  // namespace
+
+BENCH_CASE(parallel_balance) {
+    // 50M accounts take about 7 GB; the default keeps the case quick, --n 50000000 runs the full end-of-day size.
+    auto n = ctx.size(2000000);
+    AccountGenerator gen(1);
+    AcctTable table;
+    for (std::size_t i{0}; i < n; i++) {
+        auto a = gen.next();
+        table.insert(a.getKey(), a);
+    }
+
+    ac::ThreadPool serial(1), pool(ctx.threads());
+    BankTotals serial_totals, parallel_totals;
+    ctx.measure("per_bank_serial", n, [&] { serial_totals = balance_per_bank(table, serial); });
+    ctx.measure("per_bank_parallel", n, [&] { parallel_totals = balance_per_bank(table, pool); });
+
+    std::atomic<std::size_t> zero{0};
+    ctx.measure("for_each_zero_balance", n, [&] {
+        table.parallel_for_each(
+            [&](const Account::AcctKey&, const Account& a) {
+                if (a.m_balance == 0.f) zero.fetch_add(1, std::memory_order_relaxed);
+            },
+            pool);
+    });
+
+    // The parallel sums add in another order, so only the last digits may differ.
+    double worst{0};
+    for (int b{0}; b < max_bank_code; b++)
+        if (serial_totals[b] != 0)
+            worst = std::max(worst, std::fabs(parallel_totals[b] / serial_totals[b] - 1));
+    std::ostringstream oss;
+    oss << "threads=" << pool.size() << " zero_balance=" << zero.load() << " max_rel_diff=" << worst;
+    ctx.note("check", oss.str());
+    bench::do_not_optimize(parallel_totals);
+}
@@ -0,0 +1,213 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Regression gate: robust statistics, the JSON baseline and the comparison.
+
+#include "gate.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <iterator>
+#include <stdexcept>
+
+namespace bench {
+namespace {
+/// Scale that turns a MAD into a standard deviation estimate for normally distributed noise.
+const double MAD_TO_SIGMA = 1.4826;
+
+/**
+ * @brief Just enough of a JSON reader for the baseline: objects, strings without escapes other than \" and \\, and
+ * numbers. Anything else is an error.
+ */
+class JsonReader {
+   public:
+    explicit JsonReader(const std::string& text_) : m_text(text_), m_pos(0) {}
+
+    void expect(char c_) {
+        skip_ws();
+        if (m_pos >= m_text.size() or m_text[m_pos] != c_) fail(std::string("expected '") + c_ + "'");
+        m_pos++;
+    }
+    /// Consumes c_ if it is the next character.
+    bool accept(char c_) {
+        skip_ws();
+        if (m_pos < m_text.size() and m_text[m_pos] == c_) {
+            m_pos++;
+            return true;
+        }
+        return false;
+    }
+    std::string string() {
+        expect('"');
+        std::string s;
+        while (m_pos < m_text.size() and m_text[m_pos] != '"') {
+            if (m_text[m_pos] == '\\') m_pos++;
+            if (m_pos < m_text.size()) s += m_text[m_pos++];
+        }
+        expect('"');
+        return s;
+    }
+    double number() {
+        skip_ws();
+        auto start = m_pos;
+        while (m_pos < m_text.size() and (std::isdigit(static_cast<unsigned char>(m_text[m_pos])) or
+                                          std::string("+-.eE").find(m_text[m_pos]) != std::string::npos))
+            m_pos++;
+        try {
+            return std::stod(m_text.substr(start, m_pos - start));
+        } catch (const std::exception&) {
+            fail("expected a number");
+        }
+        return 0;
+    }
+    /// Calls field_(key) for every member of an object; field_ must consume the value.
+    template <class Fn>
+    void object(Fn field_) {
+        expect('{');
+        if (accept('}')) return;
+        do {
+            auto key = string();
+            expect(':');
+            field_(key);
+        } while (accept(','));
+        expect('}');
+    }
+    [[noreturn]] void fail(const std::string& what_) const {
+        throw std::runtime_error("baseline: " + what_ + " at offset " + std::to_string(m_pos));
+    }
+
+   private:
+    const std::string& m_text;
+    std::size_t m_pos;
+
+    void skip_ws() {
+        while (m_pos < m_text.size() and std::isspace(static_cast<unsigned char>(m_text[m_pos]))) m_pos++;
+    }
+};
+
+const char* verdict_names[] = {"ok", "improved", "REGRESSED", "new", "MISSING"};
+}  // namespace
+
+double median(std::vector<double> v_) {
+    if (v_.empty()) return 0;
+    std::sort(v_.begin(), v_.end());
+    auto mid = v_.size() / 2;
+    return v_.size() % 2 ? v_[mid] : (v_[mid - 1] + v_[mid]) / 2;
+}
+
+RobustStats robust_stats(const std::vector<double>& v_) {
+    RobustStats s;
+    s.runs = v_.size();
+    s.median = median(v_);
+    std::vector<double> dev;
+    for (auto x : v_) dev.push_back(std::fabs(x - s.median));
+    s.mad = median(dev);
+    return s;
+}
+
+Baseline summarize(const std::vector<Sample>& samples_, std::size_t n_) {
+    std::map<std::string, std::vector<double> > ns;
+    for (const auto& s : samples_) ns[s.name].push_back(s.seconds * 1e9 / std::max<std::size_t>(1, s.ops));
+    Baseline b;
+    b.n = n_;
+    for (const auto& e : ns) b.benchmarks[e.first] = robust_stats(e.second);
+    return b;
+}
+
+void write_baseline(std::ostream& os_, const Baseline& base_) {
+    os_ << "{\n  \"version\": 1,\n  \"n\": " << base_.n << ",\n  \"benchmarks\": {";
+    const char* sep = "\n";
+    for (const auto& e : base_.benchmarks) {
+        os_ << sep << "    \"" << e.first << "\": {\"median_ns\": " << std::setprecision(6) << e.second.median
+            << ", \"mad_ns\": " << e.second.mad << ", \"runs\": " << e.second.runs << "}";
+        sep = ",\n";
+    }
+    os_ << "\n  }\n}\n";
+}
+
+Baseline read_baseline(std::istream& is_) {
+    std::string text{std::istreambuf_iterator<char>(is_), std::istreambuf_iterator<char>()};
+    JsonReader json(text);
+    Baseline b;
+    json.object([&](const std::string& key) {
+        if (key == "version") {
+            if (json.number() != 1) json.fail("unsupported version");
+        } else if (key == "n") {
+            b.n = static_cast<std::size_t>(json.number());
+        } else if (key == "benchmarks") {
+            json.object([&](const std::string& name) {
+                RobustStats s;
+                json.object([&](const std::string& field) {
+                    double v = json.number();
+                    if (field == "median_ns")
+                        s.median = v;
+                    else if (field == "mad_ns")
+                        s.mad = v;
+                    else if (field == "runs")
+                        s.runs = static_cast<std::size_t>(v);
+                });
+                b.benchmarks[name] = s;
+            });
+        } else {
+            json.fail("unknown field \"" + key + "\"");
+        }
+    });
+    return b;
+}
+
+std::vector<GateResult> compare(const Baseline& base_, const Baseline& current_, double tolerance_) {
+    std::vector<GateResult> results;
+    for (const auto& e : base_.benchmarks) {
+        auto it = current_.benchmarks.find(e.first);
+        if (it == current_.benchmarks.end()) {
+            results.push_back({e.first, e.second, RobustStats(), GateResult::Verdict::missing});
+            continue;
+        }
+        const auto& cur = it->second;
+        double delta = cur.median - e.second.median;
+        double noise = 3 * MAD_TO_SIGMA * std::max(e.second.mad, cur.mad);
+        double threshold = std::max(tolerance_ * e.second.median, noise);
+        auto verdict = GateResult::Verdict::ok;
+        if (delta > threshold)
+            verdict = GateResult::Verdict::regressed;
+        else if (-delta > threshold)
+            verdict = GateResult::Verdict::improved;
+        results.push_back({e.first, e.second, cur, verdict});
+    }
+    for (const auto& e : current_.benchmarks)
+        if (!base_.benchmarks.count(e.first))
+            results.push_back({e.first, RobustStats(), e.second, GateResult::Verdict::new_benchmark});
+    return results;
+}
+
+bool report_gate(const std::vector<GateResult>& results_, double tolerance_, std::ostream& os_) {
+    os_ << std::left << std::setw(40) << "benchmark" << std::right << std::setw(14) << "base ns/op" << std::setw(10)
+        << "(mad)" << std::setw(14) << "now ns/op" << std::setw(10) << "(mad)" << std::setw(10) << "change"
+        << "  verdict\n";
+    bool pass{true};
+    for (const auto& r : results_) {
+        os_ << std::left << std::setw(40) << r.name << std::right << std::fixed << std::setprecision(2);
+        if (r.verdict == GateResult::Verdict::new_benchmark)
+            os_ << std::setw(14) << "-" << std::setw(10) << "-";
+        else
+            os_ << std::setw(14) << r.base.median << std::setw(10) << r.base.mad;
+        if (r.verdict == GateResult::Verdict::missing)
+            os_ << std::setw(14) << "-" << std::setw(10) << "-" << std::setw(10) << "-";
+        else
+            os_ << std::setw(14) << r.current.median << std::setw(10) << r.current.mad;
+        if (r.verdict != GateResult::Verdict::missing and r.verdict != GateResult::Verdict::new_benchmark)
+            os_ << std::setw(9) << std::showpos << std::setprecision(1)
+                << 100 * (r.current.median / r.base.median - 1) << std::noshowpos << "%";
+        else if (r.verdict == GateResult::Verdict::new_benchmark)
+            os_ << std::setw(10) << "-";
+        os_ << "  " << verdict_names[static_cast<int>(r.verdict)] << "\n";
+        if (r.verdict == GateResult::Verdict::regressed or r.verdict == GateResult::Verdict::missing) pass = false;
+    }
+    os_ << std::setprecision(1) << ">>> Gate " << (pass ? "passed" : "FAILED") << " (tolerance " << 100 * tolerance_
+        << "% or 3 sigma of the noise, whichever is larger).\n"
+        << std::defaultfloat;
+    return pass;
+}
+
+}  // namespace bench
@@ -0,0 +1,63 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _GATE_H_
+#define _GATE_H_
+
+#include <cstddef>   // std::size_t
+#include <iostream>  // std::istream, std::ostream
+#include <map>       // std::map
+#include <string>    // std::string
+#include <vector>    // std::vector
+
+#include "bench.h"
+
+namespace bench {
+/// Median and median absolute deviation of the ns/op of one benchmark over its runs.
+struct RobustStats {
+    double median{0};     //!< ns/op.
+    double mad{0};        //!< Median absolute deviation from the median, ns/op.
+    std::size_t runs{0};  //!< Number of runs summarized.
+};
+
+/// Median of a sample (0 when empty).
+double median(std::vector<double> v_);
+
+/// Median and MAD of a sample.
+RobustStats robust_stats(const std::vector<double>& v_);
+
+/// Reference timings of the gate subset, stored as JSON next to the benchmarks.
+struct Baseline {
+    std::size_t n{0};                                //!< Problem size the timings were taken with.
+    std::map<std::string, RobustStats> benchmarks;  //!< Keyed by "case/label".
+};
+
+/// Summarizes the samples of a run (grouped by name) into a baseline.
+Baseline summarize(const std::vector<Sample>& samples_, std::size_t n_);
+
+/// Writes a baseline as JSON.
+void write_baseline(std::ostream& os_, const Baseline& base_);
+
+/// Reads a baseline written by write_baseline(). Throws std::runtime_error on malformed input.
+Baseline read_baseline(std::istream& is_);
+
+/// Outcome of comparing one benchmark against its baseline.
+struct GateResult {
+    enum class Verdict { ok, improved, regressed, new_benchmark, missing };
+    std::string name;
+    RobustStats base, current;
+    Verdict verdict;
+};
+
+/**
+ * @brief Compares a run with the baseline. A benchmark regresses when its median grew by more than the relative
+ * tolerance_ *and* by more than the noise, estimated as 3 sigma from the larger of the two MADs; the second condition
+ * keeps a noisy machine from failing the gate on jitter alone. Improvements are reported with the same rule.
+ */
+std::vector<GateResult> compare(const Baseline& base_, const Baseline& current_, double tolerance_);
+
+/// Prints the comparison as a table. Returns true when nothing regressed and nothing is missing.
+bool report_gate(const std::vector<GateResult>& results_, double tolerance_, std::ostream& os_);
+
+}  // namespace bench
+
+#endif
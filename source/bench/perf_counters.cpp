@@ -0,0 +1,132 @@
+// @author: Jonas, Neylane e Selan.
+
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+const char* const perf_event_names[static_cast<int>(PerfEvent::n_events)] = {"cycles", "instructions", "llc-misses",
+                                                                             "dtlb-misses", "branch-misses"};
+
+bool PerfSample::any_valid() const {
+    for (auto v : valid)
+        if (v) return true;
+    return false;
+}
+
+#if defined(__linux__)
+namespace {
+/// Layout returned by read() with PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING.
+struct ReadFormat {
+    std::uint64_t value;
+    std::uint64_t time_enabled;
+    std::uint64_t time_running;
+};
+
+int open_event(PerfEvent ev) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;  // Count the worker threads of multi-threaded cases too.
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch (ev) {
+        case PerfEvent::cycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfEvent::instructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfEvent::llc_misses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PerfEvent::dtlb_misses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        default:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+    }
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+}  // namespace
+
+PerfCounters::PerfCounters() {
+    int opened{0}, last_errno{0};
+    for (int e{0}; e < static_cast<int>(PerfEvent::n_events); e++) {
+        m_fd[e] = open_event(static_cast<PerfEvent>(e));
+        if (m_fd[e] >= 0)
+            opened++;
+        else
+            last_errno = errno;
+    }
+    if (opened < static_cast<int>(PerfEvent::n_events)) {
+        m_status = std::to_string(static_cast<int>(PerfEvent::n_events) - opened) +
+                   " hardware counter(s) unavailable: " + std::strerror(last_errno);
+        if (last_errno == EACCES or last_errno == EPERM)
+            m_status += " (check /proc/sys/kernel/perf_event_paranoid)";
+        else if (last_errno == ENOENT or last_errno == ENODEV or last_errno == EOPNOTSUPP)
+            m_status += " (no PMU exposed, as usual in containers and VMs)";
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (auto fd : m_fd)
+        if (fd >= 0) close(fd);
+}
+
+void PerfCounters::start() {
+    for (auto fd : m_fd) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+PerfSample PerfCounters::stop() {
+    PerfSample sample;
+    for (int e{0}; e < static_cast<int>(PerfEvent::n_events); e++) {
+        if (m_fd[e] < 0) continue;
+        ioctl(m_fd[e], PERF_EVENT_IOC_DISABLE, 0);
+        ReadFormat rf;
+        if (read(m_fd[e], &rf, sizeof(rf)) != sizeof(rf) or rf.time_running == 0) continue;
+        // The kernel multiplexes events when there are more than PMU slots; scale to the full enabled time.
+        double scale = static_cast<double>(rf.time_enabled) / rf.time_running;
+        sample.value[e] = static_cast<std::uint64_t>(rf.value * scale);
+        sample.valid[e] = true;
+    }
+    return sample;
+}
+#else
+PerfCounters::PerfCounters() : m_status("hardware counters need Linux perf_event_open") {
+    for (auto& fd : m_fd) fd = -1;
+}
+PerfCounters::~PerfCounters() {}
+void PerfCounters::start() {}
+PerfSample PerfCounters::stop() { return PerfSample(); }
+#endif
+
+bool PerfCounters::available() const {
+    for (auto fd : m_fd)
+        if (fd >= 0) return true;
+    return false;
+}
+
+}  // namespace bench
@@ -0,0 +1,52 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _PERF_COUNTERS_H_
+#define _PERF_COUNTERS_H_
+
+#include <cstdint>  // std::uint64_t
+#include <string>   // std::string
+
+namespace bench {
+/// Hardware events collected around every measured region.
+enum class PerfEvent { cycles = 0, instructions, llc_misses, dtlb_misses, branch_misses, n_events };
+
+/// Names of the events, indexed by PerfEvent.
+extern const char* const perf_event_names[static_cast<int>(PerfEvent::n_events)];
+
+/// Counter values of one measured region. An event the kernel refused to open is marked as not valid.
+struct PerfSample {
+    std::uint64_t value[static_cast<int>(PerfEvent::n_events)] = {};
+    bool valid[static_cast<int>(PerfEvent::n_events)] = {};
+
+    bool any_valid() const;
+};
+
+/**
+ * @brief Thin wrapper over perf_event_open(2) counting user-space events of the calling process (and of the threads
+ * it spawns after the counters are opened).
+ *
+ * Counters are optional: each event is opened on its own, and when the kernel refuses it (no PMU in a container or VM,
+ * perf_event_paranoid too strict, non-Linux build) it is simply reported as unavailable.
+ */
+class PerfCounters {
+   public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /// True if at least one event could be opened.
+    bool available() const;
+    /// Why counters are missing, empty when all of them opened.
+    const std::string& status() const { return m_status; }
+
+    void start();
+    PerfSample stop();
+
+   private:
+    int m_fd[static_cast<int>(PerfEvent::n_events)];  //!< One descriptor per event, -1 when unavailable.
+    std::string m_status;                             //!< Diagnostic for the report.
+};
+
+}  // namespace bench
+#endif
@@ -3,6 +3,8 @@
  */
 #include "account.h"
 
+#include "../include/memory_usage.h"
+
 /// Basic constructor.
 Account::Account(std::string n, int bnc, int brc, int nmr, float bal)
     : m_name(n), m_bank_code(bnc), m_branch_code(brc), m_number(nmr), m_balance(bal) { /* Empty */
@@ -28,6 +30,9 @@ bool operator==(const Account& a, const Account& b) {
             a.m_number == b.m_number and a.m_balance == b.m_balance);
 }
 
+/// Heap bytes owned by an account (the name buffer); found by HashTbl::memory_usage() through ADL.
+std::size_t heap_bytes(const Account& a) { return ac::heap_bytes(a.m_name); }
+
 std::size_t KeyHash::operator()(const Account::AcctKey& _k) const {
     return std::hash<std::string>()(std::get<0>(_k)) xor std::hash<int>()(std::get<1>(_k)) xor
            std::hash<int>()(std::get<2>(_k)) xor std::hash<int>()(std::get<3>(_k));
@@ -34,6 +34,9 @@ struct Account {
 /// Compare two accounts
 bool operator==(const Account &a, const Account &b);
 
+/// Heap bytes owned by an account (the name buffer); found by HashTbl::memory_usage() through ADL.
+std::size_t heap_bytes(const Account &a);
+
 /// Functor that generates a hash number for a given account.
 struct KeyHash {
     std::size_t operator()(const Account::AcctKey &) const;
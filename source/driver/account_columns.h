@@ -0,0 +1,73 @@
+/*!
+ * @file: account_columns.h
+ */
+
+#ifndef ACCOUNT_COLUMNS_H
+#define ACCOUNT_COLUMNS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "account.h"
+
+/**
+ * Struct-of-arrays snapshot of the numeric fields of the accounts stored in a table, for analytics.
+ *
+ * Aggregating over the table itself chases one pointer per account, through nodes scattered over the heap; here each
+ * field is a dense array, so a scan streams through memory and the kernels below process eight rows per instruction.
+ * Row i of every column belongs to the same account. The snapshot is a copy: later changes to the table do not show.
+ */
+struct AccountColumns {
+    std::vector<int> bank;               //!< Bank codes.
+    std::vector<int> branch;             //!< Branch codes.
+    std::vector<int> number;             //!< Account numbers.
+    std::vector<float> balance;          //!< Balances.
+    std::vector<std::uint16_t> bank_id;  //!< Dictionary-encoded bank: bank[i] == bank_codes[bank_id[i]].
+    std::vector<int> bank_codes;         //!< Distinct bank codes, ascending.
+
+    /// Number of rows.
+    std::size_t size(void) const { return bank.size(); }
+
+    /// Appends the fields of an account; call encode_banks() once all are in.
+    void push_back(const Account &a);
+
+    /// Fills bank_id and bank_codes from the bank column. Throws std::length_error beyond 65536 distinct banks.
+    void encode_banks(void);
+};
+
+/// Takes a snapshot of the accounts stored in table (a HashTbl, or anything with size() and for_each(fn(key, acct))).
+template <class Table>
+AccountColumns snapshot_columns(const Table &table) {
+    AccountColumns cols;
+    cols.bank.reserve(table.size());
+    cols.branch.reserve(table.size());
+    cols.number.reserve(table.size());
+    cols.balance.reserve(table.size());
+    table.for_each([&](const Account::AcctKey &, const Account &a) { cols.push_back(a); });
+    cols.encode_banks();
+    return cols;
+}
+
+/// Instruction set the kernels run with. Asking for one the CPU lacks falls back to scalar code.
+enum class Isa { best, scalar, avx2 };
+
+/// Whether the kernels can use isa on this build and CPU.
+bool isa_supported(Isa isa);
+
+/// Sum of the balances of the accounts of bank bank_code.
+double sum_balance(const AccountColumns &cols, int bank_code, Isa isa = Isa::best);
+
+/// Number of accounts whose balance lies in [lo, hi).
+std::size_t count_balance(const AccountColumns &cols, float lo, float hi, Isa isa = Isa::best);
+
+/// Balance total and account count of every bank, indexed like cols.bank_codes.
+struct BankTotals {
+    std::vector<double> sum;
+    std::vector<std::size_t> count;
+};
+
+/// Group-by bank: total balance and number of accounts of each bank. The AVX2 kernel only pays off for a few banks
+/// (up to four); with more, the scalar loop runs whatever isa says.
+BankTotals totals_by_bank(const AccountColumns &cols, Isa isa = Isa::best);
+
+#endif
@@ -0,0 +1,71 @@
+/*!
+ * @file: account_gen.cpp
+ */
+#include "account_gen.h"
+
+#include <sstream>
+#include <string>
+
+namespace {
+const char *first_names[] = {"Alex",    "Aline",   "Ana",     "Bruno",   "Carla",   "Carlito", "Cristiano", "Daniel",
+                             "Debora",  "Eduardo", "Fabio",   "Fernanda", "Gabriel", "Helena",  "Igor",      "Januario",
+                             "Joana",   "Jonas",   "Jose",    "Julia",   "Lima",    "Lucas",   "Luiza",     "Marcos",
+                             "Maria",   "Mateus",  "Neylane", "Otavio",  "Paula",   "Pedro",   "Rafael",    "Renata",
+                             "Saulo",   "Selan",   "Sofia",   "Tiago",   "Valeria", "Vitor",   "Yara",      "Zeca"};
+const char *last_names[] = {"Almeida", "Alves",  "Bastos",    "Barbosa", "Cardoso", "Costa",   "Cunha",   "Dias",
+                            "Duarte",  "Freire", "Gomes",     "Junior",  "Lima",    "Lopes",   "Martins", "Medeiros",
+                            "Melo",    "Moura",  "Nascimento", "Oliveira", "Pardo",  "Pereira", "Pinto",   "Ramos",
+                            "Ribeiro", "Rocha",  "Ronaldo",   "Santos",  "Silva",   "Souza",   "Teixeira", "Vieira"};
+const std::size_t n_first = sizeof(first_names) / sizeof(first_names[0]);
+const std::size_t n_last = sizeof(last_names) / sizeof(last_names[0]);
+
+// A handful of banks hold most of the accounts, as in real data.
+const int bank_codes[] = {1, 1, 1, 33, 33, 104, 104, 237, 237, 341, 341, 13, 18, 28, 116, 17, 12, 260, 77, 212};
+const std::size_t n_banks = sizeof(bank_codes) / sizeof(bank_codes[0]);
+}  // namespace
+
+/// Basic constructor; the same seed always yields the same sequence of accounts.
+AccountGenerator::AccountGenerator(std::uint64_t seed) : m_rng(seed), m_serial(0) { /* Empty */
+}
+
+/// Returns the next account of the sequence.
+Account AccountGenerator::next(void) {
+    std::string name = first_names[m_rng() % n_first];
+    if (m_rng() % 4 == 0) name += std::string(" ") + last_names[m_rng() % n_last];
+    name += std::string(" ") + last_names[m_rng() % n_last];
+
+    int bank = bank_codes[m_rng() % n_banks];
+    int branch = 1 + static_cast<int>(m_rng() % 4000);
+    // Multiplying by an odd constant is a bijection modulo 2^31, so numbers never repeat and keys stay unique.
+    int number = static_cast<int>((m_serial++ * 2654435761u) & 0x7fffffffu);
+    float balance = (m_rng() % 20 == 0) ? 0.f : static_cast<float>(m_rng() % 10000000) / 100.f;
+
+    return Account(name, bank, branch, number, balance);
+}
+
+/// Returns the next n accounts of the sequence.
+std::vector<Account> AccountGenerator::generate(std::size_t n) {
+    std::vector<Account> accounts;
+    accounts.reserve(n);
+    while (n--) accounts.push_back(next());
+    return accounts;
+}
+
+/// Reads account keys from a stream, one per line as "name;bank;branch;number". Malformed lines are skipped.
+std::vector<Account::AcctKey> read_account_keys(std::istream &is) {
+    std::vector<Account::AcctKey> keys;
+    std::string line;
+    while (std::getline(is, line)) {
+        std::istringstream fields(line);
+        std::string name, bank, branch, number;
+        if (!std::getline(fields, name, ';') or !std::getline(fields, bank, ';') or
+            !std::getline(fields, branch, ';') or !std::getline(fields, number))
+            continue;
+        try {
+            keys.emplace_back(name, std::stoi(bank), std::stoi(branch), std::stoi(number));
+        } catch (const std::exception &) {
+            continue;
+        }
+    }
+    return keys;
+}
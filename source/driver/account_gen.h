@@ -0,0 +1,35 @@
+/*!
+ * @file: account_gen.h
+ */
+
+#ifndef ACCOUNT_GEN_H
+#define ACCOUNT_GEN_H
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "account.h"
+
+/// Generates synthetic bank accounts with unique keys, for tools and benchmarks.
+class AccountGenerator {
+   public:
+    /// Basic constructor; the same seed always yields the same sequence of accounts.
+    explicit AccountGenerator(std::uint64_t seed = 1);
+
+    /// Returns the next account of the sequence.
+    Account next(void);
+
+    /// Returns the next n accounts of the sequence.
+    std::vector<Account> generate(std::size_t n);
+
+   private:
+    std::mt19937_64 m_rng;  //!< Random source.
+    std::uint32_t m_serial;  //!< Sequence counter, keeps account numbers unique.
+};
+
+/// Reads account keys from a stream, one per line as "name;bank;branch;number". Malformed lines are skipped.
+std::vector<Account::AcctKey> read_account_keys(std::istream &is);
+
+#endif
@@ -3,16 +3,73 @@
 #include <cassert>
 #include <functional>
 #include <iostream>
+#include <string>
 #include <tuple>
 
 #include "../include/hashtbl.h"
 #include "account.h"
+#include "load_gen.h"
 
 using namespace ac;
 
+//=== LOAD GENERATOR MODE
+
+void usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " [--load [--accounts <n>] [--threads <t>] [--duration <s>] [--mix r:i:e:u]"
+              << " [--seed <s>] [--record <trace>]]\n"
+              << "  Without arguments, runs the step-by-step demonstration.\n"
+              << "  --load runs a quiet operation mix (retrieve:insert:erase:update weights, default 80:10:5:5)\n"
+              << "  and reports throughput and latency percentiles per operation.\n"
+              << "  --record also writes the operations to a trace file, to be replayed with replay_trace.\n";
+}
+
+int load_mode(int argc, char *argv[]) {
+    LoadConfig cfg;
+    for (int i{2}; i < argc; i++) {
+        std::string arg{argv[i]};
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        std::string value{argv[++i]};
+        try {
+            if (arg == "--accounts")
+                cfg.accounts = std::stoul(value);
+            else if (arg == "--threads")
+                cfg.threads = static_cast<unsigned>(std::stoul(value));
+            else if (arg == "--duration")
+                cfg.duration = std::stod(value);
+            else if (arg == "--seed")
+                cfg.seed = std::stoull(value);
+            else if (arg == "--record")
+                cfg.record = value;
+            else if (arg != "--mix" or !parse_mix(value, cfg)) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } catch (const std::exception &) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (cfg.accounts == 0 or cfg.threads == 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    run_load(cfg, std::cout);
+    return EXIT_SUCCESS;
+}
+
 //=== CLIENT CODE
 
-int main() {
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        if (std::string(argv[1]) == "--load") return load_mode(argc, argv);
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
     Account acct("Alex Bastos", 1, 1668, 54321, 1500.f);
     Account myAccounts[] = {{"Alex Bastos", 1, 1668, 54321, 1500.f},
                             {"Aline Souza", 1, 1668, 45794, 530.f},
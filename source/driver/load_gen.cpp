@@ -0,0 +1,184 @@
+/*!
+ * @file: load_gen.cpp
+ */
+#include "load_gen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "../include/hashtbl.h"
+#include "../include/latency_histogram.h"
+#include "../include/op_trace.h"
+#include "account.h"
+#include "account_gen.h"
+
+namespace {
+using AcctTable = ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual>;
+using Clock = std::chrono::steady_clock;
+
+const int n_kinds = static_cast<int>(OpKind::n_kinds);
+const char *kind_names[n_kinds] = {"retrieve", "insert", "erase", "update"};
+
+/// What one client thread measured.
+struct ClientStats {
+    ac::LatencyHistogram latencies[n_kinds];   //!< Latency of the operations, in ns.
+    std::size_t hits[n_kinds] = {0, 0, 0, 0};  //!< Operations that found (or created) their key.
+};
+
+/// Body of a client thread: draws operations until the stop flag is raised. Table is AcctTable or its recording wrapper.
+template <class Table>
+void client(Table &table, std::mutex &lock, const std::vector<Account> &pool,
+            const std::vector<Account::AcctKey> &keys, const LoadConfig &cfg, unsigned id,
+            const std::atomic<bool> &stop, ClientStats &stats) {
+    std::mt19937_64 rng(cfg.seed * 7919 + id);
+    unsigned total_weight{0};
+    for (auto w : cfg.mix) total_weight += w;
+
+    Account acct;
+    while (!stop.load(std::memory_order_relaxed)) {
+        std::size_t k = rng() % keys.size();
+        unsigned pick = static_cast<unsigned>(rng() % total_weight);
+        int kind{0};
+        while (pick >= cfg.mix[kind]) pick -= cfg.mix[kind++];
+
+        bool hit{false};
+        {
+            ac::ScopedLatency timer(stats.latencies[kind]);
+            std::lock_guard<std::mutex> guard(lock);
+            switch (static_cast<OpKind>(kind)) {
+                case OpKind::retrieve:
+                    hit = table.retrieve(keys[k], acct);
+                    break;
+                case OpKind::insert:
+                    hit = table.insert(keys[k], pool[k]);
+                    break;
+                case OpKind::erase:
+                    hit = table.erase(keys[k]);
+                    break;
+                default:  // Read-modify-write of the balance, in place: one lookup, recorded as one update.
+                    if (auto found = table.find(keys[k])) {
+                        found->m_balance += 1.f;
+                        hit = true;
+                    }
+                    break;
+            }
+        }
+        if (hit) stats.hits[kind]++;
+    }
+}
+}  // namespace
+
+/// Parses "r:i:e:u" weights (retrieve, insert, erase, update) into cfg. Returns false when malformed.
+bool parse_mix(const std::string &text, LoadConfig &cfg) {
+    std::istringstream iss(text);
+    std::string field;
+    unsigned weights[n_kinds], total{0};
+    for (int i{0}; i < n_kinds; i++) {
+        if (!std::getline(iss, field, ':')) return false;
+        try {
+            weights[i] = static_cast<unsigned>(std::stoul(field));
+        } catch (const std::exception &) {
+            return false;
+        }
+        total += weights[i];
+    }
+    if (total == 0 or std::getline(iss, field)) return false;
+    std::copy(weights, weights + n_kinds, cfg.mix);
+    return true;
+}
+
+/// Runs the configured operation mix against a HashTbl of accounts and prints throughput and latency per operation.
+void run_load(const LoadConfig &cfg, std::ostream &os) {
+    AccountGenerator gen(cfg.seed);
+    std::vector<Account> pool = gen.generate(cfg.accounts);
+    std::vector<Account::AcctKey> keys;
+    keys.reserve(pool.size());
+    for (const auto &a : pool) keys.push_back(a.getKey());
+
+    // Start with half of the key space loaded, so inserts and erases both find work to do.
+    AcctTable table;
+
+    // The recorder is driven under the same lock as the table, so the trace keeps the order the table saw.
+    std::ofstream trace_file;
+    std::unique_ptr<ac::TraceWriter> writer;
+    std::unique_ptr<ac::RecordingHashTbl<AcctTable> > recorder;
+    if (!cfg.record.empty()) {
+        trace_file.open(cfg.record, std::ios::binary);
+        if (!trace_file) {
+            os << ">>> Cannot open \"" << cfg.record << "\" for writing.\n";
+            return;
+        }
+        writer.reset(new ac::TraceWriter(trace_file));
+        recorder.reset(new ac::RecordingHashTbl<AcctTable>(table, *writer));
+    }
+    // When recording, the initial load goes into the trace too, so a replay starting from an empty table matches.
+    for (std::size_t i{0}; i < pool.size(); i += 2) {
+        if (recorder)
+            recorder->insert(keys[i], pool[i]);
+        else
+            table.insert(keys[i], pool[i]);
+    }
+
+    os << ">>> Load: " << cfg.accounts << " accounts, " << cfg.threads << " thread(s), " << cfg.duration
+       << " s, mix r:i:e:u = " << cfg.mix[0] << ":" << cfg.mix[1] << ":" << cfg.mix[2] << ":" << cfg.mix[3]
+       << ", initial size " << table.size() << "\n";
+
+    std::mutex lock;
+    std::atomic<bool> stop{false};
+    std::vector<ClientStats> stats(cfg.threads);
+    std::vector<std::thread> clients;
+    auto start = Clock::now();
+    for (unsigned t{0}; t < cfg.threads; t++) {
+        if (recorder)
+            clients.emplace_back(client<ac::RecordingHashTbl<AcctTable> >, std::ref(*recorder), std::ref(lock),
+                                 std::cref(pool), std::cref(keys), std::cref(cfg), t, std::cref(stop),
+                                 std::ref(stats[t]));
+        else
+            clients.emplace_back(client<AcctTable>, std::ref(table), std::ref(lock), std::cref(pool),
+                                 std::cref(keys), std::cref(cfg), t, std::cref(stop), std::ref(stats[t]));
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(cfg.duration));
+    stop = true;
+    for (auto &c : clients) c.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    os << std::setw(10) << "operation" << std::setw(12) << "ops" << std::setw(12) << "Mops/s" << std::setw(8)
+       << "hit%" << std::setw(10) << "p50 ns" << std::setw(10) << "p90 ns" << std::setw(10) << "p99 ns"
+       << std::setw(11) << "p99.9 ns" << std::setw(11) << "max ns" << "\n";
+    std::size_t total_ops{0};
+    for (int k{0}; k < n_kinds; k++) {
+        // Every client recorded into its own histogram; merging them is cheap and keeps recording contention-free.
+        ac::LatencyHistogram all;
+        std::size_t hits{0};
+        for (auto &s : stats) {
+            all.merge(s.latencies[k]);
+            hits += s.hits[k];
+        }
+        if (all.count() == 0) continue;
+        total_ops += all.count();
+        os << std::setw(10) << kind_names[k] << std::setw(12) << all.count() << std::setw(12) << std::fixed
+           << std::setprecision(3) << all.count() / elapsed / 1e6 << std::setw(8) << std::setprecision(1)
+           << 100.0 * hits / all.count() << std::setw(10) << all.percentile(0.5) << std::setw(10)
+           << all.percentile(0.9) << std::setw(10) << all.percentile(0.99) << std::setw(11)
+           << all.percentile(0.999) << std::setw(11) << all.max() << "\n";
+    }
+    os << std::setw(10) << "total" << std::setw(12) << total_ops << std::setw(12) << std::setprecision(3)
+       << total_ops / elapsed / 1e6 << "\n"
+       << ">>> Final size " << table.size() << ", " << table.bucket_count() << " buckets.\n"
+       << std::defaultfloat;
+    if (recorder) {
+        writer->flush();
+        os << ">>> Trace written to \"" << cfg.record << "\": " << writer->count()
+           << " operations (initial load included) on " << recorder->distinct_keys() << " keys, "
+           << trace_file.tellp() << " bytes.\n";
+    }
+}
@@ -0,0 +1,31 @@
+/*!
+ * @file: load_gen.h
+ */
+
+#ifndef LOAD_GEN_H
+#define LOAD_GEN_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+/// Kinds of operation issued by the load generator.
+enum class OpKind { retrieve = 0, insert, erase, update, n_kinds };
+
+/// Settings of a load generator run.
+struct LoadConfig {
+    std::size_t accounts = 100000;  //!< Number of generated accounts (the key space).
+    unsigned threads = 1;           //!< Number of client threads.
+    double duration = 5.0;          //!< Run time, in seconds.
+    unsigned mix[static_cast<int>(OpKind::n_kinds)] = {80, 10, 5, 5};  //!< Weight of each operation kind.
+    std::uint64_t seed = 1;                                            //!< Seed of the generator and of the clients.
+    std::string record;  //!< When set, every operation is also written to this trace file (see op_trace.h).
+};
+
+/// Parses "r:i:e:u" weights (retrieve, insert, erase, update) into cfg. Returns false when malformed.
+bool parse_mix(const std::string &text, LoadConfig &cfg);
+
+/// Runs the configured operation mix against a HashTbl of accounts and prints throughput and latency per operation.
+void run_load(const LoadConfig &cfg, std::ostream &os);
+
+#endif
@@ -0,0 +1,213 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _AGG_TABLE_H_
+#define _AGG_TABLE_H_
+
+#include <algorithm>    // std::min, std::max
+#include <cstddef>      // std::size_t
+#include <cstdint>      // std::uint64_t, std::uint32_t
+#include <limits>       // std::numeric_limits
+#include <memory>       // std::unique_ptr
+#include <type_traits>  // std::is_integral
+#include <utility>      // std::swap
+#include <vector>       // std::vector
+
+#include "thread_pool.h"
+
+namespace ac  // Associative container
+{
+/// Running aggregates of a group: count, sum, minimum and maximum of its values.
+template <class Value>
+struct AggState {
+    std::uint64_t count{0};
+    double sum{0};  //!< Kept in double whatever Value is, so long groups do not lose their small values.
+    Value min{std::numeric_limits<Value>::max()};
+    Value max{std::numeric_limits<Value>::lowest()};
+
+    void add(Value v_) {
+        count++;
+        sum += v_;
+        min = std::min(min, v_);
+        max = std::max(max, v_);
+    }
+    void merge(const AggState& o_) {
+        count += o_.count;
+        sum += o_.sum;
+        min = std::min(min, o_.min);
+        max = std::max(max, o_.max);
+    }
+    double mean() const { return count ? sum / count : 0.0; }
+};
+
+/**
+ * @brief Hash table specialized for group-by: integer group keys mapped to an AggState, updated one row at a time.
+ *
+ * A HashTbl<int, float> per aggregate looks every row up once per aggregate, and each lookup walks a collision list
+ * on the heap. Here the state is stored inline next to its key, in one flat array of slots probed linearly (open
+ * addressing), so a row costs one probe that usually lands on a single cache line:
+ *  - the capacity is a power of two and the slot is picked by Fibonacci hashing (multiply, keep the high bits), which
+ *    spreads consecutive keys such as branch codes;
+ *  - aggregate() takes rows in batches and prefetches the slots of the next rows while it updates the current ones,
+ *    which matters once the groups no longer fit in the cache;
+ *  - parallel_aggregate() gives every worker its own partial table and merges them at the end, so the workers never
+ *    share a slot.
+ * Groups cannot be removed; clear() empties the table. Like HashTbl, it is not thread-safe.
+ */
+template <class Key = int, class Value = float>
+class AggTable {
+    static_assert(std::is_integral<Key>::value, "AggTable keys must be integers");
+
+   public:
+    using size_type = std::size_t;
+    using state_type = AggState<Value>;
+
+    /// Creates a table sized for about expected_groups_ groups without growing.
+    explicit AggTable(size_type expected_groups_ = 16) { reset(capacity_for(expected_groups_)); }
+
+    /// Adds the row (key_, value_) to its group.
+    void add(Key key_, Value value_) { slot_for(key_, hash(key_)).state.add(value_); }
+
+    /// Adds n_ rows, keys_[i] with values_[i], to their groups.
+    void aggregate(const Key* keys_, const Value* values_, size_type n_) {
+        const size_type batch = 16;
+        std::uint64_t hashes[batch];
+        for (size_type first{0}; first < n_; first += batch) {
+            size_type last = std::min(n_, first + batch);
+            // Growing moves the slots, but hashes do not depend on the capacity; the prefetches just go stale.
+            for (size_type i{first}; i < last; i++) {
+                hashes[i - first] = hash(keys_[i]);
+                prefetch(hashes[i - first]);
+            }
+            for (size_type i{first}; i < last; i++) slot_for(keys_[i], hashes[i - first]).state.add(values_[i]);
+        }
+    }
+
+    /**
+     * @brief Same as aggregate(), split across the workers of pool_. Each worker fills a partial table of its own;
+     * the partials are merged into this table when all rows are done.
+     */
+    void parallel_aggregate(const Key* keys_, const Value* values_, size_type n_,
+                            ThreadPool& pool_ = ThreadPool::shared()) {
+        std::vector<std::unique_ptr<AggTable> > partials(pool_.size());
+        // Chunks of 64K rows: large enough to amortize scheduling, small enough for stealing to balance the workers.
+        pool_.parallel_for(0, n_, 1 << 16, [&](std::size_t lo_, std::size_t hi_, unsigned worker_) {
+            if (!partials[worker_]) partials[worker_].reset(new AggTable(size()));
+            partials[worker_]->aggregate(keys_ + lo_, values_ + lo_, hi_ - lo_);
+        });
+        for (auto& p : partials)
+            if (p) merge(*p);
+    }
+
+    /// Folds the groups of other_ into this table.
+    void merge(const AggTable& other_) {
+        // other_ is walked in slot order, which is hash order. Inserted into a table that fills up and grows on the
+        // way, such a run of keys would pile up into one long probe sequence; room made beforehand prevents that.
+        reserve(size() + other_.size());
+        other_.for_each([&](Key key, const state_type& s) { slot_for(key, hash(key)).state.merge(s); });
+    }
+
+    /// State of the group key_, or nullptr when no row of that group was seen.
+    const state_type* find(Key key_) const {
+        for (size_type i = hash(key_) >> m_shift;; i = (i + 1) & m_mask) {
+            const auto& s = m_slots[i];
+            if (!s.used) return nullptr;
+            if (s.key == key_) return &s.state;
+        }
+    }
+
+    /// Calls fn_(key, state) for every group, in no particular order.
+    template <class Fn>
+    void for_each(Fn fn_) const {
+        for (size_type i{0}; i <= m_mask; i++)
+            if (m_slots[i].used) fn_(m_slots[i].key, m_slots[i].state);
+    }
+
+    /// Makes room for groups_ groups without growing.
+    void reserve(size_type groups_) {
+        if (groups_ > capacity() * max_load) rebuild(capacity_for(groups_));
+    }
+
+    /// Number of groups.
+    size_type size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+    /// Number of slots; size() stays below max_load of it.
+    size_type capacity() const { return m_mask + 1; }
+    /// Drops every group, keeping the capacity.
+    void clear() { reset(capacity()); }
+
+   private:
+    struct Slot {
+        Key key;
+        bool used;
+        state_type state;
+    };
+
+    static constexpr double max_load = 0.5;  //!< Short probe sequences matter more here than memory.
+
+    std::vector<Slot> m_slots;
+    size_type m_mask{0};   //!< capacity() - 1.
+    unsigned m_shift{0};   //!< 64 - log2(capacity()): a hash >> m_shift is a slot index.
+    size_type m_count{0};  //!< Groups stored.
+
+    /// Fibonacci hashing: the high bits of key * 2^64 / phi are well mixed even for consecutive keys.
+    static std::uint64_t hash(Key key_) {
+        return static_cast<std::uint64_t>(key_) * UINT64_C(11400714819323198485);
+    }
+    static size_type capacity_for(size_type groups_) {
+        size_type cap{16};
+        while (cap * max_load < groups_) cap *= 2;
+        return cap;
+    }
+    void reset(size_type capacity_) {
+        m_slots.assign(capacity_, Slot{Key(), false, state_type()});
+        m_mask = capacity_ - 1;
+        m_shift = 64;
+        for (size_type c{capacity_}; c > 1; c >>= 1) m_shift--;
+        m_count = 0;
+    }
+    void prefetch(std::uint64_t hash_) const {
+#if defined(__GNUC__)
+        __builtin_prefetch(&m_slots[hash_ >> m_shift]);
+#else
+        (void)hash_;
+#endif
+    }
+
+    /// Slot of the group key_, created if needed.
+    Slot& slot_for(Key key_, std::uint64_t hash_) {
+        for (size_type i = hash_ >> m_shift;; i = (i + 1) & m_mask) {
+            auto& s = m_slots[i];
+            if (s.used) {
+                if (s.key == key_) return s;
+                continue;
+            }
+            if (m_count + 1 > capacity() * max_load) {
+                grow();
+                return slot_for(key_, hash_);
+            }
+            s.key = key_;
+            s.used = true;
+            m_count++;
+            return s;
+        }
+    }
+    void grow() { rebuild(2 * capacity()); }
+    void rebuild(size_type capacity_) {
+        std::vector<Slot> old;
+        old.swap(m_slots);
+        reset(capacity_);
+        for (const auto& s : old)
+            if (s.used) {
+                size_type i = hash(s.key) >> m_shift;
+                while (m_slots[i].used) i = (i + 1) & m_mask;
+                m_slots[i] = s;
+                m_count++;
+            }
+    }
+};
+
+template <class Key, class Value>
+constexpr double AggTable<Key, Value>::max_load;
+
+}  // namespace ac
+#endif
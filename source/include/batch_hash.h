@@ -0,0 +1,199 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _BATCH_HASH_H_
+#define _BATCH_HASH_H_
+
+#include <array>        // std::array
+#include <cstddef>      // std::size_t
+#include <cstdint>      // std::uint32_t, std::uint64_t
+#include <cstring>      // std::memcpy
+#include <type_traits>  // std::is_integral, std::true_type, std::false_type, std::integral_constant
+#include <utility>      // std::declval
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // SSE2 lanes of keys
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>  // _mm_mullo_epi32
+#endif
+
+#include "hash_utils.h"
+
+namespace ac  // Associative container
+{
+/*
+ * Hash functors with a batch form. Besides operator(), which hashes one key, they provide
+ *     void hash_batch(const Key* keys, std::size_t n, std::size_t* out) const;
+ * which hashes n keys at once, with the same results, several keys per SIMD instruction. Batched lookups such as
+ * HashTbl::retrieve_many() call it whenever the hash functor of the table has one (see detail::hash_keys()).
+ */
+
+namespace detail {
+#if defined(__SSE2__)
+/// Lane-wise 32-bit product (the low half), in SSE2 terms when SSE4.1 is not there.
+inline __m128i mullo32(__m128i a_, __m128i b_) {
+#if defined(__SSE4_1__)
+    return _mm_mullo_epi32(a_, b_);
+#else
+    __m128i even = _mm_mul_epu32(a_, b_);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a_, 32), _mm_srli_epi64(b_, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+/// Stores the four 32-bit lanes of h_ widened to std::size_t.
+inline void store_hashes(__m128i h_, std::size_t* out_) {
+    if (sizeof(std::size_t) == 8) {
+        __m128i zero = _mm_setzero_si128();
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out_), _mm_unpacklo_epi32(h_, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out_) + 1, _mm_unpackhi_epi32(h_, zero));
+    } else {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out_), h_);
+    }
+}
+#endif
+
+/// Finalizer of MurmurHash3 for 32-bit values: every input bit affects every output bit.
+inline std::uint32_t fmix32(std::uint32_t h_) {
+    h_ ^= h_ >> 16;
+    h_ *= 0x85ebca6bu;
+    h_ ^= h_ >> 13;
+    h_ *= 0xc2b2ae35u;
+    h_ ^= h_ >> 16;
+    return h_;
+}
+#if defined(__SSE2__)
+/// fmix32() of the four lanes of h_.
+inline __m128i fmix32(__m128i h_) {
+    h_ = _mm_xor_si128(h_, _mm_srli_epi32(h_, 16));
+    h_ = mullo32(h_, _mm_set1_epi32(static_cast<int>(0x85ebca6bu)));
+    h_ = _mm_xor_si128(h_, _mm_srli_epi32(h_, 13));
+    h_ = mullo32(h_, _mm_set1_epi32(static_cast<int>(0xc2b2ae35u)));
+    return _mm_xor_si128(h_, _mm_srli_epi32(h_, 16));
+}
+#endif
+
+/// Whether Hash has hash_batch(const Key*, std::size_t, std::size_t*).
+template <class Hash, class Key>
+class has_hash_batch {
+    template <class H>
+    static auto test(int) -> decltype(std::declval<const H&>().hash_batch(std::declval<const Key*>(), std::size_t(),
+                                                                          std::declval<std::size_t*>()),
+                                      std::true_type());
+    template <class>
+    static std::false_type test(...);
+
+   public:
+    static constexpr bool value = decltype(test<Hash>(0))::value;
+};
+
+template <class Hash, class Key>
+void hash_keys(const Hash& hash_, const Key* keys_, std::size_t n_, std::size_t* out_, std::true_type) {
+    hash_.hash_batch(keys_, n_, out_);
+}
+template <class Hash, class Key>
+void hash_keys(const Hash& hash_, const Key* keys_, std::size_t n_, std::size_t* out_, std::false_type) {
+    for (std::size_t i{0}; i < n_; i++) out_[i] = hash_(keys_[i]);
+}
+/// out_[i] = hash_(keys_[i]) for the n_ keys, through hash_.hash_batch() when Hash has one.
+template <class Hash, class Key>
+void hash_keys(const Hash& hash_, const Key* keys_, std::size_t n_, std::size_t* out_) {
+    hash_keys(hash_, keys_, n_, out_, std::integral_constant<bool, has_hash_batch<Hash, Key>::value>());
+}
+}  // namespace detail
+
+/**
+ * @brief Hash of integer keys, with a batch form.
+ *
+ * Keys of up to 32 bits go through the MurmurHash3 finalizer, four keys per SSE2 register; 64-bit keys through
+ * hash_mix(). SSE2 has no 64-bit multiply, and building one takes three 32-bit ones plus the shuffles, for two
+ * keys per register: their batch is a plain loop, as fast as one call per key.
+ */
+template <class Int>
+struct IntBatchHash {
+    static_assert(std::is_integral<Int>::value, "IntBatchHash is for integer keys");
+
+    std::size_t operator()(Int key_) const {
+        return sizeof(Int) <= 4 ? detail::fmix32(static_cast<std::uint32_t>(key_))
+                                : static_cast<std::size_t>(hash_mix(static_cast<std::uint64_t>(key_)));
+    }
+
+    void hash_batch(const Int* keys_, std::size_t n_, std::size_t* out_) const {
+        std::size_t i{0};
+#if defined(__SSE2__)
+        if (sizeof(Int) == 4) {
+            // Two registers per round, so that the multiplies of one overlap with the other.
+            for (; i + 8 <= n_; i += 8) {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys_ + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys_ + i + 4));
+                detail::store_hashes(detail::fmix32(a), out_ + i);
+                detail::store_hashes(detail::fmix32(b), out_ + i + 4);
+            }
+        }
+#endif
+        for (; i < n_; i++) out_[i] = (*this)(keys_[i]);
+    }
+};
+
+/**
+ * @brief Hash of fixed-length string keys (account codes, ISINs...) held in a std::array<char, N>, with a batch form.
+ *
+ * The key is read in 4-byte words, the last one padded with zeros: each word is mixed into the hash with a multiply,
+ * and the result goes through the MurmurHash3 finalizer. The batch runs the same steps on four keys at once, one key
+ * per SSE2 lane.
+ */
+template <std::size_t N>
+struct FixedStringBatchHash {
+    using key_type = std::array<char, N>;
+    static constexpr std::size_t words = (N + 3) / 4;
+
+    std::size_t operator()(const key_type& key_) const {
+        std::uint32_t h{seed};
+        for (std::size_t w{0}; w < words; w++) {
+            h = (h ^ word(key_, w)) * 0x9e3779b1u;
+            h ^= h >> 15;
+        }
+        return detail::fmix32(h);
+    }
+
+    void hash_batch(const key_type* keys_, std::size_t n_, std::size_t* out_) const {
+        std::size_t i{0};
+#if defined(__SSE2__)
+        const __m128i golden = _mm_set1_epi32(static_cast<int>(0x9e3779b1u));
+        for (; i + 4 <= n_; i += 4) {
+            __m128i h = _mm_set1_epi32(static_cast<int>(seed));
+            for (std::size_t w{0}; w < words; w++) {
+                // Word w of the four keys, one per lane: the keys are apart in memory, so the lanes are filled one
+                // by one (a gather, in SSE2 terms).
+                __m128i v = _mm_set_epi32(static_cast<int>(word(keys_[i + 3], w)),
+                                          static_cast<int>(word(keys_[i + 2], w)),
+                                          static_cast<int>(word(keys_[i + 1], w)), static_cast<int>(word(keys_[i], w)));
+                h = detail::mullo32(_mm_xor_si128(h, v), golden);
+                h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+            }
+            detail::store_hashes(detail::fmix32(h), out_ + i);
+        }
+#endif
+        for (; i < n_; i++) out_[i] = (*this)(keys_[i]);
+    }
+
+   private:
+    static constexpr std::uint32_t seed = 0x811c9dc5u ^ static_cast<std::uint32_t>(N);
+
+    /// Word w_ of key_, in the byte order of the machine, zero-padded past the end of the key.
+    static std::uint32_t word(const key_type& key_, std::size_t w_) {
+        std::uint32_t v{0};
+        std::memcpy(&v, key_.data() + 4 * w_, 4 * w_ + 4 <= N ? 4 : N - 4 * w_);
+        return v;
+    }
+};
+
+template <std::size_t N>
+constexpr std::size_t FixedStringBatchHash<N>::words;
+template <std::size_t N>
+constexpr std::uint32_t FixedStringBatchHash<N>::seed;
+template <class Hash, class Key>
+constexpr bool detail::has_hash_batch<Hash, Key>::value;
+
+}  // namespace ac
+#endif
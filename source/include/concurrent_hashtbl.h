@@ -0,0 +1,667 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _CONCURRENT_HASHTBL_H_
+#define _CONCURRENT_HASHTBL_H_
+
+#include <algorithm>   // std::sort, std::unique, std::min, std::max
+#include <atomic>      // std::atomic
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uintptr_t
+#include <functional>  // std::hash, std::equal_to
+#include <memory>      // std::unique_ptr
+#include <mutex>       // std::mutex, std::lock_guard, std::unique_lock
+#include <new>         // placement new
+#include <numeric>     // std::iota
+#include <stdexcept>   // std::invalid_argument
+#include <utility>     // std::move
+#include <vector>      // std::vector
+
+#include "epoch_reclaim.h"
+#include "hash_utils.h"
+
+namespace ac  // Associative container
+{
+namespace detail {
+/// Version stamp of an entry of a ConcurrentHashTbl without versions: takes no room (empty base) and does nothing.
+template <bool Versioned>
+struct VersionStamp {
+    std::uint64_t version() const { return 0; }
+    void set_version(std::uint64_t) {}
+    void bump() {}
+};
+/// Version stamp of an entry of a versioned ConcurrentHashTbl: the writes to the entry, plus where it started.
+template <>
+struct VersionStamp<true> {
+    std::uint64_t stamp{0};
+    std::uint64_t version() const { return stamp; }
+    void set_version(std::uint64_t v_) { stamp = v_; }
+    void bump() { stamp++; }
+};
+}  // namespace detail
+
+template <class Table>
+class FrontCache;
+
+/**
+ * @brief Hash table safe to use from several threads at once, with lock striping.
+ *
+ * Wrapping a HashTbl in one mutex serializes every operation. Here the buckets are shared out among a fixed set of
+ * stripes, each with its own mutex, and an operation only locks the stripe of its key, so operations on different
+ * stripes run in parallel:
+ *  - the bucket count and the stripe count are powers of two, with at least as many buckets as stripes; a key goes to
+ *    bucket `hash & (buckets - 1)` and to stripe `hash & (stripes - 1)`, so a bucket belongs to a single stripe, and
+ *    keeps it when the table doubles;
+ *  - growing does not stop the table: the larger bucket array is published next to the current one, and buckets are
+ *    moved over in chunks by every thread that writes meanwhile (a thread claims a chunk with one atomic increment, and
+ *    locks one stripe at a time while it moves it), so the work is shared by all the writers instead of falling on
+ *    one while the others wait. A moved bucket is left holding a forwarding marker, which operations follow to the
+ *    new array; the table switches over when the last chunk is done;
+ *  - transact() locks the stripes of all its keys, always in ascending order, so two transactions can never wait on
+ *    each other (no deadlock), and runs a functor on all their values at once: a transfer between two accounts is
+ *    atomic, and only blocks the operations on those two stripes.
+ * Values are handed out by copy or to a functor that runs under the lock; no pointer into the table escapes it.
+ *
+ * With Versioned set, every entry also carries a version stamp, advanced by every write to it, for optimistic
+ * concurrency: read the data and its version with retrieve_versioned(), work on the copy without holding anything,
+ * and write back with compare_and_update(), which fails if someone else wrote in between. A key erased and inserted
+ * again starts above every version it had before, so an old version can never match the new entry. The read takes no
+ * lock: writes replace the node of an entry instead of changing it, and the nodes unlinked are retired through an
+ * EpochDomain, freed once no reader can still be walking past them.
+ *
+ * Every stripe also counts the writes to its entries, in an array apart from the locks that readers can check without
+ * locking anything: a FrontCache keeps copies of hot entries per thread, valid while the count of their stripe stays.
+ */
+template <class KeyType, class DataType, class KeyHash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType>,
+          bool Versioned = false>
+class ConcurrentHashTbl {
+   public:
+    using size_type = std::size_t;
+    using key_type = KeyType;
+    using mapped_type = DataType;
+    using hasher = KeyHash;
+    using key_equal = KeyEqual;
+
+    /// Threads of a versioned table that may hold a reader handle (see epochs()) at once.
+    static constexpr size_type max_readers = 128;
+
+    /**
+     * @param buckets_ Initial number of buckets, rounded up to a power of two (and to stripes_).
+     * @param stripes_ Number of locks, a power of two. More stripes mean fewer collisions between threads, for a
+     * cache line each.
+     */
+    explicit ConcurrentHashTbl(size_type buckets_ = 64, size_type stripes_ = 64) : m_stripes(stripes_) {
+        if (stripes_ == 0 or (stripes_ & (stripes_ - 1))) throw std::invalid_argument("stripes must be a power of 2");
+        m_stripe_mask = stripes_ - 1;
+        // Aligned by hand: before C++17, new ignores the alignment of Stripe.
+        m_lock_memory.reset(new unsigned char[(stripes_ + 1) * sizeof(Stripe)]);
+        auto addr = reinterpret_cast<std::uintptr_t>(m_lock_memory.get());
+        m_locks = reinterpret_cast<Stripe*>((addr + alignof(Stripe) - 1) / alignof(Stripe) * alignof(Stripe));
+        for (size_type s{0}; s < stripes_; s++) new (m_locks + s) Stripe();
+        m_writes.reset(new std::atomic<std::uint64_t>[stripes_]);
+        for (size_type s{0}; s < stripes_; s++) m_writes[s].store(0, std::memory_order_relaxed);
+        if (Versioned) {
+            // A handle per stripe retires the nodes unlinked under its lock, which serializes the use of the handle.
+            m_epochs.reset(new EpochDomain(stripes_ + max_readers));
+            for (size_type s{0}; s < stripes_; s++) m_retirers.emplace_back(new EpochDomain::Handle(*m_epochs));
+        }
+        size_type n{stripes_};
+        while (n < buckets_) n *= 2;
+        m_tables.emplace_back(new Table(n));
+        m_current.store(m_tables.back().get());
+    }
+    ~ConcurrentHashTbl() {
+        destroy_nodes();
+        for (size_type s{0}; s < m_stripes; s++) m_locks[s].~Stripe();
+    }
+    ConcurrentHashTbl(const ConcurrentHashTbl&) = delete;
+    ConcurrentHashTbl& operator=(const ConcurrentHashTbl&) = delete;
+
+    /// Inserts key_ with data_, or overwrites its data. Returns true when the key is new, as HashTbl::insert().
+    bool insert(const KeyType& key_, const DataType& data_) {
+        help_resize(false);
+        auto h = hash(key_);
+        prefetch(h);
+        Table* grow{nullptr};
+        {
+            std::lock_guard<std::mutex> guard(stripe(h).lock);
+            Node* n = find_node(key_, h);
+            wrote(h);
+            if (n) {
+                Draft d(*this, n);
+                d.data() = data_;
+                d.commit();
+                return false;
+            }
+            std::atomic<Node*>& head = bucket(h);
+            n = new Node(key_, data_, h, head.load(std::memory_order_relaxed));
+            n->set_version(stripe(h).version_floor + 1);
+            head.store(n, std::memory_order_release);
+            Table* t = m_current.load(std::memory_order_acquire);
+            Stripe& st = stripe(h);
+            auto count = st.count.load(std::memory_order_relaxed) + 1;
+            st.count.store(count, std::memory_order_relaxed);
+            if (overloaded(st, count, *t)) grow = t;
+        }
+        if (grow) start_resize(grow);
+        return true;
+    }
+
+    /// Copies the data of key_ into data_item_. Returns false when the key is not in the table.
+    bool retrieve(const KeyType& key_, DataType& data_item_) const {
+        std::uint64_t writes;
+        return retrieve_hashed(key_, hash(key_), data_item_, writes);
+    }
+
+    /// Calls fn_(data) on the data of key_, under the lock of its stripe. Returns false when the key is not there.
+    template <class Fn>
+    bool update(const KeyType& key_, Fn fn_) {
+        auto h = hash(key_);
+        prefetch(h);
+        std::lock_guard<std::mutex> guard(stripe(h).lock);
+        Node* n = find_node(key_, h);
+        if (n) {
+            Draft d(*this, n);
+            fn_(d.data());
+            d.commit();
+            wrote(h);
+        }
+        return n != nullptr;
+    }
+
+    /**
+     * @brief Copies the data of key_ into data_item_, and returns its version (see compare_and_update()).
+     *
+     * Takes no lock, pinned in the epoch domain through reader_, the handle of the calling thread (made once per
+     * thread from epochs()): the nodes it walks past are not freed meanwhile, and the data of a linked node never
+     * changes, so the copy is consistent with its version. The one thing that can mislead the walk is growth, which
+     * relinks nodes into the next array: a miss counts only if the bucket was not moved meanwhile, and is retried
+     * otherwise. A bucket caught in the middle of its move is read under the stripe lock, which the move holds.
+     *
+     * @return The version of the data copied, or 0 when the key is not in the table.
+     */
+    std::uint64_t retrieve_versioned(const KeyType& key_, DataType& data_item_, EpochDomain::Handle& reader_) const {
+        static_assert(Versioned, "retrieve_versioned() needs a ConcurrentHashTbl with Versioned set");
+        auto h = hash(key_);
+        auto guard = reader_.pin();
+        KeyEqual equal;
+        for (;;) {
+            const Table* t = m_current.load(std::memory_order_acquire);
+            Node* n = t->heads[h & t->mask].load(std::memory_order_acquire);
+            while (n == forwarded()) {
+                t = t->next.load(std::memory_order_acquire);
+                n = t->heads[h & t->mask].load(std::memory_order_acquire);
+            }
+            if (n == moving()) break;
+            for (; n; n = n->next.load(std::memory_order_acquire)) {
+                if (n->hash == h and equal(n->key, key_)) {
+                    data_item_ = n->data;
+                    return n->version();
+                }
+            }
+            // A node moved meanwhile may have led the walk into its new bucket, past the rest of this one; the move
+            // marks the bucket before it relinks any node, so the marker is seen here if that happened.
+            n = t->heads[h & t->mask].load(std::memory_order_acquire);
+            if (n != moving() and n != forwarded()) return 0;
+        }
+        std::lock_guard<std::mutex> lock(stripe(h).lock);
+        const Node* n = find_node(key_, h);
+        if (!n) return 0;
+        data_item_ = n->data;
+        return n->version();
+    }
+
+    /// Domain of the readers of retrieve_versioned(), of which every reading thread makes an EpochDomain::Handle, to
+    /// destroy before the table.
+    EpochDomain& epochs() const {
+        static_assert(Versioned, "epochs() needs a ConcurrentHashTbl with Versioned set");
+        return *m_epochs;
+    }
+
+    /**
+     * @brief Calls fn_(data) on the data of key_, under the lock of its stripe, provided nobody wrote to it since
+     * retrieve_versioned() returned expected_version_. The usual loop retries, on a fresh copy, until it succeeds.
+     *
+     * @return True when fn_ ran (and the version advanced); false when the key changed, or is gone.
+     */
+    template <class Fn>
+    bool compare_and_update(const KeyType& key_, std::uint64_t expected_version_, Fn fn_) {
+        static_assert(Versioned, "compare_and_update() needs a ConcurrentHashTbl with Versioned set");
+        auto h = hash(key_);
+        prefetch(h);
+        std::lock_guard<std::mutex> guard(stripe(h).lock);
+        Node* n = find_node(key_, h);
+        if (!n or n->version() != expected_version_) return false;
+        Draft d(*this, n);
+        fn_(d.data());
+        d.commit();
+        wrote(h);
+        return true;
+    }
+
+    /// Removes key_. Returns false when it is not in the table.
+    bool erase(const KeyType& key_) {
+        help_resize(false);
+        auto h = hash(key_);
+        prefetch(h);
+        std::lock_guard<std::mutex> guard(stripe(h).lock);
+        KeyEqual equal;
+        for (std::atomic<Node*>* link = &bucket(h); Node* dead = link->load(std::memory_order_relaxed);
+             link = &dead->next) {
+            if (dead->hash == h and equal(dead->key, key_)) {
+                link->store(dead->next.load(std::memory_order_relaxed), std::memory_order_release);
+                stripe(h).version_floor = std::max(stripe(h).version_floor, dead->version());
+                dispose(dead);
+                stripe(h).count.store(stripe(h).count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+                wrote(h);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Atomically applies fn_(data_a, data_b) to the data of two keys, such as the two accounts of a transfer.
+     * No other operation on either key can run in between, or see one of them changed and not the other.
+     *
+     * @return False, without calling fn_, when either key is not in the table. With a_ equal to b_, fn_ receives the
+     * same data twice.
+     */
+    template <class Fn>
+    bool transact(const KeyType& a_, const KeyType& b_, Fn fn_) {
+        // The general case below, without its heap allocations.
+        auto ha = hash(a_), hb = hash(b_);
+        prefetch(ha);
+        prefetch(hb);
+        size_type first = std::min(ha & m_stripe_mask, hb & m_stripe_mask);
+        size_type second = std::max(ha & m_stripe_mask, hb & m_stripe_mask);
+        std::lock_guard<std::mutex> guard_first(m_locks[first].lock);
+        std::unique_lock<std::mutex> guard_second(m_locks[second].lock, std::defer_lock);
+        if (second != first) guard_second.lock();
+        Node* a = find_node(a_, ha);
+        Node* b = a ? find_node(b_, hb) : nullptr;
+        if (!b) return false;
+        Draft da(*this, a), db(*this, b != a ? b : nullptr);
+        fn_(da.data(), (b != a ? db : da).data());
+        da.commit();
+        db.commit();
+        wrote(first);
+        if (second != first) wrote(second);
+        return true;
+    }
+
+    /**
+     * @brief Atomically applies fn_(data) to the data of n_ keys, where data[i] points to the data of keys_[i].
+     *
+     * @return False, without calling fn_, when a key is not in the table.
+     */
+    template <class Fn>
+    bool transact(const KeyType* keys_, size_type n_, Fn fn_) {
+        std::vector<size_type> hashes(n_), order(n_);
+        for (size_type i{0}; i < n_; i++) {
+            hashes[i] = hash(keys_[i]);
+            order[i] = hashes[i] & m_stripe_mask;
+            prefetch(hashes[i]);
+        }
+        // The stripes to lock, once each, in the global (ascending) order.
+        std::sort(order.begin(), order.end());
+        order.erase(std::unique(order.begin(), order.end()), order.end());
+        StripeLocks locks(*this, order);
+
+        std::vector<Node*> nodes(n_);
+        for (size_type i{0}; i < n_; i++) {
+            nodes[i] = find_node(keys_[i], hashes[i]);
+            if (!nodes[i]) return false;
+        }
+        // One draft per node: a key given twice has both its pointers on the same data, and is written once.
+        std::vector<size_type> by_node(n_);
+        std::iota(by_node.begin(), by_node.end(), size_type{0});
+        std::sort(by_node.begin(), by_node.end(), [&](size_type i_, size_type j_) {
+            return std::less<Node*>()(nodes[i_], nodes[j_]);
+        });
+        std::vector<std::unique_ptr<Draft> > drafts;
+        std::vector<DataType*> data(n_);
+        for (size_type k{0}; k < n_; k++) {
+            auto i = by_node[k];
+            if (k == 0 or nodes[i] != nodes[by_node[k - 1]]) drafts.emplace_back(new Draft(*this, nodes[i]));
+            data[i] = &drafts.back()->data();
+        }
+        fn_(static_cast<DataType* const*>(data.data()));
+        for (auto& d : drafts) d->commit();
+        for (auto s : order) wrote(s);
+        return true;
+    }
+
+    /// Number of elements. Exact when no other thread is modifying the table.
+    size_type size() const {
+        size_type total{0};
+        for (size_type s{0}; s < m_stripes; s++) {
+            std::lock_guard<std::mutex> guard(m_locks[s].lock);
+            total += m_locks[s].count.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+    bool empty() const { return size() == 0; }
+    /// Number of buckets (a power of two). While the table grows, the number before.
+    size_type bucket_count() const { return m_current.load()->mask + 1; }
+    /// Number of stripes (locks).
+    size_type stripe_count() const { return m_stripes; }
+
+    /// Calls fn_(key, data) for every element, one stripe at a time: the traversal is not a snapshot of the table.
+    template <class Fn>
+    void for_each(Fn fn_) const {
+        for (size_type s{0}; s < m_stripes; s++) {
+            std::lock_guard<std::mutex> guard(m_locks[s].lock);
+            const Table& t = *m_current.load(std::memory_order_acquire);
+            for (size_type b{s}; b <= t.mask; b += m_stripes) for_each_in(t, b, fn_);
+        }
+    }
+
+   private:
+    struct Node : detail::VersionStamp<Versioned> {
+        KeyType key;
+        DataType data;
+        size_type hash;  //!< Kept to rehash without calling KeyHash, and to skip most key compares.
+        std::atomic<Node*> next;  //!< Written under the stripe lock; read without it by retrieve_versioned().
+        Node(const KeyType& key_, const DataType& data_, size_type hash_, Node* next_)
+            : key(key_), data(data_), hash(hash_), next(next_) {}
+    };
+    /// A lock with the element count of its buckets, on a cache line of its own so that threads working on different
+    /// stripes do not invalidate each other's line.
+    struct alignas(64) Stripe {
+        std::mutex lock;
+        std::atomic<size_type> count{0};  //!< Written under the lock; read without it to sum the load of the table.
+        size_type recheck_at{0};          //!< Count at which the stripe next sums the load (see overloaded()).
+        std::uint64_t version_floor{0};  //!< Highest version of an entry erased from the stripe; new ones start above.
+    };
+    /// Holds the locks of a set of stripes, taken in the order given (ascending), released in reverse.
+    class StripeLocks {
+       public:
+        StripeLocks(const ConcurrentHashTbl& tbl_, const std::vector<size_type>& stripes_)
+            : m_tbl(tbl_), m_held(stripes_) {
+            for (auto s : m_held) m_tbl.m_locks[s].lock.lock();
+        }
+        ~StripeLocks() {
+            for (auto s = m_held.rbegin(); s != m_held.rend(); ++s) m_tbl.m_locks[*s].lock.unlock();
+        }
+        StripeLocks(const StripeLocks&) = delete;
+        StripeLocks& operator=(const StripeLocks&) = delete;
+
+       private:
+        const ConcurrentHashTbl& m_tbl;
+        std::vector<size_type> m_held;
+    };
+
+    /// A bucket array. Replaced ones are kept until the table is destroyed (they hold half the buckets of the next one,
+    /// so all of them together are never larger than the current one): a thread may still be following their
+    /// forwarding markers, or prefetching from them.
+    struct Table {
+        size_type mask;  //!< Number of buckets - 1.
+        /// Collision lists; bucket b is written under stripe b & m_stripe_mask, and read without it by
+        /// retrieve_versioned().
+        std::unique_ptr<std::atomic<Node*>[]> heads;
+        std::atomic<Table*> next{nullptr};   //!< The array this one is being moved to, once growth started.
+        std::atomic<size_type> claimed{0};   //!< Buckets handed out to the threads moving them.
+        std::atomic<size_type> migrated{0};  //!< Buckets moved.
+        explicit Table(size_type buckets_) : mask(buckets_ - 1), heads(new std::atomic<Node*>[buckets_]) {
+            for (size_type b{0}; b < buckets_; b++) heads[b].store(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+    static constexpr double max_load = 1.0;  //!< Elements per bucket that trigger growth.
+    /// Buckets moved per claim: enough to amortize the claim and the stripe locks, few enough to share the work out.
+    static constexpr size_type migration_chunk = 4096;
+
+    size_type m_stripes, m_stripe_mask;
+    std::unique_ptr<unsigned char[]> m_lock_memory;  //!< Holds the stripes, with room to align them to a cache line.
+    Stripe* m_locks;
+    std::vector<std::unique_ptr<Table> > m_tables;  //!< Every bucket array so far; the last one is in use.
+    std::atomic<Table*> m_current{nullptr};        //!< Array in use; while growing, the one being moved.
+    std::mutex m_resize_lock;                       //!< Serializes starting to grow, and guards m_tables.
+    /// Writes to the entries of each stripe. Packed: they change far less often than the locks, which they do not
+    /// share a line with, so checking one does not pull in the line of a lock that other threads keep taking.
+    std::unique_ptr<std::atomic<std::uint64_t>[]> m_writes;
+    std::unique_ptr<EpochDomain> m_epochs;  //!< Versioned only: pins the readers, frees the retired nodes.
+    std::vector<std::unique_ptr<EpochDomain::Handle> > m_retirers;  //!< Versioned only: one per stripe.
+
+    template <class Table_>
+    friend class FrontCache;
+
+    /// The bucket and stripe are taken from the low bits, so the hash is mixed: std::hash of an int is the int itself.
+    static size_type hash(const KeyType& key_) { return static_cast<size_type>(hash_mix(KeyHash()(key_))); }
+    Stripe& stripe(size_type hash_) const { return m_locks[hash_ & m_stripe_mask]; }
+
+    /// Counts a write to the stripe of hash_ (the low bits are the stripe index), whose lock must be held.
+    void wrote(size_type hash_) {
+        auto& w = m_writes[hash_ & m_stripe_mask];
+        // Under the lock, no other thread writes it: a plain increment, published to the readers that check it.
+        w.store(w.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    /// Writes so far to the stripe of hash_. Needs no lock.
+    std::uint64_t writes(size_type hash_) const {
+        return m_writes[hash_ & m_stripe_mask].load(std::memory_order_acquire);
+    }
+
+    /// retrieve() of key_, whose hash is hash_; also copies the write count of its stripe, read under the same lock.
+    bool retrieve_hashed(const KeyType& key_, size_type hash_, DataType& data_item_, std::uint64_t& writes_) const {
+        prefetch(hash_);
+        std::lock_guard<std::mutex> guard(stripe(hash_).lock);
+        const Node* n = find_node(key_, hash_);
+        if (n) data_item_ = n->data;
+        writes_ = m_writes[hash_ & m_stripe_mask].load(std::memory_order_relaxed);
+        return n != nullptr;
+    }
+
+    /// Marks a bucket moved to the next array. Never dereferenced.
+    static Node* forwarded() {
+        static char tag;
+        return reinterpret_cast<Node*>(&tag);
+    }
+    /// Marks a bucket while it is moved to the next array, under its stripe lock. Never dereferenced.
+    static Node* moving() {
+        static char tag;
+        return reinterpret_cast<Node*>(&tag);
+    }
+
+    /// Head of the bucket of hash_, following the forwarding markers of moved buckets. The stripe of hash_ must be
+    /// locked: buckets are only moved under it.
+    std::atomic<Node*>& bucket(size_type hash_) const {
+        Table* t = m_current.load(std::memory_order_acquire);
+        while (t->heads[hash_ & t->mask].load(std::memory_order_relaxed) == forwarded())
+            t = t->next.load(std::memory_order_acquire);
+        return t->heads[hash_ & t->mask];
+    }
+    /**
+     * @brief Starts loading the lock and the bucket of hash_ before waiting for the lock. Taking a lock is a full
+     * barrier, so the cache misses behind it would otherwise not start until it is held. Runs unlocked: a resize may
+     * swap the array meanwhile, which only makes the hint useless.
+     */
+    void prefetch(size_type hash_) const {
+#if defined(__GNUC__)
+        const Table& t = *m_current.load(std::memory_order_acquire);
+        __builtin_prefetch(&t.heads[hash_ & t.mask]);
+        __builtin_prefetch(&stripe(hash_), 1);
+#else
+        (void)hash_;
+#endif
+    }
+
+    /// Node of key_ in its bucket, or nullptr. The stripe of hash_ must be locked.
+    Node* find_node(const KeyType& key_, size_type hash_) const {
+        KeyEqual equal;
+        for (Node* n = bucket(hash_).load(std::memory_order_relaxed); n; n = n->next.load(std::memory_order_relaxed))
+            if (n->hash == hash_ and equal(n->key, key_)) return n;
+        return nullptr;
+    }
+
+    /**
+     * @brief A write to the data of a node, whose stripe is locked: commit() applies it and advances the version.
+     *
+     * Versioned tables are read without the lock, so there the data of a linked node must not change under a reader:
+     * the write goes to a copy, which commit() links in the place of the node, and the node is retired. A draft
+     * dropped before commit() (the functor threw) leaves the entry as it was. Without versions, it is the node itself.
+     */
+    class Draft {
+       public:
+        /// A draft of n_; of nothing, with commit() doing nothing, when n_ is null.
+        Draft(ConcurrentHashTbl& tbl_, Node* n_) : m_tbl(tbl_), m_node(n_), m_copy(nullptr) {
+            if (Versioned and n_) {
+                m_copy = new Node(n_->key, n_->data, n_->hash, nullptr);
+                m_copy->set_version(n_->version());
+            }
+        }
+        ~Draft() { delete m_copy; }
+        Draft(const Draft&) = delete;
+        Draft& operator=(const Draft&) = delete;
+
+        DataType& data() { return (m_copy ? m_copy : m_node)->data; }
+        void commit() {
+            if (!m_copy) {
+                if (m_node) m_node->bump();
+                return;
+            }
+            m_copy->bump();
+            m_tbl.replace(m_node, m_copy);
+            m_copy = nullptr;
+        }
+
+       private:
+        ConcurrentHashTbl& m_tbl;
+        Node* m_node;
+        Node* m_copy;  //!< Versioned only; owned until committed.
+    };
+
+    /// Links copy_ in the place of n_ in its bucket, and retires n_. The stripe of n_ must be locked.
+    void replace(Node* n_, Node* copy_) {
+        std::atomic<Node*>* link = &bucket(n_->hash);
+        while (link->load(std::memory_order_relaxed) != n_) link = &link->load(std::memory_order_relaxed)->next;
+        copy_->next.store(n_->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        link->store(copy_, std::memory_order_release);
+        dispose(n_);
+    }
+
+    /// Frees n_, unlinked from its bucket (the stripe locked); in a versioned table, once no reader can hold it.
+    void dispose(Node* n_) {
+        if (!Versioned) {
+            delete n_;
+            return;
+        }
+        // The unlink must be visible before the epoch is read: a reader pinned after the epoch moved on must not
+        // find n_, which may then be freed under it.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_retirers[n_->hash & m_stripe_mask]->retire(n_);
+    }
+
+    /**
+     * @brief Whether t_ holds more than max_load elements per bucket, checked by stripe st_ (locked), which has just
+     * grown to count_ elements.
+     *
+     * The counts of all the stripes are only summed once st_ is over its share of the load, and then not again until
+     * enough elements were added to it for the table to be over with keys spread evenly: a stripe that a few keys
+     * happen to favour neither grows the table on its own nor scans the stripes on every insert.
+     */
+    bool overloaded(Stripe& st_, size_type count_, const Table& t_) const {
+        double limit = max_load * (t_.mask + 1);
+        if (count_ <= limit / m_stripes or count_ < st_.recheck_at) return false;
+        size_type total{0};
+        for (size_type s{0}; s < m_stripes; s++) total += m_locks[s].count.load(std::memory_order_relaxed);
+        if (total > limit) return true;
+        st_.recheck_at = count_ + 1 + static_cast<size_type>((limit - total) / m_stripes);
+        return false;
+    }
+
+    /**
+     * @brief Publishes an array twice the size of full_, which was found overloaded, unless the table already grew
+     * past it; then moves buckets over until every chunk is claimed. Whoever finds the table overloaded keeps moving
+     * buckets until none is left to claim, so growth completes even if no other thread writes.
+     */
+    void start_resize(Table* full_) {
+        if (!full_->next.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> guard(m_resize_lock);
+            if (m_current.load() == full_ and !full_->next.load()) {
+                m_tables.emplace_back(new Table(2 * (full_->mask + 1)));
+                full_->next.store(m_tables.back().get(), std::memory_order_release);
+            }
+        }
+        help_resize(true);
+    }
+
+    /// If the table is growing, moves one chunk of buckets to the new array (with all_, chunks until none is left).
+    void help_resize(bool all_) {
+        Table* t = m_current.load(std::memory_order_acquire);
+        Table* n = t->next.load(std::memory_order_acquire);
+        if (!n) return;
+        // A multiple of the stripe count: the chunk then holds the same number of buckets of every stripe.
+        size_type size = t->mask + 1, chunk = std::min(size, std::max(migration_chunk, m_stripes));
+        do {
+            size_type first = t->claimed.fetch_add(chunk);
+            if (first >= size) return;
+            migrate(*t, *n, first, first + chunk);
+            if (t->migrated.fetch_add(chunk) + chunk == size) m_current.store(n, std::memory_order_release);
+        } while (all_);
+    }
+
+    /// Moves the buckets [first_, last_) of from_ to to_, twice its size, one stripe at a time.
+    void migrate(Table& from_, Table& to_, size_type first_, size_type last_) {
+        for (size_type s{0}; s < m_stripes; s++) {
+            std::lock_guard<std::mutex> guard(m_locks[s].lock);
+            // first_ is a multiple of the stripe count: these are the buckets of stripe s, and so are the two buckets,
+            // b and b + size, that each of them splits into.
+            for (size_type b{first_ + s}; b < last_; b += m_stripes) {
+                // Marked before any node is relinked: a reader led away by a relinked node then sees the marker once
+                // it reaches the end of the list (see retrieve_versioned()). The release stores below publish it.
+                Node* head = from_.heads[b].load(std::memory_order_relaxed);
+                from_.heads[b].store(moving(), std::memory_order_relaxed);
+                while (head) {
+                    Node* n = head;
+                    head = n->next.load(std::memory_order_relaxed);
+                    std::atomic<Node*>& to = to_.heads[n->hash & to_.mask];
+                    n->next.store(to.load(std::memory_order_relaxed), std::memory_order_release);
+                    to.store(n, std::memory_order_release);
+                }
+                from_.heads[b].store(forwarded(), std::memory_order_release);
+            }
+        }
+    }
+
+    /// Calls fn_(key, data) for every element of bucket b_ of t_, or of the buckets it was moved to.
+    template <class Fn>
+    void for_each_in(const Table& t_, size_type b_, Fn& fn_) const {
+        const Node* head = t_.heads[b_].load(std::memory_order_relaxed);
+        if (head == forwarded()) {
+            const Table& n = *t_.next.load(std::memory_order_acquire);
+            for_each_in(n, b_, fn_);
+            for_each_in(n, b_ + t_.mask + 1, fn_);
+            return;
+        }
+        for (const Node* n = head; n; n = n->next.load(std::memory_order_relaxed))
+            fn_(static_cast<const KeyType&>(n->key), n->data);
+    }
+
+    /// Frees every linked node (the domain frees the retired ones). Each one is in a single array, in a bucket that was
+    /// not moved.
+    void destroy_nodes() {
+        for (const auto& t : m_tables) {
+            for (size_type b{0}; b <= t->mask; b++) {
+                Node* head = t->heads[b].load(std::memory_order_relaxed);
+                if (head == forwarded()) continue;
+                while (head) {
+                    Node* n = head;
+                    head = n->next.load(std::memory_order_relaxed);
+                    delete n;
+                }
+            }
+        }
+    }
+};
+
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, bool Versioned>
+constexpr typename ConcurrentHashTbl<KeyType, DataType, KeyHash, KeyEqual, Versioned>::size_type
+    ConcurrentHashTbl<KeyType, DataType, KeyHash, KeyEqual, Versioned>::max_readers;
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, bool Versioned>
+constexpr double ConcurrentHashTbl<KeyType, DataType, KeyHash, KeyEqual, Versioned>::max_load;
+template <class KeyType, class DataType, class KeyHash, class KeyEqual, bool Versioned>
+constexpr typename ConcurrentHashTbl<KeyType, DataType, KeyHash, KeyEqual, Versioned>::size_type
+    ConcurrentHashTbl<KeyType, DataType, KeyHash, KeyEqual, Versioned>::migration_chunk;
+
+}  // namespace ac
+#endif
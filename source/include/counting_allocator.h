@@ -0,0 +1,84 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _COUNTING_ALLOCATOR_H_
+#define _COUNTING_ALLOCATOR_H_
+
+#include <atomic>   // std::atomic
+#include <cstddef>  // std::size_t
+#include <new>      // ::operator new
+
+namespace ac  // Associative container
+{
+/// Allocation counters shared by all CountingAllocator instances with the same tag.
+struct AllocStats {
+    std::atomic<std::size_t> allocations{0};    //!< Calls to allocate().
+    std::atomic<std::size_t> deallocations{0};  //!< Calls to deallocate().
+    std::atomic<std::size_t> bytes_in_use{0};   //!< Bytes currently allocated.
+    std::atomic<std::size_t> peak_bytes{0};     //!< Highest bytes_in_use since the last reset().
+
+    /// Clears the counters; the peak restarts from the bytes still in use.
+    void reset() {
+        allocations = 0;
+        deallocations = 0;
+        peak_bytes = bytes_in_use.load();
+    }
+};
+
+/// Counters of a tag. Each tag type gets its own, so independent containers can be measured separately.
+template <class Tag>
+AllocStats& alloc_stats() {
+    static AllocStats stats;
+    return stats;
+}
+
+/**
+ * @brief Standard allocator that counts allocations and tracks current and peak bytes. It is stateless: the counters
+ * live in alloc_stats<Tag>(), so every container (and every rebound copy) with the same tag reports to the same place.
+ *
+ * Usage: `ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::NullObserver,
+ * ac::CountingAllocator<ac::HashEntry<int, int>, MyTag> >`, then read `ac::alloc_stats<MyTag>()`.
+ */
+template <class T, class Tag = void>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <class U>
+    CountingAllocator(const CountingAllocator<U, Tag>&) {}
+
+    T* allocate(std::size_t n_) {
+        auto bytes = n_ * sizeof(T);
+        T* p = static_cast<T*>(::operator new(bytes));
+        auto& stats = alloc_stats<Tag>();
+        stats.allocations.fetch_add(1, std::memory_order_relaxed);
+        auto in_use = stats.bytes_in_use.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        auto peak = stats.peak_bytes.load(std::memory_order_relaxed);
+        while (in_use > peak and !stats.peak_bytes.compare_exchange_weak(peak, in_use, std::memory_order_relaxed)) {
+        }
+        return p;
+    }
+
+    void deallocate(T* p_, std::size_t n_) {
+        auto& stats = alloc_stats<Tag>();
+        stats.deallocations.fetch_add(1, std::memory_order_relaxed);
+        stats.bytes_in_use.fetch_sub(n_ * sizeof(T), std::memory_order_relaxed);
+        ::operator delete(p_);
+    }
+
+    template <class U>
+    struct rebind {
+        using other = CountingAllocator<U, Tag>;
+    };
+};
+
+template <class T, class U, class Tag>
+bool operator==(const CountingAllocator<T, Tag>&, const CountingAllocator<U, Tag>&) {
+    return true;
+}
+template <class T, class U, class Tag>
+bool operator!=(const CountingAllocator<T, Tag>&, const CountingAllocator<U, Tag>&) {
+    return false;
+}
+
+}  // namespace ac
+#endif
@@ -0,0 +1,282 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _DEDUP_FILTER_H_
+#define _DEDUP_FILTER_H_
+
+#include <algorithm>    // std::min, std::fill
+#include <cstddef>      // std::size_t
+#include <cstdint>      // std::uint16_t, std::uint32_t, std::uint64_t, std::uintptr_t
+#include <memory>       // std::unique_ptr
+#include <stdexcept>    // std::invalid_argument
+#include <type_traits>  // std::is_same
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // SSE2 compares of a bucket
+#endif
+
+namespace ac  // Associative container
+{
+/**
+ * @brief Streaming "seen before?" filter for 64-bit ids (transaction ids, say) over a sliding window.
+ *
+ * A HashTbl of every id ever seen grows without bound, and stores whole keys in list nodes. This filter keeps only a
+ * short fingerprint of each id, in a fixed-size table of 64-byte buckets (one cache line each): an id hashes to one
+ * bucket, and answering is one scan of that line. A bucket that fills up spills into the next one and marks itself,
+ * so only ids of the few spilled buckets need a second (adjacent) line. The price is a small rate of false positives
+ * (a new id whose fingerprint collides with one in its buckets is taken for a duplicate); it never misses a duplicate
+ * still in the window, unless both buckets were full (see evictions()).
+ *
+ * Memory and accuracy are traded through Slot, the storage of one fingerprint:
+ *  - std::uint16_t: 31 ids per bucket, 12-bit fingerprints, about 2.7 bytes per id at the design load, a false
+ *    positive rate around 0.6%;
+ *  - std::uint32_t: 15 ids per bucket, 28-bit fingerprints, about 5.3 bytes per id, around one in 20 million.
+ *
+ * Expiry is by generations: the ids of the last `window` generations are remembered. A generation ends after
+ * ids_per_generation new ids, or when rotate() is called (with auto_rotate false, e.g. to rotate on a timer; the table
+ * is still sized for ids_per_generation ids per generation).
+ * Each slot carries the 4-bit number of the generation that wrote it; rotating frees the slots of the generation that
+ * fell out of the window, so the slots still in use are always live and lookups need not check ages.
+ */
+template <class Slot = std::uint16_t>
+class DedupFilter {
+    static_assert(std::is_same<Slot, std::uint16_t>::value or std::is_same<Slot, std::uint32_t>::value,
+                  "DedupFilter slots are std::uint16_t or std::uint32_t");
+
+   public:
+    using size_type = std::size_t;
+    static constexpr unsigned slots_per_bucket = 64 / sizeof(Slot);
+    static constexpr unsigned id_slots = slots_per_bucket - 1;  //!< Slot 0 of a bucket is its overflow marker.
+    static constexpr unsigned fingerprint_bits = 8 * sizeof(Slot) - 4;
+    /// Generations a window can span (the generation tag has 4 bits, and one value is kept free for the one expiring).
+    static constexpr unsigned max_window = 15;
+
+    /**
+     * @param ids_per_generation_ Distinct ids expected per generation, at least 1: it sizes the table. With
+     * auto-rotation, it is also the length of a generation.
+     * @param window_ Number of generations remembered, 1 to max_window.
+     * @param auto_rotate_ Whether to rotate after ids_per_generation_ new ids; otherwise only rotate() does.
+     */
+    explicit DedupFilter(size_type ids_per_generation_, unsigned window_ = 4, bool auto_rotate_ = true)
+        : m_per_generation(ids_per_generation_), m_window(window_), m_auto_rotate(auto_rotate_) {
+        if (ids_per_generation_ == 0) throw std::invalid_argument("DedupFilter: no ids expected per generation");
+        if (window_ == 0 or window_ > max_window) throw std::invalid_argument("DedupFilter: window out of range");
+        // Sized for a full window at design_load, rounded up to a power of two buckets.
+        double slots = static_cast<double>(ids_per_generation_) * window_ / design_load;
+        m_buckets = 1;
+        while (m_buckets * id_slots < slots) m_buckets *= 2;
+        m_mask = m_buckets - 1;
+        m_memory.reset(new unsigned char[m_buckets * sizeof(Bucket) + alignof(Bucket)]);
+        auto addr = reinterpret_cast<std::uintptr_t>(m_memory.get());
+        m_table = reinterpret_cast<Bucket*>((addr + alignof(Bucket) - 1) / alignof(Bucket) * alignof(Bucket));
+        std::fill(m_table, m_table + m_buckets, Bucket());
+    }
+
+    /// Whether id_ was inserted during the window (or collides with an id that was).
+    bool contains(std::uint64_t id_) const {
+        auto h = mix(id_);
+        return find_hashed(h & m_mask, fingerprint(h));
+    }
+
+    /**
+     * @brief Records id_. Returns true when it is new to the window, false when it is a duplicate (or a false positive).
+     */
+    bool insert(std::uint64_t id_) {
+        auto h = mix(id_);
+        return insert_hashed(h & m_mask, fingerprint(h));
+    }
+
+    /**
+     * @brief Same as insert() for n_ ids, fresh_[i] receiving the result for ids_[i]; fresh_ may be null. The buckets
+     * of a group of ids are prefetched before any is touched, so their cache misses overlap.
+     * @return Number of new ids.
+     */
+    size_type insert_batch(const std::uint64_t* ids_, size_type n_, bool* fresh_ = nullptr) {
+        const size_type group = 32;
+        std::uint64_t hashes[group];
+        size_type added{0};
+        for (size_type first{0}; first < n_; first += group) {
+            size_type last = std::min(n_, first + group);
+            for (size_type i{first}; i < last; i++) {
+                hashes[i - first] = mix(ids_[i]);
+#if defined(__GNUC__)
+                __builtin_prefetch(&m_table[hashes[i - first] & m_mask]);
+#endif
+            }
+            for (size_type i{first}; i < last; i++) {
+                auto h = hashes[i - first];
+                bool is_new = insert_hashed(h & m_mask, fingerprint(h));
+                if (fresh_) fresh_[i] = is_new;
+                added += is_new;
+            }
+        }
+        return added;
+    }
+
+    /// Starts a new generation, forgetting the ids of the oldest one of the window.
+    void rotate() {
+        m_generation = (m_generation + 1) & gen_mask;
+        m_in_generation = 0;
+        // The tag about to be reused by the window sliding forward.
+        Slot expiring = static_cast<Slot>((m_generation + gen_mask + 1 - m_window) & gen_mask);
+#if defined(__SSE2__)
+        // A pass over the whole table; sixteen bytes at a time, it runs at about the speed of memory.
+        const __m128i tag = splat(expiring), tags = splat(gen_mask);
+        auto line = reinterpret_cast<__m128i*>(m_table), end = reinterpret_cast<__m128i*>(m_table + m_buckets);
+        for (; line < end; line++) {
+            __m128i v = _mm_load_si128(line);
+            _mm_store_si128(line, _mm_andnot_si128(cmpeq(_mm_and_si128(v, tags), tag), v));
+        }
+#else
+        for (size_type b{0}; b < m_buckets; b++)
+            for (auto& s : m_table[b].slots)
+                if ((s & gen_mask) == expiring) s = 0;
+#endif
+    }
+
+    /// Live ids that were dropped because their bucket was full; each may let one duplicate through.
+    size_type evictions() const { return m_evictions; }
+    /// Bytes of the fingerprint table.
+    size_type memory_bytes() const { return m_buckets * sizeof(Bucket); }
+    /// Number of ids the table holds at its design load.
+    size_type capacity() const { return static_cast<size_type>(m_buckets * id_slots * design_load); }
+    /// False positive rate to expect at the design load: live slots of a bucket over the fingerprint space.
+    double expected_false_positive_rate() const { return id_slots * design_load / (1u << fingerprint_bits); }
+
+   private:
+    struct alignas(64) Bucket {
+        Slot slots[slots_per_bucket]{};
+    };
+
+    static constexpr Slot gen_mask = 0xf;  //!< Low 4 bits of a slot: generation; the rest: fingerprint. 0 = empty.
+    static constexpr Slot overflow_flag = 0x10;  //!< Slot 0 of a bucket: set, with a generation, once it spilled.
+    static constexpr double design_load = 0.75;
+
+    size_type m_per_generation;
+    unsigned m_window;
+    bool m_auto_rotate;
+    size_type m_buckets{0}, m_mask{0};
+    std::unique_ptr<unsigned char[]> m_memory;  //!< Holds the table, with room to align it to a cache line.
+    Bucket* m_table{nullptr};
+    unsigned m_generation{0};
+    size_type m_in_generation{0};  //!< New ids in the current generation.
+    size_type m_evictions{0};
+
+    /// Murmur3 finalizer: every bit of the id reaches the bucket index (low bits) and the fingerprint (high bits).
+    static std::uint64_t mix(std::uint64_t k_) {
+        k_ ^= k_ >> 33;
+        k_ *= UINT64_C(0xff51afd7ed558ccd);
+        k_ ^= k_ >> 33;
+        k_ *= UINT64_C(0xc4ceb9fe1a85ec53);
+        k_ ^= k_ >> 33;
+        return k_;
+    }
+    /// Fingerprint from the high bits of the hash, in place above the generation tag; never 0.
+    static Slot fingerprint(std::uint64_t h_) {
+        auto fp = static_cast<Slot>((h_ >> (64 - fingerprint_bits)) << 4);
+        return fp ? fp : static_cast<Slot>(1u << 4);
+    }
+
+    Bucket& next(size_type b_) const { return m_table[(b_ + 1) & m_mask]; }
+
+    /**
+     * @brief Bit i set when slot i of the bucket, masked with mask_, equals value_ (slot 0, the overflow marker, is
+     * never reported). With SSE2 the line is compared in four instructions; the loop is the portable equivalent.
+     */
+    static std::uint32_t match(const Bucket& b_, Slot value_, Slot mask_) {
+#if defined(__SSE2__)
+        const __m128i* line = reinterpret_cast<const __m128i*>(b_.slots);
+        __m128i m[4];
+        for (int q{0}; q < 4; q++) {
+            __m128i v = _mm_and_si128(_mm_load_si128(line + q), splat(mask_));
+            m[q] = cmpeq(v, splat(value_));
+        }
+        std::uint32_t bits;
+        if (sizeof(Slot) == 2) {
+            // Narrowed to one byte per slot: 16 slots per movemask.
+            bits = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(m[0], m[1]))) |
+                   static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(m[2], m[3]))) << 16;
+        } else {
+            bits = 0;
+            for (int q{0}; q < 4; q++)
+                bits |= static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(m[q]))) << (4 * q);
+        }
+        return bits & ~1u;
+#else
+        std::uint32_t bits{0};
+        for (unsigned i{1}; i < slots_per_bucket; i++)
+            bits |= static_cast<std::uint32_t>((b_.slots[i] & mask_) == value_) << i;
+        return bits;
+#endif
+    }
+#if defined(__SSE2__)
+    static __m128i splat(Slot v_) { return sizeof(Slot) == 2 ? _mm_set1_epi16(v_) : _mm_set1_epi32(v_); }
+    static __m128i cmpeq(__m128i a_, __m128i b_) {
+        return sizeof(Slot) == 2 ? _mm_cmpeq_epi16(a_, b_) : _mm_cmpeq_epi32(a_, b_);
+    }
+#endif
+
+    /// Whether fp_ is in the bucket.
+    static bool find(const Bucket& b_, Slot fp_) { return match(b_, fp_, static_cast<Slot>(~gen_mask)) != 0; }
+    /// Whether fp_ is in bucket b_ or, if b_ overflowed, in its neighbor.
+    bool find_hashed(size_type b_, Slot fp_) const {
+        return find(m_table[b_], fp_) or (m_table[b_].slots[0] and find(next(b_), fp_));
+    }
+    /// Stores tagged_ in a free slot of b_. Returns false when b_ is full.
+    static bool place(Bucket& b_, Slot tagged_) {
+        std::uint32_t free_slots = match(b_, 0, static_cast<Slot>(~Slot(0)));
+        if (!free_slots) return false;
+        b_.slots[lowest_bit(free_slots)] = tagged_;
+        return true;
+    }
+    static unsigned lowest_bit(std::uint32_t bits_) {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_ctz(bits_));
+#else
+        unsigned i{0};
+        while (!(bits_ >> i & 1)) i++;
+        return i;
+#endif
+    }
+
+    bool insert_hashed(size_type b_, Slot fp_) {
+        if (find_hashed(b_, fp_)) return false;
+        if (m_auto_rotate and m_in_generation == m_per_generation) rotate();
+        m_in_generation++;
+        Slot tagged = static_cast<Slot>(fp_ | m_generation);
+        auto& home = m_table[b_];
+        if (place(home, tagged)) return true;
+        // Full bucket: spill into the next one, and mark the overflow with the current generation, so that it expires
+        // with the youngest id spilled.
+        if (place(next(b_), tagged)) {
+            home.slots[0] = static_cast<Slot>(overflow_flag | m_generation);
+            return true;
+        }
+        // Both full: the oldest id of the home bucket makes room.
+        unsigned victim{1}, oldest{0};
+        for (unsigned i{1}; i < slots_per_bucket; i++) {
+            unsigned age = (m_generation - (home.slots[i] & gen_mask)) & gen_mask;
+            if (age > oldest) oldest = age, victim = i;
+        }
+        home.slots[victim] = tagged;
+        m_evictions++;
+        return true;
+    }
+};
+
+template <class Slot>
+constexpr unsigned DedupFilter<Slot>::slots_per_bucket;
+template <class Slot>
+constexpr unsigned DedupFilter<Slot>::id_slots;
+template <class Slot>
+constexpr unsigned DedupFilter<Slot>::fingerprint_bits;
+template <class Slot>
+constexpr unsigned DedupFilter<Slot>::max_window;
+template <class Slot>
+constexpr Slot DedupFilter<Slot>::gen_mask;
+template <class Slot>
+constexpr Slot DedupFilter<Slot>::overflow_flag;
+template <class Slot>
+constexpr double DedupFilter<Slot>::design_load;
+
+}  // namespace ac
+#endif
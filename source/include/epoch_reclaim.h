@@ -0,0 +1,265 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _EPOCH_RECLAIM_H_
+#define _EPOCH_RECLAIM_H_
+
+#include <algorithm>  // std::sort, std::binary_search, std::max
+#include <atomic>     // std::atomic, std::atomic_thread_fence
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uint64_t, std::uintptr_t
+#include <memory>     // std::unique_ptr
+#include <mutex>      // std::mutex, std::lock_guard
+#include <new>        // placement new
+#include <stdexcept>  // std::runtime_error
+#include <vector>     // std::vector
+
+namespace ac  // Associative container
+{
+/**
+ * @brief Epoch-based reclamation (EBR): frees the nodes, bucket arrays... a lock-free container unlinks, once no
+ * thread can still be reading them.
+ *
+ * A lock-free reader holds no lock the writer could wait on, so the writer cannot tell when a node it unlinked is no
+ * longer in use. Here readers announce when they may be holding pointers into the container, and the writer retires
+ * the node instead of deleting it:
+ *  - a global epoch counter advances only when every thread inside a read-side section (pinned) has announced the
+ *    current epoch. A node retired in epoch e was unreachable before any thread pinned in e + 1, so once the epoch
+ *    reaches e + 2 nobody can hold it and it is freed;
+ *  - announcements are per thread, one cache line each, written by their owner only: pinning costs a store and a
+ *    fence, with no shared counter to contend on. Nested pins cost nothing, so a batch of lookups pinned once pays
+ *    the fence once (see bench/bench_epoch.cpp);
+ *  - retired nodes go to a list of the retiring thread and are freed in batches (see the batch_ parameter): advancing
+ *    the epoch scans every announcement, which is paid once per batch instead of once per node;
+ *  - a reader that stays inside one section for long (a full scan, say) would hold the epoch back, and with it every
+ *    node retired meanwhile. Such a reader uses hazard pointers instead: protect() publishes the one pointer it is
+ *    using, and a retired node is not freed while a hazard pointer names it, whatever the epoch.
+ *
+ * Each thread works through a Handle of its own, which claims one of the thread slots of the domain:
+ * ```
+ *  EpochDomain::Handle h(domain);
+ *  { auto guard = h.pin(); Node* n = head.load(); ... }  // n may be used until the guard goes
+ *  h.retire(unlinked);                                    // deleted once no reader can see it
+ * ```
+ * The domain must outlive its handles; it frees what is still retired when it is destroyed.
+ */
+class EpochDomain {
+   public:
+    using size_type = std::size_t;
+    static constexpr unsigned hazards_per_thread = 2;  //!< Hazard pointers of a Handle.
+
+   private:
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+        std::uint64_t epoch;  //!< Global epoch when it was retired.
+    };
+    /// The announcement of a thread slot, with its hazard pointers, alone on its cache line.
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> state{0};  //!< 0 outside a section, (epoch << 1) | 1 inside one.
+        std::atomic<bool> in_use{false};
+        std::atomic<void*> hazards[hazards_per_thread];
+        unsigned nesting{0};           //!< Guards alive; only the owner touches it, as the fields below.
+        std::vector<Retired> retired;  //!< Nodes retired by the owner, not freed yet.
+        std::size_t next_collect{0};   //!< Size of retired that triggers the next collection.
+        Slot() {
+            for (auto& h : hazards) h.store(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+   public:
+    class Handle;
+
+    /// A read-side section: pointers loaded from the container while it lives stay valid. Nested sections are free.
+    class Guard {
+       public:
+        Guard(Guard&& other_) : m_slot(other_.m_slot) { other_.m_slot = nullptr; }
+        ~Guard() {
+            if (m_slot and --m_slot->nesting == 0) m_slot->state.store(0, std::memory_order_release);
+        }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+       private:
+        friend class Handle;
+        explicit Guard(Slot* slot_) : m_slot(slot_) {}
+        Slot* m_slot;
+    };
+
+    /// Membership of one thread in the domain. Not to be shared between threads.
+    class Handle {
+       public:
+        /// Claims a free thread slot; throws std::runtime_error when all max_threads are taken.
+        explicit Handle(EpochDomain& domain_) : m_domain(domain_), m_slot(domain_.acquire_slot()) {}
+        /// Hands what is still retired over to the domain, for the other threads (or the destructor) to free.
+        ~Handle() {
+            for (auto& h : m_slot->hazards) h.store(nullptr, std::memory_order_release);
+            m_domain.adopt_orphans(*m_slot, true);
+            m_slot->in_use.store(false, std::memory_order_release);
+        }
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        /// Enters a read-side section, announcing the current epoch.
+        Guard pin() {
+            if (m_slot->nesting++ == 0) {
+                for (;;) {
+                    auto e = m_domain.m_epoch.load(std::memory_order_relaxed);
+                    m_slot->state.store((e << 1) | 1, std::memory_order_relaxed);
+                    // The announcement must be visible before any pointer is loaded; seen late, the epoch could
+                    // move twice past it. Re-read in case it moved between the load and the store.
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (m_domain.m_epoch.load(std::memory_order_relaxed) == e) break;
+                }
+            }
+            return Guard(m_slot);
+        }
+
+        /// Deletes p_ once no thread can be reading it. p_ must already be unreachable from the container.
+        template <class T>
+        void retire(T* p_) {
+            retire(p_, [](void* p) { delete static_cast<T*>(p); });
+        }
+        /// Same as retire(T*), with deleter_(p_) to free it.
+        void retire(void* p_, void (*deleter_)(void*)) {
+            m_slot->retired.push_back(Retired{p_, deleter_, m_domain.m_epoch.load(std::memory_order_acquire)});
+            if (m_slot->retired.size() >= m_slot->next_collect) collect();
+        }
+
+        /**
+         * @brief Loads src_ and protects the pointer read with hazard pointer slot_ (< hazards_per_thread), for readers
+         * that do not pin: it stays valid until release(slot_) or the next protect() on that slot.
+         */
+        template <class T>
+        T* protect(unsigned slot_, const std::atomic<T*>& src_) {
+            T* p = src_.load(std::memory_order_acquire);
+            for (;;) {
+                m_slot->hazards[slot_].store(p, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                // Still there after the hazard is visible: it was not retired before a collector could see it.
+                T* again = src_.load(std::memory_order_acquire);
+                if (again == p) return p;
+                p = again;
+            }
+        }
+        void release(unsigned slot_) { m_slot->hazards[slot_].store(nullptr, std::memory_order_release); }
+
+        /// Tries to advance the epoch, then frees every node retired by this thread that no reader can hold.
+        void collect() { m_domain.collect(*m_slot); }
+        /// Nodes retired by this thread and not freed yet.
+        size_type pending() const { return m_slot->retired.size(); }
+
+       private:
+        EpochDomain& m_domain;
+        Slot* m_slot;
+    };
+
+    /**
+     * @param max_threads_ Number of handles that may exist at once.
+     * @param batch_ Retired nodes a thread accumulates before it tries to free them. Larger batches amortize the scan
+     * of the announcements further, for more memory held.
+     */
+    explicit EpochDomain(size_type max_threads_ = 128, size_type batch_ = 64) : m_max_threads(max_threads_),
+                                                                               m_batch(batch_ ? batch_ : 1) {
+        // Aligned by hand: before C++17, new ignores the alignment of Slot.
+        m_slot_memory.reset(new unsigned char[(max_threads_ + 1) * sizeof(Slot)]);
+        auto addr = reinterpret_cast<std::uintptr_t>(m_slot_memory.get());
+        m_slots = reinterpret_cast<Slot*>((addr + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot));
+        for (size_type s{0}; s < max_threads_; s++) new (m_slots + s) Slot();
+    }
+    /// Frees everything still retired. No Handle may be left.
+    ~EpochDomain() {
+        for (size_type s{0}; s < m_max_threads; s++) {
+            free_all(m_slots[s].retired);
+            m_slots[s].~Slot();
+        }
+        free_all(m_orphans);
+    }
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    /// Current global epoch.
+    std::uint64_t epoch() const { return m_epoch.load(std::memory_order_relaxed); }
+    /// Nodes freed so far.
+    size_type freed() const { return m_freed.load(std::memory_order_relaxed); }
+
+   private:
+    size_type m_max_threads, m_batch;
+    std::unique_ptr<unsigned char[]> m_slot_memory;  //!< Holds the slots, with room to align them to a cache line.
+    Slot* m_slots;
+    std::atomic<std::uint64_t> m_epoch{1};
+    std::atomic<size_type> m_freed{0};
+    std::mutex m_orphan_lock;                //!< Guards m_orphans.
+    std::vector<Retired> m_orphans;          //!< Left by handles destroyed before their nodes could be freed.
+    std::atomic<bool> m_has_orphans{false};  //!< Lets collect() skip the lock when there are none.
+
+    Slot* acquire_slot() {
+        for (size_type s{0}; s < m_max_threads; s++) {
+            bool free = false;
+            if (m_slots[s].in_use.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+                m_slots[s].next_collect = m_batch;
+                return m_slots + s;
+            }
+        }
+        throw std::runtime_error("EpochDomain: more threads than max_threads");
+    }
+
+    /// Moves the nodes of slot_ to the orphans (give_), or the orphans to slot_.
+    void adopt_orphans(Slot& slot_, bool give_) {
+        std::lock_guard<std::mutex> guard(m_orphan_lock);
+        auto& from = give_ ? slot_.retired : m_orphans;
+        auto& to = give_ ? m_orphans : slot_.retired;
+        to.insert(to.end(), from.begin(), from.end());
+        from.clear();
+        m_has_orphans.store(!m_orphans.empty(), std::memory_order_release);
+    }
+
+    /// Moves the epoch on if every pinned thread has announced it. Returns the epoch after the attempt.
+    std::uint64_t try_advance() {
+        auto e = m_epoch.load(std::memory_order_seq_cst);
+        for (size_type s{0}; s < m_max_threads; s++) {
+            auto state = m_slots[s].state.load(std::memory_order_seq_cst);
+            if ((state & 1) and (state >> 1) != e) return e;
+        }
+        // Fails only if another thread advanced it first, which is as good.
+        m_epoch.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+        return m_epoch.load(std::memory_order_relaxed);
+    }
+
+    void collect(Slot& slot_) {
+        if (m_has_orphans.load(std::memory_order_acquire)) adopt_orphans(slot_, false);
+        auto e = try_advance();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::vector<void*> hazards;
+        for (size_type s{0}; s < m_max_threads; s++) {
+            for (auto& h : m_slots[s].hazards) {
+                void* p = h.load(std::memory_order_acquire);
+                if (p) hazards.push_back(p);
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        auto& retired = slot_.retired;
+        size_type kept{0};
+        for (auto& r : retired) {
+            if (r.epoch + 2 <= e and !std::binary_search(hazards.begin(), hazards.end(), r.ptr)) {
+                r.deleter(r.ptr);
+            } else {
+                retired[kept++] = r;
+            }
+        }
+        m_freed.fetch_add(retired.size() - kept, std::memory_order_relaxed);
+        retired.resize(kept);
+        // What could not be freed waits for another batch on top of it: a stuck reader does not turn every retire
+        // into a scan.
+        slot_.next_collect = kept + m_batch;
+    }
+
+    void free_all(std::vector<Retired>& retired_) {
+        for (auto& r : retired_) r.deleter(r.ptr);
+        m_freed.fetch_add(retired_.size(), std::memory_order_relaxed);
+        retired_.clear();
+    }
+};
+
+}  // namespace ac
+#endif
@@ -0,0 +1,309 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _FLAT_INT_HASHTBL_H_
+#define _FLAT_INT_HASHTBL_H_
+
+#include <atomic>       // std::atomic, std::atomic_thread_fence
+#include <cstddef>      // std::size_t
+#include <cstdint>      // std::uint32_t, std::uint64_t, std::uintptr_t
+#include <limits>       // std::numeric_limits
+#include <memory>       // std::unique_ptr
+#include <stdexcept>    // std::invalid_argument, std::length_error
+#include <type_traits>  // std::is_integral, std::is_trivially_copyable, std::integral_constant
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // SSE2 compares of a line of keys
+#endif
+
+namespace ac  // Associative container
+{
+/**
+ * @brief Hash table for integer keys (account numbers, 64-bit ids), with keys and data in flat arrays.
+ *
+ * HashTbl<int, ...> pays for its generality on every lookup: a bucket array of list heads, then a list node on the
+ * heap per entry. Here the keys are stored inline, in one array probed linearly (open addressing), and the data at
+ * the same index of a second array:
+ *  - one key value is reserved to mark empty slots (by default the largest one), so a slot needs no separate flag;
+ *  - a key goes to slot `key * 2^64 / phi >> shift` (Fibonacci hashing, as AggTable), and the probe reads the keys a
+ *    cache line at a time: with SSE2 the 16 (or 8) keys of the line are compared to the key and to the empty marker
+ *    in a few instructions (one at a time in a concurrent table, where the keys must be read atomically), and the
+ *    first slot that matches either ends the probe;
+ *  - erase() shifts the following entries of the run back instead of leaving tombstones, so lookups never skip over
+ *    dead slots.
+ *
+ * With Concurrent set, any number of threads may insert and retrieve at once (erase() is not available): insert() of
+ * a new key claims its slot with a single compare-and-swap on the key, and the data is then stored with an atomic
+ * write; a key already there just gets its data overwritten. A reader that finds a key in the short window between
+ * the two sees its data as Data(). No shared counter is kept either, so size() counts the keys by a scan. The
+ * concurrent table does not grow (a resize would have to stop every thread), so it must be created for its final
+ * size; Data must then be trivially copyable and at most 8 bytes.
+ */
+template <class Key, class Data, bool Concurrent = false>
+class FlatIntHashTbl {
+    static_assert(std::is_integral<Key>::value and (sizeof(Key) == 4 or sizeof(Key) == 8),
+                  "FlatIntHashTbl keys must be 32- or 64-bit integers");
+    static_assert(!Concurrent or (std::is_trivially_copyable<Data>::value and sizeof(Data) <= 8),
+                  "the data of a concurrent FlatIntHashTbl must be trivially copyable, and at most 8 bytes");
+
+   public:
+    using size_type = std::size_t;
+    using key_type = Key;
+    using mapped_type = Data;
+
+    /**
+     * @param expected_ Number of keys the table should hold without growing; for a concurrent table, the most it
+     * will ever hold.
+     * @param empty_key_ Key value reserved to mark empty slots; it cannot be inserted.
+     */
+    explicit FlatIntHashTbl(size_type expected_ = 16, Key empty_key_ = std::numeric_limits<Key>::max())
+        : m_empty(empty_key_) {
+        reset(capacity_for(expected_));
+    }
+    FlatIntHashTbl(const FlatIntHashTbl&) = delete;
+    FlatIntHashTbl& operator=(const FlatIntHashTbl&) = delete;
+
+    /// Inserts key_ with data_, or overwrites its data. Returns true when the key is new, as HashTbl::insert().
+    bool insert(Key key_, const Data& data_) {
+        if (key_ == m_empty) throw std::invalid_argument("FlatIntHashTbl: the empty key cannot be inserted");
+        for (;;) {
+            bool found;
+            size_type i = probe(key_, found);
+            if (!found) {
+                // Only a new key can take the table over its load: overwriting one at the limit does not grow it.
+                if (!Concurrent and m_count + 1 > capacity() * max_load) {
+                    rebuild(2 * capacity());
+                    continue;
+                }
+                if (!claim(i, key_)) continue;  // Another key took the slot first: probe again past it.
+                if (!Concurrent) m_count++;
+            }
+            store_data(i, data_);
+            return !found;
+        }
+    }
+
+    /// Copies the data of key_ into data_item_. Returns false when the key is not in the table.
+    bool retrieve(Key key_, Data& data_item_) const {
+        if (key_ == m_empty) return false;
+        bool found;
+        size_type i = probe(key_, found);
+        if (found) data_item_ = load_data(i);
+        return found;
+    }
+
+    /// Data of key_, or nullptr when it is not there. Not for a concurrent table, whose data may change under it.
+    const Data* find(Key key_) const {
+        static_assert(!Concurrent, "find() is not available on a concurrent FlatIntHashTbl: use retrieve()");
+        if (key_ == m_empty) return nullptr;
+        bool found;
+        size_type i = probe(key_, found);
+        return found ? &m_data[i] : nullptr;
+    }
+
+    /// Removes key_. Returns false when it is not in the table.
+    bool erase(Key key_) {
+        static_assert(!Concurrent, "erase() is not available on a concurrent FlatIntHashTbl");
+        if (key_ == m_empty) return false;
+        bool found;
+        size_type hole = probe(key_, found);
+        if (!found) return false;
+        // Backward shift: an entry further down the run moves into the hole if the hole is between its home slot
+        // and where it is now, so that no run is ever cut by an empty slot.
+        for (size_type j = (hole + 1) & m_mask; m_keys[j] != m_empty; j = (j + 1) & m_mask) {
+            if (((j - home(m_keys[j])) & m_mask) >= ((j - hole) & m_mask)) {
+                m_keys[hole] = m_keys[j];
+                m_data[hole] = m_data[j];
+                hole = j;
+            }
+        }
+        m_keys[hole] = m_empty;
+        m_count--;
+        return true;
+    }
+
+    /// Number of keys. Exact when no other thread is inserting; a scan of the keys for a concurrent table.
+    size_type size() const {
+        if (!Concurrent) return m_count;
+        size_type n{0};
+        for (size_type i{0}; i <= m_mask; i++) n += load_key(i) != m_empty;
+        return n;
+    }
+    bool empty() const { return size() == 0; }
+    /// Number of slots: a power of two, at least twice size().
+    size_type capacity() const { return m_mask + 1; }
+    /// The key value that marks empty slots.
+    Key empty_key() const { return m_empty; }
+    /// Makes room for keys_ keys without growing.
+    void reserve(size_type keys_) {
+        static_assert(!Concurrent, "a concurrent FlatIntHashTbl does not grow");
+        if (keys_ > capacity() * max_load) rebuild(capacity_for(keys_));
+    }
+    /// Removes every key, keeping the capacity.
+    void clear() { reset(capacity()); }
+
+   private:
+    static constexpr double max_load = 0.5;  //!< Short runs matter more here than memory.
+    static constexpr size_type line_slots = 64 / sizeof(Key);  //!< Keys in a cache line.
+
+    Key m_empty;
+    std::unique_ptr<unsigned char[]> m_key_memory;  //!< Holds the keys, with room to align them to a cache line.
+    Key* m_keys;
+    std::unique_ptr<Data[]> m_data;
+    size_type m_mask{0};   //!< capacity() - 1.
+    unsigned m_shift{0};   //!< 64 - log2(capacity()): the high bits of a hash are a slot index.
+    size_type m_count{0};  //!< Keys stored; not kept by a concurrent table.
+
+    /// Home slot of key_: Fibonacci hashing keeps the high bits, which are well mixed even for consecutive keys.
+    size_type home(Key key_) const {
+        return static_cast<size_type>((static_cast<std::uint64_t>(key_) * UINT64_C(11400714819323198485)) >> m_shift);
+    }
+    static size_type capacity_for(size_type keys_) {
+        size_type cap{2 * line_slots};
+        while (cap * max_load < keys_) cap *= 2;
+        return cap;
+    }
+    void reset(size_type capacity_) {
+        // Aligned by hand: a probe reads whole cache lines of keys.
+        m_key_memory.reset(new unsigned char[capacity_ * sizeof(Key) + 64]);
+        auto addr = reinterpret_cast<std::uintptr_t>(m_key_memory.get());
+        m_keys = reinterpret_cast<Key*>((addr + 63) / 64 * 64);
+        for (size_type i{0}; i < capacity_; i++) m_keys[i] = m_empty;
+        m_data.reset(new Data[capacity_]());
+        m_mask = capacity_ - 1;
+        m_shift = 64;
+        for (size_type c{capacity_}; c > 1; c >>= 1) m_shift--;
+        m_count = 0;
+    }
+    void rebuild(size_type capacity_) {
+        auto old_memory = std::move(m_key_memory);
+        auto old_data = std::move(m_data);
+        Key* old_keys = m_keys;
+        size_type old_capacity = capacity();
+        reset(capacity_);
+        for (size_type i{0}; i < old_capacity; i++) {
+            if (old_keys[i] == m_empty) continue;
+            bool found;
+            size_type j = probe(old_keys[i], found);
+            m_keys[j] = old_keys[i];
+            m_data[j] = old_data[i];
+            m_count++;
+        }
+    }
+
+    /**
+     * @brief Slot of key_ (found_ set), or the empty slot where it would go. Scans a line of keys at a time, from the
+     * line of the home slot, whose slots before the home one are not part of the run (but are, last, when the probe
+     * has gone around the whole table).
+     */
+    size_type probe(Key key_, bool& found_) const {
+        size_type i = home(key_), line = i & ~(line_slots - 1);
+        // Below half full, most probes end at the home slot: one compare settles them before any line is scanned.
+        Key at_home = load_key(i);
+        if (at_home == key_ or at_home == m_empty) {
+            found_ = at_home == key_;
+            if (Concurrent) std::atomic_thread_fence(std::memory_order_acquire);
+            return i;
+        }
+        std::uint32_t live = ~std::uint32_t(0) << (i - line);
+        for (size_type n{0}; n <= capacity() / line_slots; n++) {
+            std::uint32_t keys, empties;
+            match(line, key_, keys, empties);
+            keys &= live;
+            empties &= live;
+            if (keys | empties) {
+                unsigned first = lowest_bit(keys | empties);
+                found_ = (keys >> first) & 1;
+                // A concurrent reader goes on to the data of a key another thread just claimed: the acquire pairs with
+                // the release of that claim.
+                if (Concurrent) std::atomic_thread_fence(std::memory_order_acquire);
+                return line + first;
+            }
+            live = ~std::uint32_t(0);
+            line = (line + line_slots) & m_mask;
+        }
+        throw std::length_error("FlatIntHashTbl: the table is full");
+    }
+
+    /// Sets a bit in keys_ for every slot of the line at line_ holding key_, and in empties_ for every empty one.
+    void match(size_type line_, Key key_, std::uint32_t& keys_, std::uint32_t& empties_) const {
+        keys_ = empties_ = 0;
+#if defined(__SSE2__)
+        if (!Concurrent) {
+            const __m128i* v = reinterpret_cast<const __m128i*>(m_keys + line_);
+            __m128i key = splat(key_), empty = splat(m_empty);
+            for (unsigned q{0}; q < 4; q++) {
+                __m128i line = _mm_load_si128(v + q);
+                keys_ |= mask_of(line, key) << (q * line_slots / 4);
+                empties_ |= mask_of(line, empty) << (q * line_slots / 4);
+            }
+            return;
+        }
+#endif
+        // In a concurrent table other threads may be claiming slots of the line: each key is read atomically (a
+        // vector load would be a data race), which on x86 is still a plain load.
+        for (size_type s{0}; s < line_slots; s++) {
+            Key k = load_key(line_ + s);
+            keys_ |= std::uint32_t(k == key_) << s;
+            empties_ |= std::uint32_t(k == m_empty) << s;
+        }
+    }
+#if defined(__SSE2__)
+    static __m128i splat(Key k_) {
+        return sizeof(Key) == 4 ? _mm_set1_epi32(static_cast<int>(k_)) : _mm_set1_epi64x(static_cast<long long>(k_));
+    }
+    /// One bit per key of v_ equal to the one in k_.
+    static std::uint32_t mask_of(__m128i v_, __m128i k_) {
+        __m128i eq = _mm_cmpeq_epi32(v_, k_);
+        if (sizeof(Key) == 4) return static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(eq)));
+        // No 64-bit compare in SSE2: both 32-bit halves must be equal.
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<std::uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(eq)));
+    }
+#endif
+    static unsigned lowest_bit(std::uint32_t bits_) {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_ctz(bits_));
+#else
+        unsigned i{0};
+        while (!(bits_ >> i & 1)) i++;
+        return i;
+#endif
+    }
+
+    /// Takes the empty slot i_ for key_. Concurrently, fails when another thread took it first (even with key_).
+    bool claim(size_type i_, Key key_) {
+        if (!Concurrent) {
+            m_keys[i_] = key_;
+            return true;
+        }
+        Key expected = m_empty;
+        return as_atomic(m_keys[i_]).compare_exchange_strong(expected, key_, std::memory_order_acq_rel);
+    }
+    using concurrent_tag = std::integral_constant<bool, Concurrent>;
+    void store_data(size_type i_, const Data& data_) { store_data(i_, data_, concurrent_tag()); }
+    Data load_data(size_type i_) const { return load_data(i_, concurrent_tag()); }
+    void store_data(size_type i_, const Data& data_, std::false_type) { m_data[i_] = data_; }
+    const Data& load_data(size_type i_, std::false_type) const { return m_data[i_]; }
+
+    // The arrays hold plain values, which the concurrent table accesses atomically. std::atomic<T> of a lock-free T
+    // has the size and representation of T on every compiler the table targets; a C++20 std::atomic_ref would say so.
+    static std::atomic<Key>& as_atomic(Key& k_) { return *reinterpret_cast<std::atomic<Key>*>(&k_); }
+    Key load_key(size_type i_) const {
+        return Concurrent ? reinterpret_cast<const std::atomic<Key>*>(m_keys + i_)->load(std::memory_order_relaxed)
+                          : m_keys[i_];
+    }
+    void store_data(size_type i_, const Data& data_, std::true_type) {
+        reinterpret_cast<std::atomic<Data>*>(&m_data[i_])->store(data_, std::memory_order_release);
+    }
+    Data load_data(size_type i_, std::true_type) const {
+        return reinterpret_cast<const std::atomic<Data>*>(&m_data[i_])->load(std::memory_order_acquire);
+    }
+};
+
+template <class Key, class Data, bool Concurrent>
+constexpr double FlatIntHashTbl<Key, Data, Concurrent>::max_load;
+template <class Key, class Data, bool Concurrent>
+constexpr typename FlatIntHashTbl<Key, Data, Concurrent>::size_type FlatIntHashTbl<Key, Data, Concurrent>::line_slots;
+
+}  // namespace ac
+#endif
@@ -0,0 +1,98 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _FRONT_CACHE_H_
+#define _FRONT_CACHE_H_
+
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::uint64_t
+#include <vector>   // std::vector
+
+#include "concurrent_hashtbl.h"
+
+namespace ac  // Associative container
+{
+/**
+ * @brief Small cache of one thread in front of a ConcurrentHashTbl, for reads that keep coming back to a few hot keys.
+ *
+ * Even an uncontended retrieve() takes the stripe lock, and with it the cache line of the lock away from the other
+ * threads reading the same hot accounts, so that line and the bucket lines behind it travel between cores on every
+ * read. A FrontCache keeps copies of the entries its thread read last, in a direct-mapped array (one slot per hash,
+ * no eviction policy to maintain):
+ *  - each copy remembers the write count of its stripe when it was read (see ConcurrentHashTbl); a hit checks that
+ *    the count has not moved, a load of a line that only writes change, and returns the copy without locking;
+ *  - any write to the stripe invalidates every copy from it, whether or not it touched the entry: a coarse check,
+ *    but one counter per stripe instead of per entry, and a stripe holds few entries of the hot set;
+ *  - a copy is never served after its entry changed: the count is read under the lock, along with the copy.
+ * One cache per thread, created and used by that thread only; the table must outlive it.
+ */
+template <class Table>
+class FrontCache {
+   public:
+    using size_type = std::size_t;
+    using key_type = typename Table::key_type;
+    using mapped_type = typename Table::mapped_type;
+
+    /// Creates a cache of slots_ entries (rounded up to a power of two) in front of table_.
+    explicit FrontCache(const Table& table_, size_type slots_ = 1024) : m_table(table_) {
+        size_type n{1};
+        while (n < slots_) n *= 2;
+        m_slots.resize(n);
+        m_mask = n - 1;
+    }
+
+    /// Copies the data of key_ into data_item_, from the cache when the copy is still current, else from the table.
+    /// Returns false when the key is not in the table.
+    bool retrieve(const key_type& key_, mapped_type& data_item_) {
+        auto h = Table::hash(key_);
+        // Above the bits that pick the bucket and the stripe, so that the keys of one stripe spread over the slots.
+        Slot& s = m_slots[(static_cast<std::uint64_t>(h) >> 32) & m_mask];
+        if (s.used and s.hash == h and s.writes == m_table.writes(h) and typename Table::key_equal()(s.key, key_)) {
+            m_hits++;
+            data_item_ = s.data;
+            return true;
+        }
+        m_misses++;
+        std::uint64_t writes;
+        if (!m_table.retrieve_hashed(key_, h, data_item_, writes)) {
+            s.used = false;
+            return false;
+        }
+        s.key = key_;
+        s.data = data_item_;
+        s.hash = h;
+        s.writes = writes;
+        s.used = true;
+        return true;
+    }
+
+    /// Reads served from the cache.
+    size_type hits() const { return m_hits; }
+    /// Reads that went to the table: first reads, slot conflicts, and copies invalidated by writes.
+    size_type misses() const { return m_misses; }
+    /// hits() / (hits() + misses()), 0 before the first read.
+    double hit_ratio() const { return m_hits + m_misses ? static_cast<double>(m_hits) / (m_hits + m_misses) : 0.0; }
+    /// Number of slots.
+    size_type slot_count() const { return m_mask + 1; }
+    /// Drops every copy and resets the counts.
+    void clear() {
+        for (auto& s : m_slots) s.used = false;
+        m_hits = m_misses = 0;
+    }
+
+   private:
+    struct Slot {
+        key_type key{};
+        mapped_type data{};
+        std::size_t hash{0};
+        std::uint64_t writes{0};  //!< Write count of the stripe when data was read.
+        bool used{false};
+    };
+
+    const Table& m_table;
+    std::vector<Slot> m_slots;
+    size_type m_mask;
+    size_type m_hits{0}, m_misses{0};
+};
+
+}  // namespace ac
+#endif
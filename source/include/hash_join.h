@@ -0,0 +1,132 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _HASH_JOIN_H_
+#define _HASH_JOIN_H_
+
+#include <cstddef>   // std::size_t
+#include <iterator>  // std::distance
+#include <vector>    // std::vector
+
+namespace ac  // Associative container
+{
+/// Tuning of hash_join().
+struct JoinOptions {
+    /// How far ahead of the lookups the probes are prefetched: the number of cache misses kept in flight.
+    std::size_t prefetch_distance{16};
+    /// Cache budget of a partition: the probes are radix-partitioned so that each partition only touches a slice of
+    /// the bucket array of about this size. 0 (the default) disables partitioning: it keeps the buckets in cache, but
+    /// the list nodes are spread over the heap whatever the partition, and visiting the probes out of order costs more
+    /// than it saves on the tables measured so far (see bench/bench_join.cpp).
+    std::size_t cache_bytes{0};
+};
+
+/// What a hash_join() call did.
+struct JoinStats {
+    std::size_t probes{0};      //!< Probe rows read.
+    std::size_t matches{0};     //!< Pairs emitted.
+    std::size_t partitions{1};  //!< Radix partitions the probes were split into.
+};
+
+namespace detail {
+/// A probe to look up: its position in the batch and the hash of its key.
+struct HashedProbe {
+    std::size_t index;
+    std::size_t hash;
+};
+
+/// Prefetches the cache line holding p_, if the compiler can.
+inline void prefetch_line(const void* p_) {
+#if defined(__GNUC__)
+    __builtin_prefetch(p_);
+#else
+    (void)p_;
+#endif
+}
+
+/**
+ * @brief Looks up the probes in the order of probes_, software-pipelined: while probe j is looked up, the first entry of
+ * the bucket of probe j + d and the bucket (and probe row) of probe j + 2d are being fetched.
+ */
+template <class Table, class ProbeIt, class KeyOf, class Emit>
+std::size_t probe_pipelined(const Table& build_, ProbeIt first_, const std::vector<HashedProbe>& probes_,
+                            KeyOf& key_of_, Emit& emit_, std::size_t d_) {
+    std::size_t n = probes_.size(), matches{0};
+    auto ahead = [&](std::size_t j) {
+        build_.prefetch_bucket(probes_[j].hash);
+        prefetch_line(&*(first_ + probes_[j].index));
+    };
+    for (std::size_t j{0}; j < n and j < 2 * d_; j++) ahead(j);
+    for (std::size_t j{0}; j < n and j < d_; j++) build_.prefetch_entry(probes_[j].hash);
+    for (std::size_t j{0}; j < n; j++) {
+        if (j + 2 * d_ < n) ahead(j + 2 * d_);
+        if (j + d_ < n) build_.prefetch_entry(probes_[j + d_].hash);
+        const auto& probe = *(first_ + probes_[j].index);
+        auto data = build_.find_hashed(key_of_(probe), probes_[j].hash);
+        if (data) {
+            emit_(probe, *data);
+            matches++;
+        }
+    }
+    return matches;
+}
+}  // namespace detail
+
+/**
+ * @brief Joins a batch of probe rows (transactions, say) with the table they refer to (the accounts), by key.
+ *
+ * Equivalent to calling build_.find(key_of_(p)) for every probe p and emitting the pairs found, but built for batches
+ * much larger than the caches:
+ *  - each probe key is hashed once, up front;
+ *  - lookups are software-pipelined with prefetches (see JoinOptions::prefetch_distance), so the cache misses on the
+ *    buckets and list nodes of upcoming probes overlap with the current one instead of stalling one after the other;
+ *  - optionally, when the bucket array of the table is larger than JoinOptions::cache_bytes, the probes are first
+ *    radix-partitioned by bucket index, so each partition keeps its slice of the bucket array in cache while probed.
+ * Nothing is copied: emit_ receives references to the probe row and to the data stored in the table.
+ *
+ * @param build_ The build side, a HashTbl (any table with find_hashed(), prefetch_bucket(), prefetch_entry(),
+ * bucket_count() and a hasher type will do). It must not change during the call.
+ * @param first_ First probe row. The probes must be a random-access range; a longer stream is joined batch by batch.
+ * @param last_ End of the probe rows.
+ * @param key_of_ Callable as key_of_(const Probe&), returning the key (or a reference to it) to look up.
+ * @param emit_ Callable as emit_(const Probe&, const DataType&), for each probe whose key is in the table. With
+ * partitioning the pairs come out grouped by partition; within a partition, in probe order.
+ * @return Counts of the join.
+ */
+template <class Table, class ProbeIt, class KeyOf, class Emit>
+JoinStats hash_join(const Table& build_, ProbeIt first_, ProbeIt last_, KeyOf key_of_, Emit emit_,
+                    const JoinOptions& opt_ = JoinOptions()) {
+    JoinStats stats;
+    auto n = static_cast<std::size_t>(std::distance(first_, last_));
+    stats.probes = n;
+    if (n == 0) return stats;
+    std::size_t d = opt_.prefetch_distance ? opt_.prefetch_distance : 1;
+
+    typename Table::hasher hash;
+    std::vector<detail::HashedProbe> probes(n);
+    for (std::size_t i{0}; i < n; i++) probes[i] = {i, hash(key_of_(*(first_ + i)))};
+
+    // Enough partitions for a slice of the bucket array to fit the budget, but not so many that they hold few probes.
+    std::size_t buckets = build_.bucket_count();
+    std::size_t bucket_bytes = buckets * sizeof(typename Table::list_type);
+    std::size_t parts{1};
+    if (opt_.cache_bytes)
+        while (bucket_bytes / parts > opt_.cache_bytes and n / (parts * 2) >= 4 * d) parts *= 2;
+    stats.partitions = parts;
+
+    if (parts > 1) {
+        // Radix partitioning on the high part of the bucket index: a counting pass, then a stable scatter.
+        auto part_of = [&](const detail::HashedProbe& p) { return (p.hash % buckets) * parts / buckets; };
+        std::vector<std::size_t> next(parts + 1, 0);
+        for (const auto& p : probes) next[part_of(p) + 1]++;
+        for (std::size_t q{0}; q < parts; q++) next[q + 1] += next[q];
+        std::vector<detail::HashedProbe> scattered(n);
+        for (const auto& p : probes) scattered[next[part_of(p)]++] = p;
+        probes.swap(scattered);
+    }
+    // Partitions are contiguous, so probing front to back visits them one after the other.
+    stats.matches = detail::probe_pipelined(build_, first_, probes, key_of_, emit_, d);
+    return stats;
+}
+
+}  // namespace ac
+#endif
@@ -0,0 +1,53 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _HASH_UTILS_H_
+#define _HASH_UTILS_H_
+
+#include <cstdint>     // std::uint64_t
+#include <cstddef>     // std::size_t
+#include <functional>  // std::hash
+#include <utility>     // std::pair
+
+namespace ac  // Associative container
+{
+/**
+ * @brief Finalizer from SplitMix64. Spreads every input bit over every output bit, so it turns a weak hash (or a plain
+ * integer) into one suitable for the table reduction.
+ *
+ * @param x_ Value to mix.
+ * @return Mixed value.
+ */
+inline std::uint64_t hash_mix(std::uint64_t x_) {
+    x_ ^= x_ >> 30;
+    x_ *= 0xbf58476d1ce4e5b9ULL;
+    x_ ^= x_ >> 27;
+    x_ *= 0x94d049bb133111ebULL;
+    x_ ^= x_ >> 31;
+    return x_;
+}
+
+/**
+ * @brief Folds the hash of a value into a running seed. Unlike a plain XOR, the result depends on the order of the
+ * fields and equal fields do not cancel each other.
+ *
+ * @param seed_ Running hash value, updated in place.
+ * @param value_ Value whose std::hash is folded into the seed.
+ */
+template <class T>
+inline void hash_combine(std::size_t& seed_, const T& value_) {
+    seed_ = hash_mix(seed_ + 0x9e3779b97f4a7c15ULL + std::hash<T>()(value_));
+}
+
+/// Hash of a std::pair (such as a composite index key), built with hash_combine().
+struct PairHash {
+    template <class A, class B>
+    std::size_t operator()(const std::pair<A, B>& p_) const {
+        std::size_t seed{0};
+        hash_combine(seed, p_.first);
+        hash_combine(seed, p_.second);
+        return seed;
+    }
+};
+
+}  // namespace ac
+#endif
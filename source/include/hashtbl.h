@@ -4,13 +4,21 @@
 #define _HASHTBL_H_
 
 #include <algorithm>         // copy, find_if, for_each
+#include <chrono>            // std::chrono::steady_clock
 #include <cmath>             // sqrt
 #include <forward_list>      // forward_list
 #include <initializer_list>  // std::initializer_list
 #include <iostream>          // cout, endl, ostream
-#include <iterator>          // std::begin(), std::end()
+#include <iterator>          // std::begin(), std::end(), std::iterator_traits
 #include <memory>            // std::unique_ptr
+#include <type_traits>       // std::is_empty
 #include <utility>           // std::pair
+#include <vector>            // std::vector
+
+#include "batch_hash.h"
+#include "hashtbl_observer.h"
+#include "memory_usage.h"
+#include "thread_pool.h"
 
 namespace ac  // Associative container
 {
@@ -25,18 +33,58 @@ struct HashEntry {
     friend std::ostream& operator<<(std::ostream& os_, const HashEntry& he_) { return os_ << he_.m_data; }
 };
 
-template <class KeyType, class DataType, class KeyHash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType> >
+template <class KeyType, class DataType, class KeyHash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType>,
+          class Observer = NullObserver, class Alloc = std::allocator<HashEntry<KeyType, DataType> > >
 class HashTbl {
    public:
     using size_type = std::size_t;
+    using key_type = KeyType;
+    using mapped_type = DataType;
+    using hasher = KeyHash;
+    using key_equal = KeyEqual;
     using entry_type = HashEntry<KeyType, DataType>;
-    using list_type = std::forward_list<entry_type>;
+    using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<entry_type>;
+    using list_type = std::forward_list<entry_type, allocator_type>;
 
    private:
-    size_type m_size;                      //!< Tamanho da tabela.
-    size_type m_count;                     //!< Numero de elementos na tabela.
-    float m_load_factor;                   //!< Fator da tabela.
-    std::unique_ptr<list_type[]> m_table;  //!< Ponteiro para tabela.
+    using bucket_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<list_type>;
+    using bucket_traits = std::allocator_traits<bucket_allocator>;
+
+    /// Destroys a bucket array built by make_buckets().
+    struct BucketDeleter {
+        size_type n;  //!< Number of buckets in the array.
+        void operator()(list_type* buckets_) const {
+            bucket_allocator alloc;
+            for (size_type i{0}; i < n; i++) bucket_traits::destroy(alloc, buckets_ + i);
+            bucket_traits::deallocate(alloc, buckets_, n);
+        }
+    };
+    using bucket_array = std::unique_ptr<list_type[], BucketDeleter>;
+
+    /// Approximate size of a collision list node: the link plus the entry, padded to the entry alignment.
+    static const size_type node_size =
+        (sizeof(void*) + sizeof(entry_type) + alignof(entry_type) - 1) / alignof(entry_type) * alignof(entry_type);
+
+    /**
+     * The observer, with the load factor stored alongside it in one object. An empty observer, such as the default
+     * NullObserver, is then an empty base and takes no room (a member of its own would cost a padded word).
+     */
+    struct ObserverAndLoad : Observer {
+        float load_factor{1.f};  //!< Fator da tabela.
+    };
+    /// The layout of the table without an observer (virtual destructor included), which an empty Observer must not
+    /// make any larger.
+    struct Unobserved {
+        virtual ~Unobserved() {}
+        size_type size, count;
+        float load_factor;
+        bucket_array table;
+    };
+
+    size_type m_size;            //!< Tamanho da tabela.
+    size_type m_count;           //!< Numero de elementos na tabela.
+    ObserverAndLoad m_observer;  //!< Recebe os eventos da tabela (ver hashtbl_observer.h), e o fator da tabela.
+    bucket_array m_table;        //!< Ponteiro para tabela.
 
     static const short DEFAULT_SIZE = 10;
 
@@ -51,7 +99,25 @@ class HashTbl {
 
     bool insert(const KeyType&, const DataType&);
     bool retrieve(const KeyType&, DataType&) const;
+    DataType* find(const KeyType&);
+    const DataType* find(const KeyType&) const;
+    const DataType* find_hashed(const KeyType&, size_type) const;
+    size_type retrieve_many(const KeyType*, size_type, const DataType**) const;
+    void prefetch_bucket(size_type) const;
+    void prefetch_entry(size_type) const;
     bool erase(const KeyType&);
+    /// Only takes iterators: two keys of an integer-keyed table would otherwise match it exactly.
+    template <class ForwardIt, class = typename std::iterator_traits<ForwardIt>::iterator_category>
+    size_type erase(ForwardIt first_, ForwardIt last_);
+    template <class Pred>
+    size_type erase_if(Pred pred_);
+    template <class Pred>
+    size_type parallel_erase_if(Pred pred_, ThreadPool& pool_ = ThreadPool::shared());
+    template <class ForwardIt, class KeyOf, class Apply>
+    size_type apply_batch(ForwardIt first_, ForwardIt last_, KeyOf key_of_, Apply apply_);
+    template <class ForwardIt, class KeyOf, class Apply>
+    size_type parallel_apply_batch(ForwardIt first_, ForwardIt last_, KeyOf key_of_, Apply apply_,
+                                   ThreadPool& pool_ = ThreadPool::shared());
     void clear();
     bool empty() const;
     inline size_type size() const { return m_count; };
@@ -60,6 +126,18 @@ class HashTbl {
     size_type count(const KeyType&) const;
     float max_load_factor() const;
     void max_load_factor(float mlf);
+    inline size_type bucket_count() const { return m_size; };
+    MemoryUsage memory_usage() const;
+    inline Observer& observer() { return m_observer; };
+    inline const Observer& observer() const { return m_observer; };
+    size_type bucket_size(size_type) const;
+    size_type bucket(const KeyType&) const;
+    template <class Fn>
+    void for_each(Fn fn_) const;
+    template <class Fn>
+    void parallel_for_each(Fn fn_, ThreadPool& pool_ = ThreadPool::shared()) const;
+    template <class T, class Map, class Combine>
+    T parallel_reduce(T init_, Map map_, Combine combine_, ThreadPool& pool_ = ThreadPool::shared()) const;
 
     friend std::ostream& operator<<(std::ostream& os_, const HashTbl& ht_) {
         os_ << "{ ";
@@ -75,6 +153,23 @@ class HashTbl {
     static size_type find_next_prime(size_type);
     static bool is_prime(const size_type&);
     void rehash(void);
+    void check_chain(size_type);
+    bool erase_in_bucket(size_type, const KeyType&);
+    template <class Pred>
+    size_type sweep_bucket(size_type, Pred&);
+    void count_erased(size_type);
+    /// An operation of a batch, tagged with the bucket of its key.
+    template <class Op>
+    struct BucketedOp {
+        size_type bucket;
+        const Op* op;
+    };
+    template <class ForwardIt, class KeyOf>
+    std::vector<BucketedOp<typename std::iterator_traits<ForwardIt>::value_type> > sort_by_bucket(ForwardIt, ForwardIt,
+                                                                                                   KeyOf&) const;
+    template <class Op, class KeyOf, class Apply>
+    size_type apply_sorted(const std::vector<BucketedOp<Op> >&, size_type, size_type, KeyOf&, Apply&);
+    static bucket_array make_buckets(size_type);
 };
 
 }  // namespace ac
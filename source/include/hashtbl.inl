@@ -6,10 +6,13 @@ namespace ac {
  *
  * @param sz Hashtable size to use at startup. If not specified, the implementation-defined value is used.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-HashTbl<KeyType, DataType, KeyHash, KeyEqual>::HashTbl(size_type sz)
-    : m_size{find_next_prime(sz)}, m_count{0}, m_load_factor{1.0} {
-    m_table = std::make_unique<list_type[]>(m_size);
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::HashTbl(size_type sz)
+    : m_size{find_next_prime(sz)}, m_count{0} {
+    static_assert(!std::is_empty<Observer>::value or sizeof(HashTbl) == sizeof(Unobserved),
+                  "an empty observer must take no room in the table");
+    m_table = make_buckets(m_size);
 }
 
 /**
@@ -17,9 +20,11 @@ HashTbl<KeyType, DataType, KeyHash, KeyEqual>::HashTbl(size_type sz)
  *
  * @param source Another container to be used as source to initialize the elements of the container.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-HashTbl<KeyType, DataType, KeyHash, KeyEqual>::HashTbl(const HashTbl& source) : HashTbl(source.m_size) {
-    m_load_factor = source.m_load_factor;
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::HashTbl(const HashTbl& source)
+    : HashTbl(source.m_size) {
+    m_observer = source.m_observer;  // The load factor comes along.
     for (std::size_t index{0}; index < this->m_size; index++) {
         for (const auto& e : source.m_table[index]) insert(e.m_key, e.m_data);
     }
@@ -30,8 +35,10 @@ HashTbl<KeyType, DataType, KeyHash, KeyEqual>::HashTbl(const HashTbl& source) :
  *
  * @param ilist Initializer list to initialize the elements of the container.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-HashTbl<KeyType, DataType, KeyHash, KeyEqual>::HashTbl(const std::initializer_list<entry_type>& ilist) : HashTbl() {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::HashTbl(const std::initializer_list<entry_type>& ilist)
+    : HashTbl() {
     for (auto e : ilist) insert(e.m_key, e.m_data);
 }
 
@@ -41,15 +48,15 @@ HashTbl<KeyType, DataType, KeyHash, KeyEqual>::HashTbl(const std::initializer_li
  * @param clone Another container to use as data source.
  * @return *this
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-HashTbl<KeyType, DataType, KeyHash, KeyEqual>& HashTbl<KeyType, DataType, KeyHash, KeyEqual>::operator=(
-    const HashTbl& clone) {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>&
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::operator=(const HashTbl& clone) {
     if (this != &clone) {
-        this->~HashTbl();
-
         m_size = clone.m_size;
-        m_load_factor = clone.m_load_factor;
-        m_table = std::make_unique<list_type[]>(m_size);
+        m_count = 0;
+        m_observer = clone.m_observer;  // The load factor comes along.
+        m_table = make_buckets(m_size);
 
         for (std::size_t index{0}; index < m_size; index++) {
             for (auto& e : clone.m_table[index]) insert(e.m_key, e.m_data);
@@ -65,15 +72,15 @@ HashTbl<KeyType, DataType, KeyHash, KeyEqual>& HashTbl<KeyType, DataType, KeyHas
  * @param ilist Initializer list to use as data source.
  * @return *this
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-HashTbl<KeyType, DataType, KeyHash, KeyEqual>& HashTbl<KeyType, DataType, KeyHash, KeyEqual>::operator=(
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>&
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::operator=(
     const std::initializer_list<entry_type>& ilist) {
-    this->~HashTbl();
-
     m_size = find_next_prime(std::distance(ilist.begin(), ilist.end()));
-    m_table = std::make_unique<list_type[]>(m_size);
+    m_table = make_buckets(m_size);
     m_count = 0;
-    m_load_factor = 1.f;
+    m_observer.load_factor = 1.f;
 
     for (const auto& e : ilist) insert(e.m_key, e.m_data);
 
@@ -84,9 +91,10 @@ HashTbl<KeyType, DataType, KeyHash, KeyEqual>& HashTbl<KeyType, DataType, KeyHas
  * @brief Desconstructor. Class destructor that frees memory pointed to by m_table.
  *
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-HashTbl<KeyType, DataType, KeyHash, KeyEqual>::~HashTbl() {
-    for (std::size_t index{0}; index < m_size; index++) m_table[index].~forward_list();
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::~HashTbl() {
+    // Each collision list is destroyed exactly once, by the array that owns it.
     m_table.reset();
 }
 
@@ -98,8 +106,10 @@ HashTbl<KeyType, DataType, KeyHash, KeyEqual>::~HashTbl() {
  * @return If the insertion was performed the function successfully, returns true. If the key already exists in the
  * table, it returns false.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::insert(const KeyType& key_, const DataType& new_data_) {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+bool HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::insert(const KeyType& key_,
+                                                                            const DataType& new_data_) {
     HashEntry<KeyType, DataType> hashEntry(key_, new_data_);
     KeyHash hashFunc;
     KeyEqual keyEqual;
@@ -108,7 +118,8 @@ bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::insert(const KeyType& key_,
     if (m_table[index].empty()) {
         m_table[index].push_front(hashEntry);
         m_count++;
-        if ((static_cast<float>(m_count) / static_cast<float>(m_size)) > m_load_factor) rehash();
+        m_observer.on_insert(m_count);
+        if ((static_cast<float>(m_count) / static_cast<float>(m_size)) > m_observer.load_factor) rehash();
         return true;
     }
 
@@ -120,12 +131,14 @@ bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::insert(const KeyType& key_,
     if (iterator == m_table[index].end()) {
         m_table[index].push_front(hashEntry);
         m_count++;
-        if ((static_cast<float>(m_count) / static_cast<float>(m_size)) > m_load_factor) rehash();
+        m_observer.on_insert(m_count);
+        if (Observer::enabled) check_chain(index);
+        if ((static_cast<float>(m_count) / static_cast<float>(m_size)) > m_observer.load_factor) rehash();
         return true;
     }
 
     *iterator = hashEntry;
-    if ((static_cast<float>(m_count) / static_cast<float>(m_size)) > m_load_factor) rehash();
+    if ((static_cast<float>(m_count) / static_cast<float>(m_size)) > m_observer.load_factor) rehash();
     return false;
 }
 
@@ -133,8 +146,9 @@ bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::insert(const KeyType& key_,
  * @brief Clears all memory associated with collision lists from the table by removing all its elements.
  *
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-void HashTbl<KeyType, DataType, KeyHash, KeyEqual>::clear() {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+void HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::clear() {
     for (std::size_t index{0}; index < m_size; index++) m_table[index].clear();
     m_count = 0;
 }
@@ -144,8 +158,9 @@ void HashTbl<KeyType, DataType, KeyHash, KeyEqual>::clear() {
  *
  * @return True is table is empty, false otherwise.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::empty() const {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+bool HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::empty() const {
     return m_count == 0;
 }
 
@@ -156,8 +171,10 @@ bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::empty() const {
  * @param data_item_ Data record to be filled in when data item is found.
  * @return True if the data item is found, false otherwise.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::retrieve(const KeyType& key_, DataType& data_item_) const {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+bool HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::retrieve(const KeyType& key_,
+                                                                              DataType& data_item_) const {
     KeyHash hashFunc;
     KeyEqual keyEqual;
     auto index{hashFunc(key_) % m_size};
@@ -176,25 +193,161 @@ bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::retrieve(const KeyType& key_
 }
 
 /**
- * @brief It is a private method that must be called when the load factor λ is greater than m_load_factor. This method
- * will create a new table whose size will be equal to smaller prime number than twice the size of the table before the
- * rehash() call.
+ * @brief Locates the data associated with a key, without copying it.
+ *
+ * The pointer stays valid until the element is erased or the table is cleared, copied over or destroyed: rehash()
+ * moves the list nodes but not the entries they hold.
+ *
+ * @param key_ Data key to search for in the table.
+ * @return Pointer to the data, or nullptr when the key is not in the table.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+const DataType* HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::find(const KeyType& key_) const {
+    KeyHash hashFunc;
+    return find_hashed(key_, hashFunc(key_));
+}
+
+/**
+ * @brief Locates the data associated with a key, for in-place modification. See the const overload.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+DataType* HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::find(const KeyType& key_) {
+    return const_cast<DataType*>(static_cast<const HashTbl*>(this)->find(key_));
+}
+
+/**
+ * @brief Same as find(), with the hash of the key already computed by the caller (hasher()(key_)), so batched and
+ * partitioned lookups hash every key only once.
+ *
+ * @param key_ Data key to search for in the table.
+ * @param hash_ KeyHash()(key_).
+ * @return Pointer to the data, or nullptr when the key is not in the table.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+const DataType* HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::find_hashed(
+    const KeyType& key_, size_type hash_) const {
+    KeyEqual keyEqual;
+    for (const auto& e : m_table[hash_ % m_size])
+        if (keyEqual(key_, e.m_key)) return &e.m_data;
+    return nullptr;
+}
+
+/**
+ * @brief Looks up many keys at once, overlapping their cache misses.
  *
+ * A single lookup waits for the bucket and then for the first list node, both likely cache misses on a large table.
+ * The keys are taken in groups: all the buckets of a group are prefetched, then all their first nodes, and only then
+ * are the lists walked, so the misses of a group are in flight together instead of one after the other.
+ *
+ * The keys of a group are hashed together: with a KeyHash that has a batch form (IntBatchHash, FixedStringBatchHash),
+ * several keys per SIMD instruction.
+ *
+ * @param keys_ Keys to search for.
+ * @param n_ Number of keys.
+ * @param out_ Receives, for each key, a pointer to its data or nullptr (see find()).
+ * @return Number of keys found.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-void HashTbl<KeyType, DataType, KeyHash, KeyEqual>::rehash(void) {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::size_type
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::retrieve_many(const KeyType* keys_, size_type n_,
+                                                                              const DataType** out_) const {
+    const size_type group = 16;
+    KeyHash hashFunc;
+    size_type hashes[group], found{0};
+    for (size_type first{0}; first < n_; first += group) {
+        size_type last = std::min(n_, first + group);
+        // The whole group is hashed at once, through KeyHash::hash_batch() when it has one (see batch_hash.h).
+        detail::hash_keys(hashFunc, keys_ + first, last - first, hashes);
+        for (size_type i{first}; i < last; i++) prefetch_bucket(hashes[i - first]);
+        for (size_type i{first}; i < last; i++) prefetch_entry(hashes[i - first]);
+        for (size_type i{first}; i < last; i++) {
+            out_[i] = find_hashed(keys_[i], hashes[i - first]);
+            found += out_[i] != nullptr;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Hints the CPU to bring into cache the bucket of a key, given its hash. Does nothing without compiler support.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+void HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::prefetch_bucket(size_type hash_) const {
+#if defined(__GNUC__)
+    __builtin_prefetch(&m_table[hash_ % m_size]);
+#else
+    (void)hash_;
+#endif
+}
+
+/**
+ * @brief Hints the CPU to bring into cache the first entry in the bucket of a key, given its hash. Reads the bucket, so
+ * call prefetch_bucket() some time before.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+void HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::prefetch_entry(size_type hash_) const {
+#if defined(__GNUC__)
+    const auto& list = m_table[hash_ % m_size];
+    if (!list.empty()) __builtin_prefetch(&list.front());
+#else
+    (void)hash_;
+#endif
+}
+
+/**
+ * @brief It is a private method that must be called when the load factor λ is greater than max_load_factor(). This
+ * method will create a new table whose size will be equal to smaller prime number than twice the size of the table
+ * before the rehash() call.
+ *
+ * The nodes of the collision lists are moved (spliced) into the new table instead of being copied, so no element is
+ * copied or reallocated and references to the stored data remain valid.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+void HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::rehash(void) {
+    std::chrono::steady_clock::time_point start;
+    if (Observer::enabled) start = std::chrono::steady_clock::now();
+    m_observer.on_rehash_start(m_size, m_count);
+
+    KeyHash hashFunc;
     auto _old_m_size = m_size;
     m_size = find_next_prime(2 * m_size);
-    std::unique_ptr<list_type[]> _old_m_table = std::move(m_table);
-    m_table = std::make_unique<list_type[]>(m_size);
-    m_count = 0;
+    bucket_array _old_m_table = std::move(m_table);
+    m_table = make_buckets(m_size);
 
     for (std::size_t index{0}; index < _old_m_size; index++) {
-        for (const auto& e : _old_m_table[index]) insert(e.m_key, e.m_data);
-        _old_m_table[index].~forward_list();
+        auto& old_list = _old_m_table[index];
+        while (!old_list.empty()) {
+            auto& new_list = m_table[hashFunc(old_list.front().m_key) % m_size];
+            new_list.splice_after(new_list.before_begin(), old_list, old_list.before_begin());
+        }
     }
 
     _old_m_table.reset();
+
+    std::chrono::nanoseconds elapsed{0};
+    if (Observer::enabled)
+        elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    m_observer.on_rehash_end(_old_m_size, m_size, m_count, elapsed);
+}
+
+/**
+ * @brief Reports the collision list at index_ to the observer if it is longer than the observer's threshold. Only
+ * called when the observer is enabled, since it walks the whole list.
+ *
+ * @param index_ Bucket that has just grown.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+void HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::check_chain(size_type index_) {
+    auto length = static_cast<size_type>(std::distance(m_table[index_].begin(), m_table[index_].end()));
+    if (length > m_observer.long_chain_threshold()) m_observer.on_long_chain(index_, length);
 }
 
 /**
@@ -203,34 +356,328 @@ void HashTbl<KeyType, DataType, KeyHash, KeyEqual>::rehash(void) {
  * @param key_ Data key.
  * @return If the key is found the method returns true, false otherwise.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::erase(const KeyType& key_) {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+bool HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::erase(const KeyType& key_) {
     KeyHash hashFunc;
-    KeyEqual keyEqual;
-    auto index{hashFunc(key_) % m_size};
+    return erase_in_bucket(hashFunc(key_) % m_size, key_);
+}
 
-    auto predicate = [&key_, &keyEqual](const HashEntry<KeyType, DataType> hashEntry) {
-        return keyEqual(key_, hashEntry.m_key);
+/**
+ * @brief Removes every key of the range [first_, last_). The keys are hashed once and sorted by bucket, so the
+ * buckets are visited in memory order and keys sharing a bucket are removed in one walk of its list.
+ *
+ * @param first_ Beginning of the range of keys (forward iterators: the keys are referenced, not copied).
+ * @param last_ End of the range of keys.
+ * @return Number of elements removed. Keys not in the table, or repeated in the range, are skipped.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+template <class ForwardIt, class>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::size_type
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::erase(ForwardIt first_, ForwardIt last_) {
+    KeyHash hashFunc;
+    std::vector<std::pair<size_type, const KeyType*> > keys;
+    for (auto it = first_; it != last_; ++it) keys.emplace_back(hashFunc(*it) % m_size, &*it);
+    std::sort(keys.begin(), keys.end(),
+              [](const std::pair<size_type, const KeyType*>& a_, const std::pair<size_type, const KeyType*>& b_) {
+                  return a_.first < b_.first;
+              });
+
+    size_type removed{0};
+    for (std::size_t i{0}, j; i < keys.size(); i = j) {
+        for (j = i + 1; j < keys.size() and keys[j].first == keys[i].first;) j++;
+        if (j - i == 1) {
+            removed += erase_in_bucket(keys[i].first, *keys[i].second);
+            continue;
+        }
+        KeyEqual keyEqual;
+        auto wanted = [&](const KeyType& key_, const DataType&) {
+            for (auto k = i; k < j; k++)
+                if (keyEqual(*keys[k].second, key_)) return true;
+            return false;
+        };
+        auto n = sweep_bucket(keys[i].first, wanted);
+        count_erased(n);
+        removed += n;
+    }
+    return removed;
+}
+
+/**
+ * @brief Removes every element for which pred_(key, data) is true, in a single sweep over the buckets that unlinks the
+ * matching nodes in place. Nothing is rehashed and no key is hashed.
+ *
+ * @param pred_ Callable as pred_(const KeyType&, const DataType&), returning bool.
+ * @return Number of elements removed.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+template <class Pred>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::size_type
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::erase_if(Pred pred_) {
+    size_type removed{0};
+    for (std::size_t index{0}; index < m_size; index++) removed += sweep_bucket(index, pred_);
+    count_erased(removed);
+    return removed;
+}
+
+/**
+ * @brief Same as erase_if(), with the buckets split over the workers of pool_. Each worker only touches its own
+ * buckets, so no locking is needed, but pred_ runs on several threads at once and the nodes are freed concurrently:
+ * the allocator must be thread-safe (std::allocator is). The observer is notified after the sweep, from this thread.
+ *
+ * @param pred_ Callable as pred_(const KeyType&, const DataType&), returning bool.
+ * @param pool_ Workers to use; by default the process-wide pool.
+ * @return Number of elements removed.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+template <class Pred>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::size_type
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::parallel_erase_if(Pred pred_, ThreadPool& pool_) {
+    std::vector<size_type> removed(pool_.size(), 0);
+    pool_.parallel_for(0, m_size, 0, [&](std::size_t lo_, std::size_t hi_, unsigned worker_) {
+        Pred pred = pred_;
+        size_type n{0};
+        for (std::size_t index{lo_}; index < hi_; index++) n += sweep_bucket(index, pred);
+        removed[worker_] += n;
+    });
+    size_type total{0};
+    for (auto n : removed) total += n;
+    count_erased(total);
+    return total;
+}
+
+/**
+ * @brief Applies a batch of updates (balance adjustments, say) to the data of their keys, visiting the table in bucket
+ * order rather than in the order of the batch.
+ *
+ * Applying the operations one by one jumps to a random bucket each time. Here every key is hashed once, the operations
+ * are radix-sorted by bucket index, and then applied front to back through the bucket array, so the buckets are read
+ * in memory order and an operation often finds its bucket already in cache from the previous one. The sort is stable:
+ * operations on the same key are applied in the order of the batch. Only existing elements are updated; the table is
+ * neither grown nor rehashed, and the observer sees no event.
+ *
+ * The sort is not free: it pays off when a lookup is expensive (long composite keys such as Account::AcctKey), while
+ * for int keys a plain loop of find() is faster, its lookups overlapping well enough (see bench/bench_apply.cpp).
+ *
+ * @param first_ First operation.
+ * @param last_ End of the operations.
+ * @param key_of_ Callable as key_of_(const Op&), returning the key (or a reference to it) the operation is for.
+ * @param apply_ Callable as apply_(const Op&, DataType&), for each operation whose key is in the table.
+ * @return Number of operations applied. Operations on keys not in the table are skipped.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+template <class ForwardIt, class KeyOf, class Apply>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::size_type
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::apply_batch(ForwardIt first_, ForwardIt last_,
+                                                                            KeyOf key_of_, Apply apply_) {
+    auto ops = sort_by_bucket(first_, last_, key_of_);
+    return apply_sorted(ops, 0, ops.size(), key_of_, apply_);
+}
+
+/**
+ * @brief Same as apply_batch(), with the sorted operations split over the workers of pool_ by bucket range. A bucket
+ * never straddles two ranges, so each worker only touches its own buckets and no locking is needed; operations on the
+ * same key still run in batch order, on one worker. apply_ runs on several threads at once, on different elements.
+ * The sort itself runs on the calling thread.
+ *
+ * @param pool_ Workers to use; by default the process-wide pool.
+ * @return Number of operations applied.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+template <class ForwardIt, class KeyOf, class Apply>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::size_type
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::parallel_apply_batch(ForwardIt first_,
+                                                                                     ForwardIt last_, KeyOf key_of_,
+                                                                                     Apply apply_,
+                                                                                     ThreadPool& pool_) {
+    auto ops = sort_by_bucket(first_, last_, key_of_);
+    size_type n = ops.size();
+    // Several ranges per worker, for stealing to balance them; each range is moved forward to a bucket boundary.
+    size_type ranges = std::max<size_type>(1, std::min<size_type>(n / 1024, pool_.size() * 8));
+    auto boundary = [&](size_type i) {
+        while (i > 0 and i < n and ops[i].bucket == ops[i - 1].bucket) i++;
+        return i;
     };
-    auto iterator = std::find_if(m_table[index].begin(), m_table[index].end(), predicate);
+    std::vector<size_type> applied(pool_.size(), 0);
+    pool_.parallel_for(0, ranges, 1, [&](std::size_t lo_, std::size_t hi_, unsigned worker_) {
+        KeyOf key_of = key_of_;
+        Apply apply = apply_;
+        applied[worker_] += apply_sorted(ops, boundary(n * lo_ / ranges), boundary(n * hi_ / ranges), key_of, apply);
+    });
+    size_type total{0};
+    for (auto a : applied) total += a;
+    return total;
+}
 
-    if (iterator != m_table[index].end()) {
-        m_table[index].remove_if(predicate);
-        m_count--;
-        return true;
+/**
+ * @brief Hashes the keys of a batch of operations and sorts the operations by bucket, keeping the order of those that
+ * share a bucket.
+ *
+ * A plain least-significant-digit radix sort would scatter the whole batch over memory once per digit. Here only the
+ * first pass does: it partitions the batch on the high bits of the bucket index, into partitions small enough to stay
+ * in cache while a second counting pass (or, for a handful of operations, an insertion sort) orders them on the low
+ * bits. Both passes are stable.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+template <class ForwardIt, class KeyOf>
+std::vector<typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::template BucketedOp<
+    typename std::iterator_traits<ForwardIt>::value_type> >
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::sort_by_bucket(ForwardIt first_, ForwardIt last_,
+                                                                               KeyOf& key_of_) const {
+    using Op = typename std::iterator_traits<ForwardIt>::value_type;
+    KeyHash hashFunc;
+    std::vector<BucketedOp<Op> > ops, scratch;
+    ops.reserve(static_cast<size_type>(std::distance(first_, last_)));
+    for (auto it = first_; it != last_; ++it) ops.push_back({hashFunc(key_of_(*it)) % m_size, &*it});
+    scratch.resize(ops.size());
+
+    // Stable scatter of src_[0, n_) into dst_ by the digit_bits bits of the bucket index above shift_. Leaves in
+    // next_[d] the end of the run of digit d.
+    std::vector<size_type> next;
+    auto counting_pass = [&next](const BucketedOp<Op>* src_, BucketedOp<Op>* dst_, size_type n_, unsigned shift_,
+                                 unsigned digit_bits_) {
+        size_type mask = (size_type(1) << digit_bits_) - 1;
+        next.assign(mask + 1, 0);
+        for (size_type i{0}; i < n_; i++) next[src_[i].bucket >> shift_ & mask]++;
+        size_type start{0};
+        for (auto& c : next) {
+            auto count = c;
+            c = start;
+            start += count;
+        }
+        for (size_type i{0}; i < n_; i++) dst_[next[src_[i].bucket >> shift_ & mask]++] = src_[i];
+    };
+
+    unsigned bits{0};
+    while (bits < 8 * sizeof(size_type) and (m_size - 1) >> bits) bits++;
+    // 4096 low digits keep the second pass in cache; up to 65536 partitions keep the first pass from thrashing the TLB.
+    unsigned low_bits = std::min(bits, std::max(12u, bits > 16 ? bits - 16 : 0u)), high_bits = bits - low_bits;
+    if (high_bits == 0) {
+        counting_pass(ops.data(), scratch.data(), ops.size(), 0, low_bits);
+        return scratch;
     }
+    counting_pass(ops.data(), scratch.data(), ops.size(), low_bits, high_bits);
+    std::vector<size_type> ends;
+    ends.swap(next);
+    const size_type low_mask = (size_type(1) << low_bits) - 1, few = 32;
+    for (size_type d{0}, begin{0}; d < ends.size(); begin = ends[d++]) {
+        size_type n = ends[d] - begin;
+        if (n > few) {
+            counting_pass(scratch.data() + begin, ops.data() + begin, n, 0, low_bits);
+            continue;
+        }
+        for (size_type i{begin}; i < ends[d]; i++) {
+            auto o = scratch[i];
+            size_type j{i};
+            for (; j > begin and (ops[j - 1].bucket & low_mask) > (o.bucket & low_mask); j--) ops[j] = ops[j - 1];
+            ops[j] = o;
+        }
+    }
+    return ops;
+}
+
+/**
+ * @brief Applies the sorted operations [lo_, hi_) of ops_, prefetching the first entries of the buckets a few
+ * operations ahead: the buckets come in order, but their list nodes are spread over the heap.
+ *
+ * @return Number of operations whose key was found.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+template <class Op, class KeyOf, class Apply>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::size_type
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::apply_sorted(const std::vector<BucketedOp<Op> >& ops_,
+                                                                             size_type lo_, size_type hi_,
+                                                                             KeyOf& key_of_, Apply& apply_) {
+    const size_type ahead = 8;
+    size_type applied{0};
+    for (size_type i{lo_}; i < hi_; i++) {
+        // A bucket index is its own hash modulo m_size, so it can stand for the hash.
+        if (i + ahead < hi_) prefetch_entry(ops_[i + ahead].bucket);
+        const Op& op = *ops_[i].op;
+        auto data = const_cast<DataType*>(find_hashed(key_of_(op), ops_[i].bucket));
+        if (data) {
+            apply_(op, *data);
+            applied++;
+        }
+    }
+    return applied;
+}
 
+/**
+ * @brief Removes key_ from the given bucket, walking its list once.
+ *
+ * @param index_ Bucket of key_.
+ * @param key_ Data key.
+ * @return True if the key was found and removed.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+bool HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::erase_in_bucket(size_type index_,
+                                                                                     const KeyType& key_) {
+    KeyEqual keyEqual;
+    auto& list = m_table[index_];
+    for (auto prev = list.before_begin(), it = list.begin(); it != list.end(); prev = it++) {
+        if (keyEqual(key_, it->m_key)) {
+            list.erase_after(prev);
+            m_count--;
+            m_observer.on_erase(m_count);
+            return true;
+        }
+    }
     return false;
 }
 
+/**
+ * @brief Unlinks from one bucket every node for which pred_(key, data) is true. Leaves m_count alone, so it can run on
+ * several buckets at once; the caller accounts for the removals with count_erased().
+ *
+ * @return Number of nodes removed.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+template <class Pred>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::size_type
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::sweep_bucket(size_type index_, Pred& pred_) {
+    auto& list = m_table[index_];
+    size_type removed{0};
+    auto prev = list.before_begin();
+    for (auto it = list.begin(); it != list.end();) {
+        if (pred_(static_cast<const KeyType&>(it->m_key), static_cast<const DataType&>(it->m_data))) {
+            it = list.erase_after(prev);
+            removed++;
+        } else {
+            prev = it++;
+        }
+    }
+    return removed;
+}
+
+/**
+ * @brief Takes n_ removals made by sweep_bucket() into account, notifying the observer of each one.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+void HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::count_erased(size_type n_) {
+    // With the NullObserver the loop folds into a subtraction.
+    for (size_type i{0}; i < n_; i++) m_observer.on_erase(--m_count);
+}
+
 /**
  * @brief Find the next prime greater than number.
  *
  * @param n_ smaller than the next prime number.
  * @return Prime number.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-std::size_t HashTbl<KeyType, DataType, KeyHash, KeyEqual>::find_next_prime(size_type n_) {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+std::size_t HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::find_next_prime(size_type n_) {
     while (!is_prime(n_)) n_++;
     return n_;
 }
@@ -241,8 +688,9 @@ std::size_t HashTbl<KeyType, DataType, KeyHash, KeyEqual>::find_next_prime(size_
  * @param number Number that will be checked for prime.
  * @return True if it is prime, false otherwise.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::is_prime(const size_type& number) {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+bool HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::is_prime(const size_type& number) {
     if (number == 2 || number == 3) return true;
     if (number % 2 == 0 || number % 3 == 0) return false;
 
@@ -262,9 +710,10 @@ bool HashTbl<KeyType, DataType, KeyHash, KeyEqual>::is_prime(const size_type& nu
  * @param key_ Data key.
  * @return Number of elements inside collision list.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-typename HashTbl<KeyType, DataType, KeyHash, KeyEqual>::size_type HashTbl<KeyType, DataType, KeyHash, KeyEqual>::count(
-    const KeyType& key_) const {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::size_type
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::count(const KeyType& key_) const {
     KeyHash hashFunc;
     KeyEqual keyEqual;
     auto index{hashFunc(key_) % m_size};
@@ -286,8 +735,9 @@ typename HashTbl<KeyType, DataType, KeyHash, KeyEqual>::size_type HashTbl<KeyTyp
  * @param key_ Data key of the element to find.
  * @return Reference to the data of the requested element.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-DataType& HashTbl<KeyType, DataType, KeyHash, KeyEqual>::at(const KeyType& key_) {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+DataType& HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::at(const KeyType& key_) {
     KeyHash hashFunc;
     KeyEqual keyEqual;
     auto index{hashFunc(key_) % m_size};
@@ -310,8 +760,9 @@ DataType& HashTbl<KeyType, DataType, KeyHash, KeyEqual>::at(const KeyType& key_)
  * @return Returns a reference to the data associated with the data key provided, if exist. If the key is not in the
  * table, return the reference for the data just inserted into the table.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-DataType& HashTbl<KeyType, DataType, KeyHash, KeyEqual>::operator[](const KeyType& key_) {
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+DataType& HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::operator[](const KeyType& key_) {
     KeyHash hashFunc;
     KeyEqual keyEqual;
     auto index{hashFunc(key_) % m_size};
@@ -333,9 +784,10 @@ DataType& HashTbl<KeyType, DataType, KeyHash, KeyEqual>::operator[](const KeyTyp
  *
  * @return Current maximum load factor.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-float HashTbl<KeyType, DataType, KeyHash, KeyEqual>::max_load_factor() const {
-    return m_load_factor;
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+float HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::max_load_factor() const {
+    return m_observer.load_factor;
 }
 
 /**
@@ -343,9 +795,152 @@ float HashTbl<KeyType, DataType, KeyHash, KeyEqual>::max_load_factor() const {
  *
  * @param mlf New maximum load factor setting.
  */
-template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual>
-void HashTbl<KeyType, DataType, KeyHash, KeyEqual>::max_load_factor(float mlf) {
-    m_load_factor = mlf;
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+void HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::max_load_factor(float mlf) {
+    m_observer.load_factor = mlf;
+}
+
+/**
+ * @brief Returns the number of elements stored in the collision list of a given bucket.
+ *
+ * @param n_ Bucket index, must be smaller than bucket_count().
+ * @return Length of the collision list at index n_.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::size_type
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::bucket_size(size_type n_) const {
+    return std::distance(m_table[n_].begin(), m_table[n_].end());
+}
+
+/**
+ * @brief Returns the index of the bucket a key is mapped to, using the same reduction as insert() and retrieve().
+ *
+ * @param key_ Data key.
+ * @return Bucket index in the range [0, bucket_count()).
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::size_type
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::bucket(const KeyType& key_) const {
+    KeyHash hashFunc;
+    return hashFunc(key_) % m_size;
+}
+
+/**
+ * @brief Reports the memory held by the table: the bucket array, the list nodes and, through the heap_bytes()
+ * customization point (see memory_usage.h), the heap blocks owned by the stored keys and data.
+ *
+ * @return The footprint split by category. Allocator bookkeeping (malloc headers, rounding) is not included.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+MemoryUsage HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::memory_usage() const {
+    using ac::heap_bytes;
+    MemoryUsage usage;
+    usage.bucket_bytes = m_size * sizeof(list_type);
+    usage.node_bytes = m_count * node_size;
+    for (std::size_t index{0}; index < m_size; index++) {
+        for (const auto& e : m_table[index]) usage.owned_heap_bytes += heap_bytes(e.m_key) + heap_bytes(e.m_data);
+    }
+    return usage;
+}
+
+/**
+ * @brief Calls fn_(key, data) for every element, bucket by bucket, on the calling thread.
+ *
+ * @param fn_ Callable as fn_(const KeyType&, const DataType&).
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+template <class Fn>
+void HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::for_each(Fn fn_) const {
+    for (std::size_t index{0}; index < m_size; index++) {
+        for (const auto& e : m_table[index]) fn_(e.m_key, e.m_data);
+    }
+}
+
+/**
+ * @brief Calls fn_(key, data) for every element, spreading the buckets over the workers of pool_. Chains of uneven
+ * length are balanced by work stealing (see ThreadPool).
+ *
+ * The elements are passed as const references and the table must not be modified until the call returns; fn_ runs
+ * on several threads at once, so whatever it writes to must be thread-safe.
+ *
+ * @param fn_ Callable as fn_(const KeyType&, const DataType&).
+ * @param pool_ Workers to use; by default the process-wide pool.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+template <class Fn>
+void HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::parallel_for_each(Fn fn_,
+                                                                                     ThreadPool& pool_) const {
+    pool_.parallel_for(0, m_size, 0, [&](std::size_t lo_, std::size_t hi_, unsigned) {
+        for (std::size_t index{lo_}; index < hi_; index++) {
+            for (const auto& e : m_table[index]) fn_(e.m_key, e.m_data);
+        }
+    });
+}
+
+/**
+ * @brief Maps every element to a T and folds the results, in parallel like parallel_for_each().
+ *
+ * Each worker folds its own partial result, seeded with init_, and the partials are folded together at the end, so
+ * init_ must be an identity of combine_ (0 for a sum) and combine_ must be associative and commutative. Floating-point
+ * sums may differ in the last digits between runs, since the order of the additions depends on the scheduling.
+ *
+ * map_ may return a lighter type U than T (say, one (bank, balance) pair folded into per-bank totals); combine_ then
+ * needs an overload for (T, U) besides the one for (T, T) that merges the partials.
+ *
+ * @param init_ Identity of combine_.
+ * @param map_ Callable as map_(const KeyType&, const DataType&), returning a T or a U.
+ * @param combine_ Callable as combine_(T, T) and, if map_ returns a U, combine_(T, U); returns a T.
+ * @param pool_ Workers to use; by default the process-wide pool.
+ * @return The fold of all the mapped elements (init_ for an empty table).
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+template <class T, class Map, class Combine>
+T HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::parallel_reduce(T init_, Map map_,
+                                                                                 Combine combine_,
+                                                                                 ThreadPool& pool_) const {
+    std::vector<T> partials(pool_.size(), init_);
+    pool_.parallel_for(0, m_size, 0, [&](std::size_t lo_, std::size_t hi_, unsigned worker_) {
+        // Folding into a local first keeps the workers from writing next to each other in partials.
+        T acc = init_;
+        for (std::size_t index{lo_}; index < hi_; index++) {
+            for (const auto& e : m_table[index]) acc = combine_(std::move(acc), map_(e.m_key, e.m_data));
+        }
+        partials[worker_] = combine_(std::move(partials[worker_]), std::move(acc));
+    });
+    T result = init_;
+    for (auto& p : partials) result = combine_(std::move(result), std::move(p));
+    return result;
+}
+
+/**
+ * @brief Allocates and default-constructs a bucket array through the table allocator.
+ *
+ * @param n_ Number of buckets.
+ * @return Owning pointer whose deleter destroys the lists and gives the memory back to the allocator.
+ */
+template <typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename Observer,
+          typename Alloc>
+typename HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::bucket_array
+HashTbl<KeyType, DataType, KeyHash, KeyEqual, Observer, Alloc>::make_buckets(size_type n_) {
+    bucket_allocator alloc;
+    list_type* buckets = bucket_traits::allocate(alloc, n_);
+    size_type built{0};
+    try {
+        for (; built < n_; built++) bucket_traits::construct(alloc, buckets + built);
+    } catch (...) {
+        // A throwing construct() must not leak the array: undo the lists already built and give the memory back.
+        for (size_type i{0}; i < built; i++) bucket_traits::destroy(alloc, buckets + i);
+        bucket_traits::deallocate(alloc, buckets, n_);
+        throw;
+    }
+    return bucket_array(buckets, BucketDeleter{n_});
 }
 
 }  // Namespace ac.
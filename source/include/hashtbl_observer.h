@@ -0,0 +1,176 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _HASHTBL_OBSERVER_H_
+#define _HASHTBL_OBSERVER_H_
+
+#include <atomic>    // std::atomic
+#include <chrono>    // std::chrono::nanoseconds
+#include <cstddef>   // std::size_t
+#include <cstdio>    // std::snprintf
+#include <limits>    // std::numeric_limits
+#include <memory>    // std::shared_ptr
+#include <mutex>     // std::mutex
+#include <ostream>   // std::ostream
+#include <string>    // std::string
+
+#include "latency_histogram.h"
+
+namespace ac  // Associative container
+{
+/**
+ * @brief Default observer policy of HashTbl: every hook is an empty inline function and `enabled` is false, so the
+ * table skips the clock reads and chain walks that only exist to feed an observer. A table using it compiles to the
+ * same code as one without hooks.
+ *
+ * A custom observer provides the same members:
+ *  - `static constexpr bool enabled`: set to true to receive the hooks that cost extra work (timing, chain lengths).
+ *  - `on_insert(size)`, `on_erase(size)`: an element was added or removed; size is the new element count.
+ *  - `on_rehash_start(buckets, size)`, `on_rehash_end(old_buckets, new_buckets, size, duration)`.
+ *  - `long_chain_threshold()` and `on_long_chain(bucket, length)`: called after an insert leaves a collision list
+ *    longer than the threshold.
+ */
+struct NullObserver {
+    static constexpr bool enabled = false;
+
+    void on_insert(std::size_t) {}
+    void on_erase(std::size_t) {}
+    void on_rehash_start(std::size_t, std::size_t) {}
+    void on_rehash_end(std::size_t, std::size_t, std::size_t, std::chrono::nanoseconds) {}
+    std::size_t long_chain_threshold() const { return std::numeric_limits<std::size_t>::max(); }
+    void on_long_chain(std::size_t, std::size_t) {}
+};
+
+/**
+ * @brief Observer that feeds the rehash() durations into a LatencyHistogram and counts the events that break the
+ * configured limits, for alerting in production.
+ */
+struct LatencyObserver : NullObserver {
+    static constexpr bool enabled = true;
+
+    std::shared_ptr<LatencyHistogram> rehash_ns{std::make_shared<LatencyHistogram>()};  //!< Shared by table copies.
+    std::chrono::nanoseconds rehash_budget{std::chrono::milliseconds(1)};  //!< Rehashes above it are counted.
+    std::size_t chain_threshold{8};                                         //!< Longer lists are counted.
+    std::size_t over_budget_rehashes{0};                                    //!< Rehashes that took too long.
+    std::size_t long_chains{0};                                             //!< Inserts that left a long list.
+
+    void on_rehash_end(std::size_t, std::size_t, std::size_t, std::chrono::nanoseconds dur_) {
+        rehash_ns->record(static_cast<std::uint64_t>(dur_.count()));
+        if (dur_ > rehash_budget) over_budget_rehashes++;
+    }
+    std::size_t long_chain_threshold() const { return chain_threshold; }
+    void on_long_chain(std::size_t, std::size_t) { long_chains++; }
+};
+
+/**
+ * @brief Observer that writes the table events in Chrome trace JSON format (load the file in chrome://tracing or
+ * Perfetto). Rehashes become complete ("X") events carrying the sizes, long chains and over-budget rehashes become
+ * instant events, and insert/erase totals become counter ("C") events emitted at every rehash and on flush().
+ *
+ * Copies of the observer (made when a table is copied) share the same writer and totals, and may be used from
+ * different threads: the totals are atomic and the writes go under a lock. Nothing is written until attach().
+ * Events end with a comma and the array is left open, which the trace viewers accept, so the file is valid as soon as
+ * it is flushed even if the process dies.
+ */
+class ChromeTraceObserver : public NullObserver {
+   public:
+    static constexpr bool enabled = true;
+
+    /// Starts writing to os_, which must outlive every copy of the observer. Writes the opening bracket.
+    void attach(std::ostream& os_, const std::string& table_name_ = "HashTbl") {
+        m_state = std::make_shared<State>();
+        m_state->os = &os_;
+        m_state->name = json_escape(table_name_);
+        m_state->epoch = std::chrono::steady_clock::now();
+        os_ << "[\n";
+    }
+
+    std::chrono::nanoseconds rehash_budget{std::chrono::milliseconds(1)};  //!< Slower rehashes get an alert event.
+    std::size_t chain_threshold{8};                                         //!< Longer lists get an alert event.
+
+    void on_insert(std::size_t) {
+        if (m_state) m_state->inserts.fetch_add(1, std::memory_order_relaxed);
+    }
+    void on_erase(std::size_t) {
+        if (m_state) m_state->erases.fetch_add(1, std::memory_order_relaxed);
+    }
+    void on_rehash_start(std::size_t, std::size_t) {
+        if (m_state) m_rehash_start = std::chrono::steady_clock::now();
+    }
+    void on_rehash_end(std::size_t old_buckets_, std::size_t new_buckets_, std::size_t size_,
+                       std::chrono::nanoseconds dur_) {
+        if (!m_state) return;
+        std::lock_guard<std::mutex> guard(m_state->lock);
+        auto ts = micros(m_rehash_start);
+        event("rehash", "X", ts) << ",\"dur\":" << dur_.count() / 1000.0 << ",\"args\":{\"old_buckets\":"
+                                 << old_buckets_ << ",\"new_buckets\":" << new_buckets_ << ",\"size\":" << size_
+                                 << "}},\n";
+        if (dur_ > rehash_budget)
+            event("rehash_over_budget", "i", ts) << ",\"s\":\"p\",\"args\":{\"dur_us\":" << dur_.count() / 1000.0
+                                                 << "}},\n";
+        counters();
+    }
+    std::size_t long_chain_threshold() const {
+        return m_state ? chain_threshold : NullObserver::long_chain_threshold();
+    }
+    void on_long_chain(std::size_t bucket_, std::size_t length_) {
+        if (!m_state) return;
+        std::lock_guard<std::mutex> guard(m_state->lock);
+        event("long_chain", "i", micros(std::chrono::steady_clock::now()))
+            << ",\"s\":\"t\",\"args\":{\"bucket\":" << bucket_ << ",\"length\":" << length_ << "}},\n";
+    }
+
+    /// Emits the current insert/erase totals and flushes the stream.
+    void flush() {
+        if (!m_state) return;
+        std::lock_guard<std::mutex> guard(m_state->lock);
+        counters();
+        m_state->os->flush();
+    }
+
+   private:
+    struct State {
+        std::ostream* os{nullptr};
+        std::string name;  //!< Already escaped for JSON.
+        std::mutex lock;   //!< Guards the stream.
+        std::chrono::steady_clock::time_point epoch;
+        std::atomic<std::size_t> inserts{0}, erases{0};
+    };
+    std::shared_ptr<State> m_state;  //!< Null until attach().
+    /// Start of the rehash in progress. Kept per copy: a copy is the observer of one table, which rehashes alone.
+    std::chrono::steady_clock::time_point m_rehash_start;
+
+    /// text_ as the contents of a JSON string: quotes, backslashes and control characters escaped.
+    static std::string json_escape(const std::string& text_) {
+        std::string out;
+        for (char c : text_) {
+            if (c == '"' or c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof buf, "\\u%04x", static_cast<unsigned>(c));
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    double micros(std::chrono::steady_clock::time_point t_) const {
+        return std::chrono::duration<double, std::micro>(t_ - m_state->epoch).count();
+    }
+    /// Writes the fields common to every event, leaving the object open for the specific ones.
+    std::ostream& event(const char* name_, const char* phase_, double ts_) {
+        return *m_state->os << "{\"name\":\"" << name_ << "\",\"cat\":\"" << m_state->name << "\",\"ph\":\"" << phase_
+                            << "\",\"ts\":" << ts_ << ",\"pid\":1,\"tid\":1";
+    }
+    void counters() {
+        event("operations", "C", micros(std::chrono::steady_clock::now()))
+            << ",\"args\":{\"inserts\":" << m_state->inserts.load(std::memory_order_relaxed)
+            << ",\"erases\":" << m_state->erases.load(std::memory_order_relaxed) << "}},\n";
+    }
+};
+
+}  // namespace ac
+#endif
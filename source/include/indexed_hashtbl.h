@@ -0,0 +1,236 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _INDEXED_HASHTBL_H_
+#define _INDEXED_HASHTBL_H_
+
+#include <cstddef>      // std::size_t
+#include <functional>   // std::hash, std::equal_to, std::less
+#include <memory>       // std::unique_ptr
+#include <type_traits>  // std::decay
+#include <utility>      // std::move, std::declval
+#include <vector>       // std::vector
+
+#include "hash_utils.h"
+#include "hashtbl.h"
+
+namespace ac  // Associative container
+{
+/**
+ * @brief Interface of a secondary index of IndexedHashTbl. An index refers to the values stored in the primary table
+ * by address (they never move, see HashTbl::find()) and is told about every value that enters or leaves the table.
+ */
+template <class DataType>
+class IndexBase {
+   public:
+    virtual ~IndexBase() = default;
+    /// The value at data_ was added to the primary table (or changed: on_erase() was called before the change).
+    virtual void on_insert(const DataType* data_) = 0;
+    /// The value at data_ is about to leave the primary table (or to change); it is still intact.
+    virtual void on_erase(const DataType* data_) = 0;
+    /// The values were already in the primary table when the index was attached. Indexes that build faster in one
+    /// go than value by value override it.
+    virtual void bulk_insert(const std::vector<const DataType*>& data_) {
+        for (auto d : data_) on_insert(d);
+    }
+    /// The primary table was emptied.
+    virtual void clear() = 0;
+};
+
+/// Type of the key extracted by a projection from a value.
+template <class DataType, class Proj>
+using projected_t = typename std::decay<decltype(std::declval<Proj&>()(std::declval<const DataType&>()))>::type;
+
+template <class DataType, class Proj, class Compare>
+class OrderedIndex;  // See ordered_index.h.
+template <class DataType, class Proj>
+class PrefixIndex;  // See prefix_index.h.
+
+/**
+ * @brief Secondary hash index: maps a projection of the value (a field, or a pair of fields) to the values sharing it.
+ *
+ * Every projected key holds a posting list of pointers into the primary table; a second table remembers where each
+ * value sits in its list, so removals take constant time even for keys shared by millions of values.
+ */
+template <class DataType, class Proj, class ProjHash, class ProjEqual>
+class HashIndex : public IndexBase<DataType> {
+   public:
+    using key_type = projected_t<DataType, Proj>;
+    using postings = std::vector<const DataType*>;
+
+    explicit HashIndex(Proj proj_) : m_proj(std::move(proj_)) {}
+
+    /// Values whose projection equals key_ (empty when there are none), in no particular order.
+    const postings& find(const key_type& key_) const {
+        static const postings none;
+        auto list = m_postings.find(key_);
+        return list ? *list : none;
+    }
+    /// Number of values whose projection equals key_.
+    std::size_t count(const key_type& key_) const { return find(key_).size(); }
+    /// Number of distinct projected keys.
+    std::size_t distinct() const { return m_postings.size(); }
+
+    void on_insert(const DataType* data_) override {
+        auto key = m_proj(*data_);
+        auto list = m_postings.find(key);
+        if (!list) {
+            m_postings.insert(key, postings());
+            list = m_postings.find(key);
+        }
+        m_slots.insert(data_, list->size());
+        list->push_back(data_);
+    }
+    void on_erase(const DataType* data_) override {
+        auto key = m_proj(*data_);
+        auto list = m_postings.find(key);
+        auto slot = m_slots.find(data_);
+        if (!list or !slot) return;
+        // Fill the hole with the last pointer of the list.
+        auto moved = list->back();
+        (*list)[*slot] = moved;
+        *m_slots.find(moved) = *slot;
+        list->pop_back();
+        m_slots.erase(data_);
+        if (list->empty()) m_postings.erase(key);
+    }
+    void clear() override {
+        m_postings.clear();
+        m_slots.clear();
+    }
+
+   private:
+    Proj m_proj;                                                  //!< Value -> indexed key.
+    HashTbl<key_type, postings, ProjHash, ProjEqual> m_postings;  //!< Indexed key -> values.
+    HashTbl<const DataType*, std::size_t> m_slots;                //!< Value -> position in its posting list.
+};
+
+/**
+ * @brief HashTbl that keeps any number of secondary indexes up to date on insert, erase and update.
+ *
+ * The indexes point at the values stored in the primary table, so nothing is copied. To keep them consistent, all
+ * changes must go through this class: the primary table is only exposed read-only, and values are modified with
+ * update(). Like HashTbl, it is not thread-safe.
+ *
+ * Usage:
+ * ```
+ * ac::IndexedHashTbl<Account::AcctKey, Account, KeyHash, KeyEqual> accounts;
+ * auto& by_branch = accounts.add_index(
+ *     [](const Account& a) { return std::make_pair(a.m_bank_code, a.m_branch_code); }, ac::PairHash());
+ * for (const Account* a : by_branch.find({1, 1668})) ...
+ * ```
+ */
+template <class KeyType, class DataType, class KeyHash = std::hash<KeyType>, class KeyEqual = std::equal_to<KeyType> >
+class IndexedHashTbl {
+   public:
+    using size_type = std::size_t;
+    using primary_type = HashTbl<KeyType, DataType, KeyHash, KeyEqual>;
+
+    IndexedHashTbl() = default;
+    IndexedHashTbl(const IndexedHashTbl&) = delete;  // The indexes point into this very table.
+    IndexedHashTbl& operator=(const IndexedHashTbl&) = delete;
+
+    /**
+     * @brief Adds a hash index on proj_(value), filled with the values already stored.
+     *
+     * @param proj_ Callable as proj_(const DataType&), returning the indexed key.
+     * The optional second and third arguments only select the hash and equality of the indexed key (std::hash by
+     * default, ac::PairHash for pairs); like HashTbl, the index default-constructs its functors.
+     * @return The index, owned by the table and valid as long as it.
+     */
+    template <class Proj, class ProjHash = std::hash<projected_t<DataType, Proj> >,
+              class ProjEqual = std::equal_to<projected_t<DataType, Proj> > >
+    HashIndex<DataType, Proj, ProjHash, ProjEqual>& add_index(Proj proj_, ProjHash = ProjHash(),
+                                                               ProjEqual = ProjEqual()) {
+        using index_type = HashIndex<DataType, Proj, ProjHash, ProjEqual>;
+        return attach(std::unique_ptr<index_type>(new index_type(std::move(proj_))));
+    }
+
+    /**
+     * @brief Adds an ordered index on proj_(value), for range queries; requires ordered_index.h.
+     *
+     * @param proj_ Callable as proj_(const DataType&), returning the indexed key.
+     * @param cmp_ Strict weak order of the indexed keys.
+     * @return The index, owned by the table and valid as long as it.
+     */
+    template <class Proj, class Compare = std::less<projected_t<DataType, Proj> > >
+    OrderedIndex<DataType, Proj, Compare>& add_ordered_index(Proj proj_, Compare cmp_ = Compare()) {
+        using index_type = OrderedIndex<DataType, Proj, Compare>;
+        return attach(std::unique_ptr<index_type>(new index_type(std::move(proj_), std::move(cmp_))));
+    }
+
+    /**
+     * @brief Adds a prefix index on proj_(value), for searches by the beginning of a string; requires prefix_index.h.
+     *
+     * @param proj_ Callable as proj_(const DataType&), returning the indexed string.
+     * @return The index, owned by the table and valid as long as it.
+     */
+    template <class Proj>
+    PrefixIndex<DataType, Proj>& add_prefix_index(Proj proj_) {
+        using index_type = PrefixIndex<DataType, Proj>;
+        return attach(std::unique_ptr<index_type>(new index_type(std::move(proj_))));
+    }
+
+    /// Takes ownership of a custom index and fills it with the values already stored. Returns it.
+    template <class Index>
+    Index& attach(std::unique_ptr<Index> index_) {
+        std::vector<const DataType*> stored;
+        stored.reserve(m_primary.size());
+        m_primary.for_each([&](const KeyType&, const DataType& d) { stored.push_back(&d); });
+        index_->bulk_insert(stored);
+        auto& ref = *index_;
+        m_indexes.emplace_back(std::move(index_));
+        return ref;
+    }
+
+    /// Inserts or replaces the value of key_. Returns true when the key is new, like HashTbl::insert().
+    bool insert(const KeyType& key_, const DataType& data_) {
+        auto old = m_primary.find(key_);
+        if (old) {
+            for (auto& ix : m_indexes) ix->on_erase(old);
+            *old = data_;
+            for (auto& ix : m_indexes) ix->on_insert(old);
+            return false;
+        }
+        m_primary.insert(key_, data_);
+        auto added = m_primary.find(key_);
+        for (auto& ix : m_indexes) ix->on_insert(added);
+        return true;
+    }
+
+    /// Modifies the value of key_ in place with fn_(DataType&), re-indexing it. Returns false when the key is absent.
+    template <class Fn>
+    bool update(const KeyType& key_, Fn fn_) {
+        auto data = m_primary.find(key_);
+        if (!data) return false;
+        for (auto& ix : m_indexes) ix->on_erase(data);
+        fn_(*data);
+        for (auto& ix : m_indexes) ix->on_insert(data);
+        return true;
+    }
+
+    bool erase(const KeyType& key_) {
+        auto data = m_primary.find(key_);
+        if (!data) return false;
+        for (auto& ix : m_indexes) ix->on_erase(data);
+        return m_primary.erase(key_);
+    }
+
+    void clear() {
+        for (auto& ix : m_indexes) ix->clear();
+        m_primary.clear();
+    }
+
+    bool retrieve(const KeyType& key_, DataType& data_) const { return m_primary.retrieve(key_, data_); }
+    const DataType* find(const KeyType& key_) const { return m_primary.find(key_); }
+    size_type size() const { return m_primary.size(); }
+    bool empty() const { return m_primary.empty(); }
+    /// The primary table, for read-only use (scans, memory_usage()...).
+    const primary_type& primary() const { return m_primary; }
+
+   private:
+    primary_type m_primary;
+    std::vector<std::unique_ptr<IndexBase<DataType> > > m_indexes;
+};
+
+}  // namespace ac
+#endif
@@ -0,0 +1,165 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _LATENCY_HISTOGRAM_H_
+#define _LATENCY_HISTOGRAM_H_
+
+#include <algorithm>  // std::min
+#include <atomic>     // std::atomic
+#include <chrono>     // std::chrono::steady_clock
+#include <cstdint>    // std::uint64_t
+#include <iomanip>    // std::setw
+#include <iostream>   // std::ostream
+
+namespace ac  // Associative container
+{
+/**
+ * @brief Log-linear latency histogram in the style of HdrHistogram.
+ *
+ * Values below 2^SUB_BITS are counted exactly; above that every power of two is split into 2^(SUB_BITS-1) linear
+ * sub-buckets, so a reported percentile is never more than ~3% above the true value while the whole 64-bit range fits
+ * in a fixed array of counters.
+ *
+ * record() is lock-free (relaxed atomic increments) and may be called from any number of threads. For hot paths give
+ * every thread its own histogram and merge() them when reporting, so the counters do not bounce between cores.
+ */
+class LatencyHistogram {
+   public:
+    static const unsigned SUB_BITS = 6;                    //!< log2 of the exact range.
+    static const std::uint64_t HALF = 1ULL << (SUB_BITS - 1);  //!< Linear sub-buckets per power of two.
+    static const std::size_t N_BUCKETS = (64 - SUB_BITS + 2) * HALF;  //!< Counters needed for 64-bit values.
+
+    LatencyHistogram() { reset(); }
+    LatencyHistogram(const LatencyHistogram& other_) {
+        reset();
+        merge(other_);
+    }
+    LatencyHistogram& operator=(const LatencyHistogram& other_) {
+        if (this != &other_) {
+            reset();
+            merge(other_);
+        }
+        return *this;
+    }
+
+    /// Counts one value (typically nanoseconds).
+    void record(std::uint64_t value_) {
+        m_buckets[index_of(value_)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value_, std::memory_order_relaxed);
+        auto cur = m_max.load(std::memory_order_relaxed);
+        while (value_ > cur and !m_max.compare_exchange_weak(cur, value_, std::memory_order_relaxed)) {
+        }
+    }
+
+    /// Adds the counts of another histogram to this one.
+    void merge(const LatencyHistogram& other_) {
+        for (std::size_t i{0}; i < N_BUCKETS; i++) {
+            auto c = other_.m_buckets[i].load(std::memory_order_relaxed);
+            if (c) m_buckets[i].fetch_add(c, std::memory_order_relaxed);
+        }
+        m_count.fetch_add(other_.count(), std::memory_order_relaxed);
+        m_sum.fetch_add(other_.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        auto other_max = other_.max();
+        auto cur = m_max.load(std::memory_order_relaxed);
+        while (other_max > cur and !m_max.compare_exchange_weak(cur, other_max, std::memory_order_relaxed)) {
+        }
+    }
+
+    /// Forgets all recorded values.
+    void reset() {
+        for (auto& b : m_buckets) b.store(0, std::memory_order_relaxed);
+        m_count.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    std::uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    double mean() const { return count() ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / count() : 0; }
+
+    /**
+     * @brief Returns the value below which a fraction q_ of the recorded values fall.
+     *
+     * @param q_ Quantile in [0, 1], e.g. 0.99 for p99.
+     * @return Upper bound of the bucket holding that rank (never above max()), or 0 if the histogram is empty.
+     */
+    std::uint64_t percentile(double q_) const {
+        auto total = count();
+        if (total == 0) return 0;
+        auto rank = static_cast<std::uint64_t>(q_ * total + 0.5);
+        rank = std::min(total, std::max<std::uint64_t>(1, rank));
+        std::uint64_t seen{0};
+        for (std::size_t i{0}; i < N_BUCKETS; i++) {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(highest_of(i), max());
+        }
+        return max();
+    }
+
+    /// Prints count, mean and the usual percentiles on one line.
+    friend std::ostream& operator<<(std::ostream& os_, const LatencyHistogram& h_) {
+        return os_ << "n=" << h_.count() << " mean=" << static_cast<std::uint64_t>(h_.mean())
+                   << " p50=" << h_.percentile(0.5) << " p99=" << h_.percentile(0.99)
+                   << " p99.9=" << h_.percentile(0.999) << " max=" << h_.max();
+    }
+
+   private:
+    std::atomic<std::uint64_t> m_buckets[N_BUCKETS];  //!< Counters, see index_of().
+    std::atomic<std::uint64_t> m_count;                //!< Number of recorded values.
+    std::atomic<std::uint64_t> m_sum;                  //!< Sum of recorded values, for the mean.
+    std::atomic<std::uint64_t> m_max;                  //!< Largest recorded value.
+
+    static unsigned msb(std::uint64_t v_) {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(v_);
+#else
+        unsigned r{0};
+        while (v_ >>= 1) r++;
+        return r;
+#endif
+    }
+
+    /// Exact index below 2^SUB_BITS; above it, (octave, top SUB_BITS bits of the value).
+    static std::size_t index_of(std::uint64_t v_) {
+        if (v_ < (1ULL << SUB_BITS)) return static_cast<std::size_t>(v_);
+        unsigned shift = msb(v_) - (SUB_BITS - 1);
+        return static_cast<std::size_t>(shift * HALF + (v_ >> shift));
+    }
+
+    /// Largest value that maps to bucket i_.
+    static std::uint64_t highest_of(std::size_t i_) {
+        if (i_ < (1ULL << SUB_BITS)) return i_;
+        std::uint64_t shift = i_ / HALF - 1;
+        std::uint64_t top = i_ - shift * HALF;
+        return ((top + 1) << shift) - 1;
+    }
+};
+
+/// Records the lifetime of the object, in nanoseconds, into a histogram.
+class ScopedLatency {
+   public:
+    explicit ScopedLatency(LatencyHistogram& hist_) : m_hist(hist_), m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedLatency() {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+        m_hist.record(static_cast<std::uint64_t>(ns.count()));
+    }
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+   private:
+    LatencyHistogram& m_hist;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * @brief Calls fn_ and records how long it took. Wraps any table operation without changing its result:
+ * `bool ok = ac::timed(hist, [&] { return table.insert(k, v); });`
+ */
+template <class Fn>
+auto timed(LatencyHistogram& hist_, Fn&& fn_) -> decltype(fn_()) {
+    ScopedLatency guard(hist_);
+    return fn_();
+}
+
+}  // namespace ac
+#endif
@@ -0,0 +1,92 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _MEMORY_USAGE_H_
+#define _MEMORY_USAGE_H_
+
+#include <cstddef>      // std::size_t
+#include <ostream>      // std::ostream
+#include <string>       // std::string
+#include <tuple>        // std::tuple
+#include <type_traits>  // std::enable_if
+#include <utility>      // std::pair
+#include <vector>       // std::vector
+
+namespace ac  // Associative container
+{
+/// Footprint of a container, as reported by HashTbl::memory_usage().
+struct MemoryUsage {
+    std::size_t bucket_bytes{0};      //!< The bucket array.
+    std::size_t node_bytes{0};        //!< The collision list nodes (link + key + data).
+    std::size_t owned_heap_bytes{0};  //!< Heap blocks owned by keys and data, reported by heap_bytes().
+
+    std::size_t total() const { return bucket_bytes + node_bytes + owned_heap_bytes; }
+
+    friend std::ostream& operator<<(std::ostream& os_, const MemoryUsage& mu_) {
+        return os_ << "buckets=" << mu_.bucket_bytes << " nodes=" << mu_.node_bytes
+                   << " owned_heap=" << mu_.owned_heap_bytes << " total=" << mu_.total();
+    }
+};
+
+/**
+ * @brief Customization point: heap bytes owned by a value, beyond sizeof(value). The table calls it unqualified after
+ * `using ac::heap_bytes;`, so a type provides its own by declaring `std::size_t heap_bytes(const T&)` in its namespace
+ * (see Account). Types without an overload own nothing.
+ */
+template <class T>
+inline std::size_t heap_bytes(const T&) {
+    return 0;
+}
+
+// Declared before any is defined, so that each finds the others for nested types: name lookup inside a template only
+// sees what is declared before it, and ADL on std types searches std, not ac.
+inline std::size_t heap_bytes(const std::string& s_);
+template <class T, class A>
+inline std::size_t heap_bytes(const std::vector<T, A>& v_);
+template <class T1, class T2>
+inline std::size_t heap_bytes(const std::pair<T1, T2>& p_);
+template <class... Ts>
+inline std::size_t heap_bytes(const std::tuple<Ts...>& t_);
+namespace detail {
+template <std::size_t I, class... Ts>
+inline typename std::enable_if<I == sizeof...(Ts), std::size_t>::type tuple_heap_bytes(const std::tuple<Ts...>&);
+template <std::size_t I, class... Ts>
+inline typename std::enable_if<(I < sizeof...(Ts)), std::size_t>::type tuple_heap_bytes(const std::tuple<Ts...>& t_);
+}  // namespace detail
+
+/// Strings own their buffer once they outgrow the small-string storage.
+inline std::size_t heap_bytes(const std::string& s_) {
+    static const std::size_t inline_capacity = std::string().capacity();
+    return s_.capacity() > inline_capacity ? s_.capacity() + 1 : 0;
+}
+
+template <class T, class A>
+inline std::size_t heap_bytes(const std::vector<T, A>& v_) {
+    std::size_t bytes = v_.capacity() * sizeof(T);
+    for (const auto& e : v_) bytes += heap_bytes(e);
+    return bytes;
+}
+
+template <class T1, class T2>
+inline std::size_t heap_bytes(const std::pair<T1, T2>& p_) {
+    return heap_bytes(p_.first) + heap_bytes(p_.second);
+}
+
+namespace detail {
+template <std::size_t I, class... Ts>
+inline typename std::enable_if<I == sizeof...(Ts), std::size_t>::type tuple_heap_bytes(const std::tuple<Ts...>&) {
+    return 0;
+}
+template <std::size_t I, class... Ts>
+inline typename std::enable_if<(I < sizeof...(Ts)), std::size_t>::type tuple_heap_bytes(const std::tuple<Ts...>& t_) {
+    return heap_bytes(std::get<I>(t_)) + tuple_heap_bytes<I + 1>(t_);
+}
+}  // namespace detail
+
+/// Tuples (such as Account::AcctKey) own what their elements own.
+template <class... Ts>
+inline std::size_t heap_bytes(const std::tuple<Ts...>& t_) {
+    return detail::tuple_heap_bytes<0>(t_);
+}
+
+}  // namespace ac
+#endif
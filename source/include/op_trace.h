@@ -0,0 +1,170 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _OP_TRACE_H_
+#define _OP_TRACE_H_
+
+#include <algorithm>  // std::max
+#include <chrono>     // std::chrono::steady_clock
+#include <cstdint>    // std::uint64_t
+#include <istream>    // std::istream
+#include <ostream>    // std::ostream
+#include <stdexcept>  // std::runtime_error
+#include <string>     // std::char_traits
+
+#include "hashtbl.h"
+
+namespace ac  // Associative container
+{
+/// Operations stored in a trace.
+enum class TraceOp : std::uint8_t { insert = 0, retrieve, erase, update };
+
+/// One traced operation. Keys are replaced by dense ids (0, 1, 2... in order of first appearance).
+struct TraceRecord {
+    TraceOp op;            //!< What was done.
+    std::uint64_t key_id;  //!< Which key it was done to.
+    std::uint64_t ts_ns;   //!< When, in ns since the start of the recording.
+};
+
+/**
+ * @brief Writes a binary operation trace.
+ *
+ * Layout: the 4-byte magic "HTTR", one version byte, then one record per operation: an op byte followed by the key id
+ * and the time since the previous record (ns), both as LEB128 varints. A typical record takes 4 to 7 bytes.
+ */
+class TraceWriter {
+   public:
+    static const std::uint8_t VERSION = 1;
+
+    explicit TraceWriter(std::ostream& os_) : m_os(os_), m_last_ts(0), m_count(0) {
+        m_os.write("HTTR", 4);
+        m_os.put(static_cast<char>(VERSION));
+    }
+
+    void write(const TraceRecord& rec_) {
+        m_os.put(static_cast<char>(rec_.op));
+        put_varint(rec_.key_id);
+        put_varint(rec_.ts_ns >= m_last_ts ? rec_.ts_ns - m_last_ts : 0);
+        m_last_ts = std::max(m_last_ts, rec_.ts_ns);
+        m_count++;
+    }
+
+    void flush() { m_os.flush(); }
+    /// Number of records written so far.
+    std::uint64_t count() const { return m_count; }
+
+   private:
+    std::ostream& m_os;
+    std::uint64_t m_last_ts;  //!< Timestamps are stored as deltas.
+    std::uint64_t m_count;    //!< Records written.
+
+    void put_varint(std::uint64_t v_) {
+        while (v_ >= 0x80) {
+            m_os.put(static_cast<char>((v_ & 0x7f) | 0x80));
+            v_ >>= 7;
+        }
+        m_os.put(static_cast<char>(v_));
+    }
+};
+
+/// Reads a trace written by TraceWriter. Throws std::runtime_error on a bad header or a truncated record.
+class TraceReader {
+   public:
+    explicit TraceReader(std::istream& is_) : m_is(is_), m_ts(0) {
+        char magic[4];
+        if (!m_is.read(magic, 4) or magic[0] != 'H' or magic[1] != 'T' or magic[2] != 'T' or magic[3] != 'R')
+            throw std::runtime_error("not an operation trace (bad magic)");
+        if (m_is.get() != TraceWriter::VERSION) throw std::runtime_error("unsupported trace version");
+    }
+
+    /// Reads the next record into rec_. Returns false at the end of the trace.
+    bool next(TraceRecord& rec_) {
+        int op = m_is.get();
+        if (op == std::char_traits<char>::eof()) return false;
+        if (op > static_cast<int>(TraceOp::update)) throw std::runtime_error("corrupted trace (bad operation)");
+        rec_.op = static_cast<TraceOp>(op);
+        rec_.key_id = get_varint();
+        m_ts += get_varint();
+        rec_.ts_ns = m_ts;
+        return true;
+    }
+
+   private:
+    std::istream& m_is;
+    std::uint64_t m_ts;  //!< Running timestamp.
+
+    std::uint64_t get_varint() {
+        std::uint64_t v{0};
+        for (unsigned shift{0}; shift < 64; shift += 7) {
+            int byte = m_is.get();
+            if (byte == std::char_traits<char>::eof()) throw std::runtime_error("truncated trace");
+            v |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return v;
+        }
+        throw std::runtime_error("corrupted trace (varint too long)");
+    }
+};
+
+/**
+ * @brief Wraps a HashTbl and records every operation made through it into a trace, then forwards the call.
+ *
+ * insert(), retrieve() and erase() are recorded as such; find(), at() and operator[], which hand out the data for
+ * the caller to modify in place, are recorded as updates. Keys are interned into dense ids, so the trace holds no key data.
+ * Like HashTbl, the wrapper is not thread-safe: calls from several threads must be serialized by the caller.
+ */
+template <class Table>
+class RecordingHashTbl {
+   public:
+    using key_type = typename Table::key_type;
+    using mapped_type = typename Table::mapped_type;
+
+    RecordingHashTbl(Table& table_, TraceWriter& writer_)
+        : m_table(table_), m_writer(writer_), m_start(std::chrono::steady_clock::now()) {}
+
+    bool insert(const key_type& key_, const mapped_type& data_) {
+        record(TraceOp::insert, key_);
+        return m_table.insert(key_, data_);
+    }
+    bool retrieve(const key_type& key_, mapped_type& data_) {
+        record(TraceOp::retrieve, key_);
+        return m_table.retrieve(key_, data_);
+    }
+    bool erase(const key_type& key_) {
+        record(TraceOp::erase, key_);
+        return m_table.erase(key_);
+    }
+    mapped_type* find(const key_type& key_) {
+        record(TraceOp::update, key_);
+        return m_table.find(key_);
+    }
+    mapped_type& at(const key_type& key_) {
+        record(TraceOp::update, key_);
+        return m_table.at(key_);
+    }
+    mapped_type& operator[](const key_type& key_) {
+        record(TraceOp::update, key_);
+        return m_table[key_];
+    }
+
+    /// Number of distinct keys seen so far (the next key id).
+    std::uint64_t distinct_keys() const { return m_ids.size(); }
+    Table& table() { return m_table; }
+
+   private:
+    Table& m_table;
+    TraceWriter& m_writer;
+    std::chrono::steady_clock::time_point m_start;
+    HashTbl<key_type, std::uint64_t, typename Table::hasher, typename Table::key_equal> m_ids;  //!< Key interning.
+
+    void record(TraceOp op_, const key_type& key_) {
+        std::uint64_t id;
+        if (!m_ids.retrieve(key_, id)) {
+            id = m_ids.size();
+            m_ids.insert(key_, id);
+        }
+        auto ts = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+        m_writer.write(TraceRecord{op_, id, static_cast<std::uint64_t>(ts.count())});
+    }
+};
+
+}  // namespace ac
+#endif
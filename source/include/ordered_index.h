@@ -0,0 +1,197 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _ORDERED_INDEX_H_
+#define _ORDERED_INDEX_H_
+
+#include <algorithm>   // std::lower_bound, std::upper_bound, std::merge, std::sort, std::remove_if
+#include <cmath>       // std::sqrt
+#include <cstddef>     // std::size_t
+#include <functional>  // std::less
+#include <iterator>    // std::forward_iterator_tag, std::back_inserter, std::make_move_iterator
+#include <utility>     // std::move
+#include <vector>      // std::vector
+
+#include "indexed_hashtbl.h"
+
+namespace ac  // Associative container
+{
+/**
+ * @brief Ordered secondary index of IndexedHashTbl: keeps the values sorted by a projection and answers range
+ * queries, such as the accounts of a branch whose numbers fall in an interval.
+ *
+ * The entries (projected key and pointer) live in a sorted array scanned sequentially, so a range costs one binary
+ * search plus a streaming read; a B+-tree would add pointer chasing between its leaves for no gain on scans. Changes
+ * are cheap too:
+ *  - new entries go into a small sorted delta array, merged into the base array once it grows past about sqrt(n);
+ *  - removed entries of the base array become tombstones (null pointer), dropped at the next merge.
+ * Queries merge the two arrays on the fly, so they always see the current contents.
+ */
+template <class DataType, class Proj, class Compare = std::less<projected_t<DataType, Proj> > >
+class OrderedIndex : public IndexBase<DataType> {
+   public:
+    using key_type = projected_t<DataType, Proj>;
+
+   private:
+    struct Item {
+        key_type key;
+        const DataType* data;  //!< Null for a tombstone.
+    };
+
+   public:
+    /// Iterates the values of a range in key order. Dereferences to `const DataType*`.
+    class const_iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = const DataType*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        const_iterator(const Item* b_, const Item* b_end_, const Item* d_, const Item* d_end_, const Compare* cmp_)
+            : m_b(b_), m_b_end(b_end_), m_d(d_), m_d_end(d_end_), m_cmp(cmp_) {
+            skip_tombstones();
+        }
+        reference operator*() const { return current()->data; }
+        /// Projected key of the current value.
+        const key_type& key() const { return current()->key; }
+        const_iterator& operator++() {
+            if (m_b != m_b_end and (m_d == m_d_end or !(*m_cmp)(m_d->key, m_b->key)))
+                ++m_b;
+            else
+                ++m_d;
+            skip_tombstones();
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+        bool operator==(const const_iterator& o_) const { return m_b == o_.m_b and m_d == o_.m_d; }
+        bool operator!=(const const_iterator& o_) const { return !(*this == o_); }
+
+       private:
+        const Item *m_b, *m_b_end;  //!< Position in the base array.
+        const Item *m_d, *m_d_end;  //!< Position in the delta array.
+        const Compare* m_cmp;
+
+        void skip_tombstones() {
+            while (m_b != m_b_end and !m_b->data) ++m_b;
+        }
+        const Item* current() const {
+            if (m_b == m_b_end) return m_d;
+            if (m_d == m_d_end) return m_b;
+            return (*m_cmp)(m_d->key, m_b->key) ? m_d : m_b;
+        }
+    };
+
+    /// Values with lo <= key <= hi, as returned by range().
+    class Range {
+       public:
+        Range(const_iterator first_, const_iterator last_) : m_first(first_), m_last(last_) {}
+        const_iterator begin() const { return m_first; }
+        const_iterator end() const { return m_last; }
+        bool empty() const { return m_first == m_last; }
+
+       private:
+        const_iterator m_first, m_last;
+    };
+
+    explicit OrderedIndex(Proj proj_, Compare cmp_ = Compare()) : m_proj(std::move(proj_)), m_cmp(std::move(cmp_)) {}
+
+    /// The values whose projected key lies in the closed interval [lo_, hi_], in key order.
+    Range range(const key_type& lo_, const key_type& hi_) const {
+        auto by_key = [this](const Item& i_, const key_type& k_) { return m_cmp(i_.key, k_); };
+        auto key_by = [this](const key_type& k_, const Item& i_) { return m_cmp(k_, i_.key); };
+        const Item* b = m_base.data();
+        const Item* d = m_delta.data();
+        auto b_first = std::lower_bound(b, b + m_base.size(), lo_, by_key);
+        auto b_last = std::upper_bound(b_first, b + m_base.size(), hi_, key_by);
+        auto d_first = std::lower_bound(d, d + m_delta.size(), lo_, by_key);
+        auto d_last = std::upper_bound(d_first, d + m_delta.size(), hi_, key_by);
+        return Range(const_iterator(b_first, b_last, d_first, d_last, &m_cmp),
+                     const_iterator(b_last, b_last, d_last, d_last, &m_cmp));
+    }
+    /// Every value, in key order.
+    Range all() const {
+        const Item* b = m_base.data();
+        const Item* d = m_delta.data();
+        auto b_end = b + m_base.size();
+        auto d_end = d + m_delta.size();
+        return Range(const_iterator(b, b_end, d, d_end, &m_cmp), const_iterator(b_end, b_end, d_end, d_end, &m_cmp));
+    }
+    /// Number of values indexed.
+    std::size_t size() const { return m_base.size() - m_tombstones + m_delta.size(); }
+
+    void on_insert(const DataType* data_) override {
+        Item item{m_proj(*data_), data_};
+        m_delta.insert(std::upper_bound(m_delta.begin(), m_delta.end(), item, item_less()), std::move(item));
+        if (m_delta.size() > delta_limit()) merge();
+    }
+    void on_erase(const DataType* data_) override {
+        auto key = m_proj(*data_);
+        for (auto it = lower(m_delta, key); it != m_delta.end() and !m_cmp(key, it->key); ++it) {
+            if (it->data == data_) {
+                m_delta.erase(it);
+                return;
+            }
+        }
+        for (auto it = lower(m_base, key); it != m_base.end() and !m_cmp(key, it->key); ++it) {
+            if (it->data == data_) {
+                it->data = nullptr;
+                // Too many holes slow the scans down; squeeze them out.
+                if (++m_tombstones > m_base.size() / 4) merge();
+                return;
+            }
+        }
+    }
+    void bulk_insert(const std::vector<const DataType*>& data_) override {
+        for (auto d : data_) m_delta.push_back(Item{m_proj(*d), d});
+        std::sort(m_delta.begin(), m_delta.end(), item_less());
+        merge();
+    }
+    void clear() override {
+        m_base.clear();
+        m_delta.clear();
+        m_tombstones = 0;
+    }
+
+   private:
+    Proj m_proj;
+    Compare m_cmp;
+    std::vector<Item> m_base;     //!< Sorted; may hold tombstones.
+    std::vector<Item> m_delta;    //!< Sorted; recent insertions.
+    std::size_t m_tombstones{0};  //!< Tombstones in m_base.
+
+    /// Orders items by key only: equal keys keep their insertion order, as in a std::multimap.
+    struct ItemLess {
+        const Compare* cmp;
+        bool operator()(const Item& a_, const Item& b_) const { return (*cmp)(a_.key, b_.key); }
+    };
+    ItemLess item_less() const { return ItemLess{&m_cmp}; }
+
+    typename std::vector<Item>::iterator lower(std::vector<Item>& v_, const key_type& key_) {
+        return std::lower_bound(v_.begin(), v_.end(), key_,
+                                [this](const Item& i_, const key_type& k_) { return m_cmp(i_.key, k_); });
+    }
+    std::size_t delta_limit() const {
+        return std::max<std::size_t>(256, static_cast<std::size_t>(std::sqrt(static_cast<double>(m_base.size()))));
+    }
+    /// Folds the delta into the base array and drops the tombstones.
+    void merge() {
+        if (m_tombstones)
+            m_base.erase(std::remove_if(m_base.begin(), m_base.end(), [](const Item& i_) { return !i_.data; }),
+                         m_base.end());
+        std::vector<Item> merged;
+        merged.reserve(m_base.size() + m_delta.size());
+        std::merge(std::make_move_iterator(m_base.begin()), std::make_move_iterator(m_base.end()),
+                   std::make_move_iterator(m_delta.begin()), std::make_move_iterator(m_delta.end()),
+                   std::back_inserter(merged), item_less());
+        m_base.swap(merged);
+        m_delta.clear();
+        m_tombstones = 0;
+    }
+};
+
+}  // namespace ac
+#endif
@@ -0,0 +1,243 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _PREFIX_INDEX_H_
+#define _PREFIX_INDEX_H_
+
+#include <algorithm>  // std::lower_bound, std::min
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uint32_t
+#include <limits>     // std::numeric_limits
+#include <string>     // std::string
+#include <utility>    // std::move, std::swap
+#include <vector>     // std::vector
+
+#include "indexed_hashtbl.h"
+
+namespace ac  // Associative container
+{
+/**
+ * @brief Prefix secondary index of IndexedHashTbl: finds the values whose projected string (a client name, say)
+ * starts with a given prefix, without comparing against every value of the table.
+ *
+ * The strings are kept in a compressed trie (radix tree): each node owns an edge label of one or more characters, so a
+ * chain of single-child nodes collapses into one, and the tree has at most two nodes per distinct string. The nodes
+ * live in one array and refer to each other by 32-bit index; every node also counts the values below it, so
+ * count_prefix() stops where the prefix ends instead of walking the subtree. Values are enumerated in the order of
+ * their strings, and enumerations take a limit, as a lookup screen only shows the first few matches.
+ */
+template <class DataType, class Proj>
+class PrefixIndex : public IndexBase<DataType> {
+   public:
+    using size_type = std::size_t;
+    static constexpr size_type npos = std::numeric_limits<size_type>::max();
+
+    explicit PrefixIndex(Proj proj_) : m_proj(std::move(proj_)), m_nodes(1) {}
+
+    /// Number of values whose string starts with prefix_.
+    size_type count_prefix(const std::string& prefix_) const {
+        auto n = locate(prefix_);
+        return n == none ? 0 : m_nodes[n].count;
+    }
+
+    /**
+     * @brief Calls fn_(const DataType*) for the values whose string starts with prefix_, in string order (values
+     * sharing a string in insertion order), stopping after limit_ of them.
+     * @return The number of values visited.
+     */
+    template <class Fn>
+    size_type for_each_prefix(const std::string& prefix_, Fn fn_, size_type limit_ = npos) const {
+        auto top = locate(prefix_);
+        if (top == none or limit_ == 0) return 0;
+        size_type visited{0};
+        // Depth-first, children pushed in reverse so the smallest is popped first.
+        std::vector<index_type> stack{top};
+        while (!stack.empty()) {
+            const auto& node = m_nodes[stack.back()];
+            stack.pop_back();
+            for (auto d : node.values) {
+                fn_(d);
+                if (++visited == limit_) return visited;
+            }
+            for (auto c = node.children.rbegin(); c != node.children.rend(); ++c) stack.push_back(*c);
+        }
+        return visited;
+    }
+
+    /// Up to limit_ values whose string starts with prefix_, in string order.
+    std::vector<const DataType*> find_prefix(const std::string& prefix_, size_type limit_ = npos) const {
+        std::vector<const DataType*> found;
+        for_each_prefix(prefix_, [&](const DataType* d) { found.push_back(d); }, limit_);
+        return found;
+    }
+
+    /// Number of values indexed.
+    size_type size() const { return m_nodes[root].count; }
+    /// Number of trie nodes in use, for memory accounting.
+    size_type nodes() const { return m_nodes.size() - m_free.size(); }
+
+    void on_insert(const DataType* data_) override {
+        std::string key = m_proj(*data_);
+        index_type n{root};
+        size_type pos{0};
+        m_nodes[n].count++;
+        while (pos < key.size()) {
+            auto slot = child_slot(n, key[pos]);
+            if (slot == m_nodes[n].children.size() or first_char(m_nodes[n].children[slot]) != key[pos]) {
+                auto leaf = make_node(key.substr(pos));
+                m_nodes[leaf].values.push_back(data_);
+                m_nodes[leaf].count = 1;
+                m_nodes[n].children.insert(m_nodes[n].children.begin() + slot, leaf);
+                return;
+            }
+            auto c = m_nodes[n].children[slot];
+            auto common = common_length(m_nodes[c].label, key, pos);
+            if (common < m_nodes[c].label.size()) {
+                // The key leaves the edge halfway: split it, the upper part becoming a new node.
+                auto mid = make_node(m_nodes[c].label.substr(0, common));
+                m_nodes[c].label.erase(0, common);
+                m_nodes[mid].children.push_back(c);
+                m_nodes[mid].count = m_nodes[c].count;
+                m_nodes[n].children[slot] = mid;
+                c = mid;
+            }
+            n = c;
+            pos += common;
+            m_nodes[n].count++;
+        }
+        m_nodes[n].values.push_back(data_);
+    }
+
+    void on_erase(const DataType* data_) override {
+        std::string key = m_proj(*data_);
+        // Path of (node, slot in its parent) from the root down to the node of the key.
+        std::vector<std::pair<index_type, size_type> > path{{root, 0}};
+        size_type pos{0};
+        while (pos < key.size()) {
+            auto n = path.back().first;
+            auto slot = child_slot(n, key[pos]);
+            if (slot == m_nodes[n].children.size()) return;
+            auto c = m_nodes[n].children[slot];
+            const auto& label = m_nodes[c].label;
+            if (label[0] != key[pos] or key.compare(pos, label.size(), label) != 0) return;
+            path.emplace_back(c, slot);
+            pos += label.size();
+        }
+        auto& values = m_nodes[path.back().first].values;
+        // Values sharing a string are few (a handful of homonyms), so a linear search is enough.
+        auto it = std::find(values.begin(), values.end(), data_);
+        if (it == values.end()) return;
+        values.erase(it);
+        for (auto& p : path) m_nodes[p.first].count--;
+        prune(path);
+    }
+
+    void clear() override {
+        m_nodes.assign(1, Node());
+        m_free.clear();
+    }
+
+   private:
+    using index_type = std::uint32_t;
+    static constexpr index_type root = 0;
+    static constexpr index_type none = std::numeric_limits<index_type>::max();
+
+    struct Node {
+        std::string label;                    //!< Characters of the edge from the parent; empty for the root.
+        std::vector<index_type> children;     //!< Sorted by the first character of their labels.
+        std::vector<const DataType*> values;  //!< Values whose string ends at this node.
+        size_type count{0};                   //!< Values in this subtree.
+    };
+
+    Proj m_proj;                     //!< Value -> indexed string.
+    std::vector<Node> m_nodes;       //!< m_nodes[0] is the root.
+    std::vector<index_type> m_free;  //!< Unused slots of m_nodes.
+
+    /// Characters compare as unsigned, like std::string does, so the trie order is the string order.
+    static bool char_less(char a_, char b_) {
+        return static_cast<unsigned char>(a_) < static_cast<unsigned char>(b_);
+    }
+    char first_char(index_type n_) const { return m_nodes[n_].label[0]; }
+
+    /// Position in n_'s children of the child starting with c_, or where it would be inserted.
+    size_type child_slot(index_type n_, char c_) const {
+        const auto& ch = m_nodes[n_].children;
+        auto it = std::lower_bound(ch.begin(), ch.end(), c_,
+                                   [this](index_type i_, char k_) { return char_less(first_char(i_), k_); });
+        return static_cast<size_type>(it - ch.begin());
+    }
+
+    /// Length of the common prefix of label_ and key_.substr(pos_).
+    static size_type common_length(const std::string& label_, const std::string& key_, size_type pos_) {
+        size_type n = std::min(label_.size(), key_.size() - pos_), i{0};
+        while (i < n and label_[i] == key_[pos_ + i]) i++;
+        return i;
+    }
+
+    index_type make_node(std::string label_) {
+        index_type n;
+        if (!m_free.empty()) {
+            n = m_free.back();
+            m_free.pop_back();
+        } else {
+            n = static_cast<index_type>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+        m_nodes[n].label = std::move(label_);
+        return n;
+    }
+    void free_node(index_type n_) {
+        m_nodes[n_] = Node();
+        m_free.push_back(n_);
+    }
+
+    /// Node of the subtree holding every string that starts with prefix_, or none.
+    index_type locate(const std::string& prefix_) const {
+        index_type n{root};
+        size_type pos{0};
+        while (pos < prefix_.size()) {
+            auto slot = child_slot(n, prefix_[pos]);
+            if (slot == m_nodes[n].children.size()) return none;
+            auto c = m_nodes[n].children[slot];
+            const auto& label = m_nodes[c].label;
+            auto len = std::min(label.size(), prefix_.size() - pos);
+            if (prefix_.compare(pos, len, label, 0, len) != 0) return none;
+            n = c;
+            pos += len;
+        }
+        return n;
+    }
+
+    /// Restores the trie shape after a removal at the end of path_: drops the node if it became useless, then merges
+    /// a node left with no values and a single child into that child.
+    void prune(const std::vector<std::pair<index_type, size_type> >& path_) {
+        auto depth = path_.size() - 1;
+        auto n = path_[depth].first;
+        if (depth == 0) return;
+        if (m_nodes[n].values.empty() and m_nodes[n].children.empty()) {
+            auto parent = path_[depth - 1].first;
+            auto& ch = m_nodes[parent].children;
+            ch.erase(ch.begin() + path_[depth].second);
+            free_node(n);
+            n = parent;
+            if (--depth == 0) return;
+        }
+        if (m_nodes[n].values.empty() and m_nodes[n].children.size() == 1) {
+            // n keeps its place in the parent; it takes over the child's label tail, values and children.
+            auto c = m_nodes[n].children[0];
+            m_nodes[n].label += m_nodes[c].label;
+            std::swap(m_nodes[n].values, m_nodes[c].values);
+            std::swap(m_nodes[n].children, m_nodes[c].children);
+            free_node(c);
+        }
+    }
+};
+
+template <class DataType, class Proj>
+constexpr typename PrefixIndex<DataType, Proj>::size_type PrefixIndex<DataType, Proj>::npos;
+template <class DataType, class Proj>
+constexpr typename PrefixIndex<DataType, Proj>::index_type PrefixIndex<DataType, Proj>::root;
+template <class DataType, class Proj>
+constexpr typename PrefixIndex<DataType, Proj>::index_type PrefixIndex<DataType, Proj>::none;
+
+}  // namespace ac
+#endif
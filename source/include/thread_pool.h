@@ -0,0 +1,193 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <algorithm>           // std::min
+#include <condition_variable>  // std::condition_variable
+#include <cstddef>             // std::size_t
+#include <deque>               // std::deque
+#include <exception>           // std::exception_ptr
+#include <functional>          // std::function
+#include <memory>              // std::unique_ptr
+#include <mutex>               // std::mutex
+#include <thread>              // std::thread
+#include <utility>             // std::pair
+#include <vector>              // std::vector
+
+namespace ac  // Associative container
+{
+/**
+ * @brief Fixed set of worker threads running index-range loops with work stealing.
+ *
+ * parallel_for() cuts [begin, end) into chunks and deals them to per-worker queues. Each worker takes chunks from the
+ * front of its own queue and, once it runs dry, steals from the back of the others', so a few expensive chunks (long
+ * collision lists, say) do not leave the other workers idle. The calling thread works as worker 0.
+ *
+ * One loop runs at a time: concurrent calls are serialized, and calling parallel_for() from inside a loop body of the
+ * same pool runs the inner loop serially on the calling worker instead of deadlocking. A loop body may run a loop on
+ * another pool, whose workers then number the chunks (as long as the two pools never wait on each other both ways).
+ */
+class ThreadPool {
+   public:
+    /// Body of a loop: processes [lo, hi) as worker `worker` (0 <= worker < size()).
+    using RangeFn = std::function<void(std::size_t lo, std::size_t hi, unsigned worker)>;
+
+    /// Starts n_threads - 1 workers (the caller is the last one); 0 means one per hardware thread.
+    explicit ThreadPool(unsigned n_threads_ = 0) {
+        if (n_threads_ == 0) n_threads_ = std::max(1u, std::thread::hardware_concurrency());
+        m_queues.resize(n_threads_);
+        for (auto& q : m_queues) q.reset(new Queue);
+        for (unsigned w{1}; w < n_threads_; w++) m_workers.emplace_back(&ThreadPool::worker_loop, this, w);
+    }
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_quit = true;
+        }
+        m_wake.notify_all();
+        for (auto& t : m_workers) t.join();
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Number of workers, the calling thread included.
+    unsigned size() const { return static_cast<unsigned>(m_queues.size()); }
+
+    /// Process-wide pool with one worker per hardware thread, created on first use.
+    static ThreadPool& shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    /**
+     * @brief Runs fn_ over [begin_, end_) in chunks of about grain_ indices (0 picks one that gives every worker
+     * several chunks to steal from). Returns when every chunk is done. If a chunk throws, the remaining chunks are
+     * skipped and the first exception is rethrown here.
+     */
+    void parallel_for(std::size_t begin_, std::size_t end_, std::size_t grain_, const RangeFn& fn_) {
+        if (begin_ >= end_) return;
+        if (owner() == this or size() == 1) {
+            fn_(begin_, end_, owner() == this ? current_worker() : 0);
+            return;
+        }
+        std::lock_guard<std::mutex> one_loop(m_submit);
+        std::size_t n = end_ - begin_;
+        if (grain_ == 0) grain_ = std::max<std::size_t>(1, n / (size() * 16));
+        std::size_t n_chunks = (n + grain_ - 1) / grain_;
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_fn = &fn_;
+            m_pending = n_chunks;
+            m_error = nullptr;
+        }
+        // Deal contiguous runs of chunks, so without stealing every worker walks a contiguous part of the range.
+        for (unsigned w{0}; w < size(); w++) {
+            std::size_t first = n_chunks * w / size(), last = n_chunks * (w + 1) / size();
+            std::lock_guard<std::mutex> guard(m_queues[w]->lock);
+            for (std::size_t c{first}; c < last; c++)
+                m_queues[w]->chunks.emplace_back(begin_ + c * grain_, std::min(end_, begin_ + (c + 1) * grain_));
+        }
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        run_chunks(0);
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_done.wait(lock, [this] { return m_pending == 0; });
+        m_fn = nullptr;
+        if (m_error) std::rethrow_exception(m_error);
+    }
+
+   private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<std::pair<std::size_t, std::size_t> > chunks;
+    };
+
+    std::vector<std::unique_ptr<Queue> > m_queues;  //!< One per worker; chunks are stolen from the back.
+    std::vector<std::thread> m_workers;
+    std::mutex m_submit;  //!< Serializes parallel_for() calls.
+    std::mutex m_lock;    //!< Guards the fields below.
+    std::condition_variable m_wake, m_done;
+    const RangeFn* m_fn{nullptr};  //!< Body of the running loop.
+    std::size_t m_pending{0};      //!< Chunks not finished yet.
+    std::size_t m_generation{0};   //!< Bumped for every loop, wakes the workers.
+    std::exception_ptr m_error;    //!< First exception thrown by a chunk.
+    bool m_quit{false};
+
+    /// Pool whose chunk the current thread is running (null outside any), and as which worker of that pool.
+    static const ThreadPool*& owner() {
+        static thread_local const ThreadPool* pool{nullptr};
+        return pool;
+    }
+    static unsigned& current_worker() {
+        static thread_local unsigned id{0};
+        return id;
+    }
+
+    void worker_loop(unsigned w_) {
+        std::size_t seen{0};
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_wake.wait(lock, [&] { return m_quit or m_generation != seen; });
+                if (m_quit) return;
+                seen = m_generation;
+            }
+            run_chunks(w_);
+        }
+    }
+
+    /// Takes a chunk from our own queue, or steals one from the others'. Returns false when all are empty.
+    bool take(unsigned w_, std::pair<std::size_t, std::size_t>& chunk_) {
+        for (unsigned i{0}; i < size(); i++) {
+            auto& q = *m_queues[(w_ + i) % size()];
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (q.chunks.empty()) continue;
+            if (i == 0) {
+                chunk_ = q.chunks.front();
+                q.chunks.pop_front();
+            } else {
+                chunk_ = q.chunks.back();
+                q.chunks.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void run_chunks(unsigned w_) {
+        std::pair<std::size_t, std::size_t> chunk;
+        while (take(w_, chunk)) {
+            const RangeFn* fn;
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                fn = m_error ? nullptr : m_fn;
+            }
+            if (fn) {
+                // A worker of another pool may be running this loop from inside one of its chunks: restore its
+                // identity afterwards.
+                auto outer_pool = owner();
+                auto outer_worker = current_worker();
+                owner() = this;
+                current_worker() = w_;
+                try {
+                    (*fn)(chunk.first, chunk.second, w_);
+                } catch (...) {
+                    std::lock_guard<std::mutex> guard(m_lock);
+                    if (!m_error) m_error = std::current_exception();
+                }
+                owner() = outer_pool;
+                current_worker() = outer_worker;
+            }
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (--m_pending == 0) m_done.notify_all();
+        }
+    }
+};
+
+}  // namespace ac
+#endif
@@ -0,0 +1,95 @@
+#include <algorithm>  // std::sort
+#include <cmath>      // std::fabs
+#include <tuple>      // std::tuple
+#include <vector>     // std::vector
+
+#include "../driver/account_columns.h"  // header file for tested functions
+#include "../driver/account_gen.h"      // To generate accounts
+#include "../include/hashtbl.h"         // The table the snapshot is taken from
+#include "gtest/gtest.h"                // gtest lib
+
+// ============================================================================
+// TESTING COLUMNAR SNAPSHOTS
+// ============================================================================
+
+namespace {
+using AcctTable = ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual>;
+using Row = std::tuple<int, int, int, float>;
+
+/// The kernels add in another order than the reference loops; allow for rounding.
+void expect_close(double a, double b) { EXPECT_LE(std::fabs(a - b), 1e-9 * std::fabs(b) + 1e-6); }
+}  // namespace
+
+TEST(AccountColumns, SnapshotMatchesTable) {
+    AcctTable table;
+    AccountGenerator gen(4);
+    for (auto &a : gen.generate(1003)) table.insert(a.getKey(), a);
+
+    auto cols = snapshot_columns(table);
+    ASSERT_EQ(cols.size(), table.size());
+    std::vector<Row> want, got;
+    table.for_each([&](const Account::AcctKey &, const Account &a) {
+        want.emplace_back(a.m_bank_code, a.m_branch_code, a.m_number, a.m_balance);
+    });
+    for (std::size_t i{0}; i < cols.size(); i++) {
+        got.emplace_back(cols.bank[i], cols.branch[i], cols.number[i], cols.balance[i]);
+        ASSERT_EQ(cols.bank[i], cols.bank_codes[cols.bank_id[i]]);
+    }
+    std::sort(want.begin(), want.end());
+    std::sort(got.begin(), got.end());
+    ASSERT_EQ(got, want);
+    ASSERT_TRUE(std::is_sorted(cols.bank_codes.begin(), cols.bank_codes.end()));
+
+    auto empty = snapshot_columns(AcctTable());
+    ASSERT_EQ(empty.size(), 0u);
+    ASSERT_EQ(sum_balance(empty, 1), 0.0);
+    ASSERT_TRUE(totals_by_bank(empty).sum.empty());
+}
+
+TEST(AccountColumns, KernelsAgreeWithScalar) {
+    AcctTable table;
+    AccountGenerator gen(5);
+    // Odd sizes leave a tail shorter than a vector.
+    for (auto &a : gen.generate(20011)) table.insert(a.getKey(), a);
+    auto cols = snapshot_columns(table);
+
+    std::vector<Isa> isas{Isa::scalar, Isa::best};
+    if (isa_supported(Isa::avx2)) isas.push_back(Isa::avx2);
+    for (auto isa : isas) {
+        for (auto code : {1, 33, 341, 999}) {
+            double want{0};
+            for (std::size_t i{0}; i < cols.size(); i++)
+                if (cols.bank[i] == code) want += cols.balance[i];
+            expect_close(sum_balance(cols, code, isa), want);
+        }
+        std::size_t want{0};
+        for (auto b : cols.balance) want += (b >= 0.f and b < 100.f);
+        ASSERT_EQ(count_balance(cols, 0.f, 100.f, isa), want);  // Zero balances included, the upper bound excluded.
+        ASSERT_EQ(count_balance(cols, 5.f, 5.f, isa), 0u);
+
+        auto totals = totals_by_bank(cols, isa);
+        ASSERT_EQ(totals.sum.size(), cols.bank_codes.size());
+        std::size_t accounts{0};
+        for (std::size_t g{0}; g < cols.bank_codes.size(); g++) {
+            expect_close(totals.sum[g], sum_balance(cols, cols.bank_codes[g], Isa::scalar));
+            accounts += totals.count[g];
+        }
+        ASSERT_EQ(accounts, cols.size());
+    }
+}
+
+TEST(AccountColumns, GroupByFewBanks) {
+    // Up to four banks take the vectorized group-by, when the CPU has it.
+    AccountColumns cols;
+    for (int i{0}; i < 1001; i++) cols.push_back(Account("x", i % 7 == 0 ? 341 : (i % 3 ? 1 : 33), 1, i, i * 0.25f));
+    cols.encode_banks();
+    ASSERT_EQ(cols.bank_codes, (std::vector<int>{1, 33, 341}));
+
+    auto scalar = totals_by_bank(cols, Isa::scalar);
+    auto best = totals_by_bank(cols);
+    for (std::size_t g{0}; g < 3; g++) {
+        expect_close(best.sum[g], scalar.sum[g]);
+        ASSERT_EQ(best.count[g], scalar.count[g]);
+    }
+    ASSERT_EQ(scalar.count[2], 143u);
+}
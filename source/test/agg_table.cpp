@@ -0,0 +1,73 @@
+#include <cmath>   // std::abs
+#include <map>     // std::map
+#include <random>  // std::mt19937
+#include <vector>  // std::vector
+
+#include "../include/agg_table.h"  // header file for tested functions
+#include "gtest/gtest.h"           // gtest lib
+
+// ============================================================================
+// TESTING THE AGGREGATION TABLE
+// ============================================================================
+
+namespace {
+using Groups = std::map<int, ac::AggState<float> >;
+
+void expect_same_groups(const ac::AggTable<int, float> &table, const Groups &want) {
+    ASSERT_EQ(table.size(), want.size());
+    for (const auto &g : want) {
+        auto s = table.find(g.first);
+        ASSERT_NE(s, nullptr) << "group " << g.first;
+        EXPECT_EQ(s->count, g.second.count);
+        EXPECT_NEAR(s->sum, g.second.sum, 1e-6 * std::abs(g.second.sum) + 1e-6);
+        EXPECT_EQ(s->min, g.second.min);
+        EXPECT_EQ(s->max, g.second.max);
+    }
+}
+}  // namespace
+
+TEST(AggTable, MatchesMapAcrossCardinalities) {
+    std::mt19937 rng(9);
+    for (int groups : {1, 7, 1000, 50000}) {
+        std::vector<int> keys;
+        std::vector<float> values;
+        Groups want;
+        for (int i{0}; i < 100003; i++) {
+            // Negative keys too: any integer is a valid group.
+            keys.push_back(static_cast<int>(rng() % groups) - groups / 2);
+            values.push_back(static_cast<float>(rng() % 2000) - 1000.f);
+            want[keys.back()].add(values.back());
+        }
+        ac::AggTable<int, float> table;  // Starts small: grows many times on the way.
+        table.aggregate(keys.data(), values.data(), keys.size());
+        expect_same_groups(table, want);
+        ASSERT_LE(table.size(), table.capacity() / 2);
+        ASSERT_EQ(table.find(groups), nullptr);
+
+        ac::ThreadPool pool(4);
+        ac::AggTable<int, float> parallel;
+        parallel.parallel_aggregate(keys.data(), values.data(), keys.size(), pool);
+        expect_same_groups(parallel, want);
+    }
+}
+
+TEST(AggTable, AddMergeAndClear) {
+    ac::AggTable<long long, double> a, b;
+    a.add(1LL << 40, 2.5);
+    a.add(1LL << 40, -1.0);
+    b.add(1LL << 40, 10.0);
+    b.add(7, 3.0);
+    a.merge(b);
+    ASSERT_EQ(a.size(), 2u);
+    auto big = a.find(1LL << 40);
+    ASSERT_EQ(big->count, 3u);
+    ASSERT_DOUBLE_EQ(big->sum, 11.5);
+    ASSERT_DOUBLE_EQ(big->mean(), 11.5 / 3);
+    ASSERT_EQ(big->min, -1.0);
+    ASSERT_EQ(big->max, 10.0);
+
+    a.clear();
+    ASSERT_TRUE(a.empty());
+    ASSERT_EQ(a.find(7), nullptr);
+    a.for_each([](long long, const ac::AggState<double> &) { FAIL(); });
+}
@@ -0,0 +1,142 @@
+#include <array>    // std::array
+#include <cstdint>  // std::int64_t
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+#include "../include/batch_hash.h"  // header file for tested functions
+#include "../include/hashtbl.h"     // retrieve_many() on top of it
+#include "gtest/gtest.h"            // gtest lib
+
+// ============================================================================
+// TESTING BATCH KEY HASHING
+// ============================================================================
+
+namespace {
+/// Checks that hash_batch() agrees with operator() on the first n keys, for every n up to keys_.size().
+template <class Hash, class Key>
+void expect_same_as_scalar(const Hash& hash_, const std::vector<Key>& keys_) {
+    for (std::size_t n{0}; n <= keys_.size(); n++) {
+        std::vector<std::size_t> out(n + 1, 12345);
+        hash_.hash_batch(keys_.data(), n, out.data());
+        for (std::size_t i{0}; i < n; i++) ASSERT_EQ(out[i], hash_(keys_[i])) << "n=" << n << " i=" << i;
+        ASSERT_EQ(out[n], 12345u) << "written past the end, n=" << n;
+    }
+}
+
+template <std::size_t N>
+std::array<char, N> code(int i_) {
+    std::array<char, N> key;
+    for (std::size_t c{0}; c < N; c++) key[c] = static_cast<char>('A' + (i_ * 7 + static_cast<int>(c) * 13) % 26);
+    auto digits = std::to_string(i_);
+    for (std::size_t c{0}; c < digits.size() and c < N; c++) key[N - 1 - c] = digits[digits.size() - 1 - c];
+    return key;
+}
+
+template <std::size_t N>
+std::vector<std::array<char, N> > codes(int n_) {
+    std::vector<std::array<char, N> > keys;
+    for (int i{0}; i < n_; i++) keys.push_back(code<N>(i));
+    return keys;
+}
+
+/// A hash with no batch form.
+struct ScalarOnly {
+    std::size_t operator()(int key_) const { return static_cast<std::size_t>(key_); }
+};
+}  // namespace
+
+TEST(BatchHash, IntBatchMatchesScalar) {
+    std::vector<int> keys;
+    for (int i{0}; i < 37; i++) keys.push_back(i * -104729 + 17);
+    expect_same_as_scalar(ac::IntBatchHash<int>(), keys);
+
+    std::vector<unsigned> ukeys(keys.begin(), keys.end());
+    expect_same_as_scalar(ac::IntBatchHash<unsigned>(), ukeys);
+
+    std::vector<std::int64_t> lkeys;
+    for (std::int64_t i{0}; i < 37; i++) lkeys.push_back(i * 0x100000001LL - 5);
+    expect_same_as_scalar(ac::IntBatchHash<std::int64_t>(), lkeys);
+}
+
+TEST(BatchHash, IntHashSpreadsNearbyKeys) {
+    ac::IntBatchHash<int> hash;
+    // Consecutive keys must not land on consecutive buckets.
+    std::vector<bool> used(1024, false);
+    std::size_t distinct{0};
+    for (int i{0}; i < 512; i++) {
+        auto b = hash(i) & 1023;
+        distinct += !used[b];
+        used[b] = true;
+    }
+    ASSERT_GT(distinct, 350u);
+    ASSERT_NE(hash(0), hash(1));
+}
+
+TEST(BatchHash, FixedStringBatchMatchesScalar) {
+    expect_same_as_scalar(ac::FixedStringBatchHash<5>(), codes<5>(23));
+    expect_same_as_scalar(ac::FixedStringBatchHash<12>(), codes<12>(23));
+    expect_same_as_scalar(ac::FixedStringBatchHash<16>(), codes<16>(23));
+    expect_same_as_scalar(ac::FixedStringBatchHash<1>(), codes<1>(9));
+}
+
+TEST(BatchHash, FixedStringHashSeesEveryByte) {
+    ac::FixedStringBatchHash<13> hash;
+    auto key = code<13>(42);
+    auto h = hash(key);
+    for (std::size_t c{0}; c < key.size(); c++) {
+        auto other = key;
+        other[c] ^= 1;
+        ASSERT_NE(hash(other), h) << "byte " << c;
+    }
+}
+
+TEST(BatchHash, DetectsBatchForm) {
+    ASSERT_TRUE((ac::detail::has_hash_batch<ac::IntBatchHash<int>, int>::value));
+    ASSERT_TRUE((ac::detail::has_hash_batch<ac::FixedStringBatchHash<8>, std::array<char, 8> >::value));
+    ASSERT_FALSE((ac::detail::has_hash_batch<std::hash<int>, int>::value));
+    ASSERT_FALSE((ac::detail::has_hash_batch<ScalarOnly, int>::value));
+
+    // Without a batch form, hash_keys() falls back to one call per key.
+    int keys[] = {3, 1, 4, 1, 5};
+    std::size_t out[5];
+    ac::detail::hash_keys(ScalarOnly(), keys, 5, out);
+    for (int i{0}; i < 5; i++) ASSERT_EQ(out[i], static_cast<std::size_t>(keys[i]));
+}
+
+TEST(BatchHash, RetrieveManyWithIntBatchHash) {
+    ac::HashTbl<int, int, ac::IntBatchHash<int> > table;
+    for (int i{0}; i < 1000; i += 2) table.insert(i, -i);
+
+    std::vector<int> keys;
+    for (int i{0}; i < 123; i++) keys.push_back(i * 7);
+    std::vector<const int *> out(keys.size());
+    auto found = table.retrieve_many(keys.data(), keys.size(), out.data());
+
+    std::size_t expected{0};
+    for (std::size_t i{0}; i < keys.size(); i++) {
+        ASSERT_EQ(out[i], table.find(keys[i]));
+        if (out[i]) {
+            ASSERT_EQ(*out[i], -keys[i]);
+        }
+        expected += keys[i] % 2 == 0 and keys[i] < 1000;
+    }
+    ASSERT_EQ(found, expected);
+}
+
+TEST(BatchHash, RetrieveManyWithFixedStringKeys) {
+    using Code = std::array<char, 12>;
+    ac::HashTbl<Code, int, ac::FixedStringBatchHash<12> > table;
+    auto keys = codes<12>(300);
+    for (int i{0}; i < 300; i += 3) table.insert(keys[i], i);
+
+    std::vector<const int *> out(keys.size());
+    ASSERT_EQ(table.retrieve_many(keys.data(), keys.size(), out.data()), 100u);
+    for (int i{0}; i < 300; i++) {
+        if (i % 3 == 0) {
+            ASSERT_NE(out[i], nullptr);
+            ASSERT_EQ(*out[i], i);
+        } else {
+            ASSERT_EQ(out[i], nullptr);
+        }
+    }
+}
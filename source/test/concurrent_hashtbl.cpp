@@ -0,0 +1,222 @@
+#include <atomic>     // std::atomic
+#include <random>     // std::mt19937
+#include <stdexcept>  // std::invalid_argument
+#include <thread>     // std::thread
+#include <utility>    // std::pair
+#include <vector>     // std::vector
+
+#include "../include/concurrent_hashtbl.h"  // header file for tested functions
+#include "gtest/gtest.h"                    // gtest lib
+
+// ============================================================================
+// TESTING THE CONCURRENT HASH TABLE
+// ============================================================================
+
+TEST(ConcurrentHashTbl, BasicOperationsAndGrowth) {
+    ac::ConcurrentHashTbl<int, int> ht(4, 8);
+    ASSERT_TRUE(ht.empty());
+    ASSERT_EQ(ht.bucket_count(), 8u);  // Never fewer buckets than stripes.
+    for (int i{0}; i < 1000; i++) ASSERT_TRUE(ht.insert(i, i));
+    ASSERT_FALSE(ht.insert(7, 70));
+    ASSERT_EQ(ht.size(), 1000u);
+    ASSERT_GE(ht.bucket_count(), 512u);
+
+    int data;
+    ASSERT_TRUE(ht.retrieve(7, data));
+    ASSERT_EQ(data, 70);
+    ASSERT_TRUE(ht.update(8, [](int &d) { d = -d; }));
+    ASSERT_TRUE(ht.retrieve(8, data));
+    ASSERT_EQ(data, -8);
+    ASSERT_FALSE(ht.update(5000, [](int &d) { d = 0; }));
+    ASSERT_TRUE(ht.erase(9));
+    ASSERT_FALSE(ht.erase(9));
+    ASSERT_FALSE(ht.retrieve(9, data));
+
+    long sum{0};
+    ht.for_each([&](const int &, const int &d) { sum += d; });
+    ASSERT_EQ(sum, 999L * 1000 / 2 - 7 + 70 - 16 - 9);
+
+    // Transactions see all their keys, or do nothing.
+    ASSERT_TRUE(ht.transact(1, 2, [](int &a, int &b) { std::swap(a, b); }));
+    ASSERT_TRUE(ht.retrieve(1, data));
+    ASSERT_EQ(data, 2);
+    ASSERT_FALSE(ht.transact(1, 9, [](int &a, int &) { a = 0; }));
+    ASSERT_TRUE(ht.retrieve(1, data));
+    ASSERT_EQ(data, 2);
+    const int keys[] = {10, 20, 30, 20};
+    ASSERT_TRUE(ht.transact(keys, 4, [](int *const *d) { *d[0] = *d[1] + *d[2] + *d[3]; }));
+    ASSERT_TRUE(ht.retrieve(10, data));
+    ASSERT_EQ(data, 70);
+
+    ASSERT_THROW((ac::ConcurrentHashTbl<int, int>(16, 6)), std::invalid_argument);
+}
+
+TEST(ConcurrentHashTbl, GrowsOnTheLoadOfTheWholeTable) {
+    ac::ConcurrentHashTbl<int, int> ht;  // 64 buckets, 64 stripes: one bucket's worth of load per stripe.
+    ASSERT_EQ(ht.bucket_count(), 64u);
+    // std::hash<int> is the identity: multiples of 64 all land in stripe 0.
+    for (int i{0}; i < 32; i++) ht.insert(i * 64, i);
+    ASSERT_EQ(ht.bucket_count(), 64u);
+    // Past one element per bucket over the whole table, it grows.
+    for (int i{0}; i < 64; i++) ht.insert(i * 64 + 1, i);
+    ASSERT_EQ(ht.size(), 96u);
+    ASSERT_EQ(ht.bucket_count(), 128u);
+}
+
+TEST(ConcurrentHashTbl, ConcurrentTransfersKeepTheTotal) {
+    const int accounts = 2000, per_thread = 20000, n_threads = 4;
+    ac::ConcurrentHashTbl<int, long> ht(16, 16);
+    std::vector<std::thread> threads;
+    // Half of the accounts are opened while the transfers run, so the table grows under them.
+    for (int i{0}; i < accounts / 2; i++) ht.insert(i, 1000);
+    threads.emplace_back([&] {
+        for (int i{accounts / 2}; i < accounts; i++) ht.insert(i, 1000);
+    });
+    for (int t{0}; t < n_threads; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            for (int i{0}; i < per_thread; i++) {
+                int from = static_cast<int>(rng() % accounts), to = static_cast<int>(rng() % accounts);
+                ht.transact(from, to, [&](long &a, long &b) {
+                    long amount = static_cast<long>(rng() % 100);
+                    a -= amount;
+                    b += amount;
+                });
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+
+    ASSERT_EQ(ht.size(), static_cast<std::size_t>(accounts));
+    long total{0};
+    ht.for_each([&](const int &, const long &b) { total += b; });
+    ASSERT_EQ(total, 1000L * accounts);
+}
+
+TEST(ConcurrentHashTbl, VersionStamps) {
+    ac::ConcurrentHashTbl<int, long, std::hash<int>, std::equal_to<int>, true> ht(16, 4);
+    ac::EpochDomain::Handle reader(ht.epochs());
+    long data;
+    ASSERT_EQ(ht.retrieve_versioned(1, data, reader), 0u);
+    ht.insert(1, 100);
+    auto v = ht.retrieve_versioned(1, data, reader);
+    ASSERT_GT(v, 0u);
+    ASSERT_EQ(data, 100);
+
+    // Any write moves the version on, and a stale one is refused.
+    ASSERT_TRUE(ht.compare_and_update(1, v, [](long &d) { d += 5; }));
+    ASSERT_FALSE(ht.compare_and_update(1, v, [](long &d) { d += 5; }));
+    auto v2 = ht.retrieve_versioned(1, data, reader);
+    ASSERT_EQ(data, 105);
+    ASSERT_GT(v2, v);
+    ht.update(1, [](long &d) { d++; });
+    ht.insert(2, 0);
+    ht.transact(1, 2, [](long &a, long &b) { std::swap(a, b); });
+    auto v3 = ht.retrieve_versioned(1, data, reader);
+    ASSERT_EQ(v3, v2 + 2);
+    ASSERT_FALSE(ht.compare_and_update(1, v2, [](long &d) { d = 0; }));
+
+    // Erased and inserted again: no version of the old entry matches the new one.
+    ht.erase(1);
+    ASSERT_FALSE(ht.compare_and_update(1, v3, [](long &d) { d = 0; }));
+    ht.insert(1, 7);
+    ASSERT_GT(ht.retrieve_versioned(1, data, reader), v3);
+    ASSERT_FALSE(ht.compare_and_update(1, v3, [](long &d) { d = 0; }));
+
+    // Optimistic increments from several threads: retries, but no lost update.
+    const int n_threads = 4, per_thread = 5000;
+    std::vector<std::thread> threads;
+    for (int t{0}; t < n_threads; t++) {
+        threads.emplace_back([&] {
+            ac::EpochDomain::Handle own(ht.epochs());
+            for (int i{0}; i < per_thread; i++) {
+                long copy{0};
+                for (;;) {
+                    auto version = ht.retrieve_versioned(2, copy, own);
+                    if (ht.compare_and_update(2, version, [&](long &d) { d = copy + 1; })) break;
+                }
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    ASSERT_TRUE(ht.retrieve(2, data));
+    ASSERT_EQ(data, 106L + n_threads * per_thread);
+}
+
+TEST(ConcurrentHashTbl, VersionedReadsTakeNoLock) {
+    // Readers walk the buckets while writers rewrite entries, erase nodes and grow the table under them: every read
+    // finds the keys that stay, with both halves of a pair written together, and the erased nodes still get freed.
+    using Pair = std::pair<long, long>;
+    ac::ConcurrentHashTbl<int, Pair, std::hash<int>, std::equal_to<int>, true> ht(16, 8);
+    const int stay = 500, churn = 20000;
+    for (int k{0}; k < stay; k++) ht.insert(k, Pair(k, -k));
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int t{0}; t < 2; t++) {
+        threads.emplace_back([&, t] {
+            for (int i{0}; i < churn; i++) {
+                int k = stay + 2 * i + t;
+                ht.insert(k, Pair(k, -k));
+                ht.update(i % stay, [&](Pair &p) { p = Pair(i, -i); });
+                if (i % 3 != 0) ht.erase(k);
+            }
+        });
+    }
+    std::atomic<long> misses{0}, torn{0};
+    for (int t{0}; t < 2; t++) {
+        threads.emplace_back([&, t] {
+            ac::EpochDomain::Handle reader(ht.epochs());
+            std::mt19937 rng(t);
+            while (!done.load()) {
+                Pair p;
+                int k = static_cast<int>(rng() % (stay + 2 * churn));
+                auto version = ht.retrieve_versioned(k, p, reader);
+                if (version == 0) misses += k < stay;
+                else torn += p.first + p.second != 0;
+            }
+        });
+    }
+    threads[0].join();
+    threads[1].join();
+    done = true;
+    threads[2].join();
+    threads[3].join();
+
+    ASSERT_EQ(misses.load(), 0);
+    ASSERT_EQ(torn.load(), 0);
+    ASSERT_EQ(ht.size(), static_cast<std::size_t>(stay + 2 * ((churn + 2) / 3)));
+    ASSERT_GT(ht.epochs().freed(), 0u);
+}
+
+TEST(ConcurrentHashTbl, WritersGrowTheTableTogether) {
+    // Enough keys for the table to double many times, with chunks of buckets moved by whichever writer gets there.
+    const int n_threads = 4, per_thread = 100000;
+    ac::ConcurrentHashTbl<int, int> ht(16, 16);
+    std::vector<std::thread> threads;
+    for (int t{0}; t < n_threads; t++) {
+        threads.emplace_back([&, t] {
+            for (int i{t}; i < n_threads * per_thread; i += n_threads) {
+                ht.insert(i, i);
+                // Reads and erases in the middle of a resize find the keys, wherever their bucket is at the time.
+                int data;
+                if (i % 7 == 0) ASSERT_TRUE(ht.erase(i));
+                else ASSERT_TRUE(ht.retrieve(i, data));
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+
+    const int kept = n_threads * per_thread - (n_threads * per_thread + 6) / 7;
+    ASSERT_EQ(ht.size(), static_cast<std::size_t>(kept));
+    ASSERT_GE(ht.bucket_count(), static_cast<std::size_t>(kept));
+    long count{0}, sum{0};
+    ht.for_each([&](const int &k, const int &d) {
+        count++;
+        sum += (k == d and k % 7 != 0);
+    });
+    ASSERT_EQ(count, kept);
+    ASSERT_EQ(sum, kept);
+    int data;
+    for (int i{0}; i < n_threads * per_thread; i++) ASSERT_EQ(ht.retrieve(i, data), i % 7 != 0);
+}
@@ -0,0 +1,54 @@
+#include <cstdint>  // std::uint64_t
+#include <vector>   // std::vector
+
+#include "../include/dedup_filter.h"  // header file for tested functions
+#include "gtest/gtest.h"              // gtest lib
+
+// ============================================================================
+// TESTING THE STREAMING DEDUP FILTER
+// ============================================================================
+
+TEST(DedupFilter, DuplicatesWithinTheWindow) {
+    ac::DedupFilter<std::uint32_t> seen(10000, 3);
+    // Three generations of 10000 new ids each, every id sent twice.
+    for (std::uint64_t id{0}; id < 30000; id++) {
+        ASSERT_TRUE(seen.insert(id * 7919));
+        ASSERT_FALSE(seen.insert(id * 7919));
+    }
+    for (std::uint64_t id{0}; id < 30000; id++) ASSERT_TRUE(seen.contains(id * 7919));
+    ASSERT_EQ(seen.evictions(), 0u);
+
+    // One more generation: the first one leaves the window, the others stay.
+    for (std::uint64_t id{30000}; id < 40000; id++) seen.insert(id * 7919);
+    std::size_t still_seen{0};
+    for (std::uint64_t id{0}; id < 10000; id++) still_seen += seen.contains(id * 7919);
+    ASSERT_LT(still_seen, 5u);  // Only false positives, about one in 20 million per lookup.
+    for (std::uint64_t id{10000}; id < 40000; id++) ASSERT_TRUE(seen.contains(id * 7919));
+}
+
+TEST(DedupFilter, FalsePositivesAndManualRotation) {
+    ac::DedupFilter<std::uint16_t> seen(100000, 2, false);
+    std::vector<std::uint64_t> ids;
+    for (std::uint64_t i{0}; i < 200000; i++) ids.push_back(i * 0x9e3779b97f4a7c15ULL);
+    std::vector<char> fresh(ids.size());
+    auto added = seen.insert_batch(ids.data(), ids.size(), reinterpret_cast<bool *>(fresh.data()));
+    // Full window: a new id is taken for a duplicate with about expected_false_positive_rate().
+    ASSERT_GT(added, ids.size() * 0.98);
+    ASSERT_EQ(seen.insert_batch(ids.data(), ids.size()), 0u);  // Everything inserted is recognized.
+
+    std::size_t false_positives{0}, probes{100000};
+    for (std::uint64_t i{0}; i < probes; i++) false_positives += seen.contains((i + 1) * 0xc2b2ae3d27d4eb4fULL);
+    double rate = static_cast<double>(false_positives) / probes;
+    EXPECT_LT(rate, 2 * seen.expected_false_positive_rate());
+    EXPECT_GT(rate, 0.0);
+
+    // Without auto-rotation the ids stay until rotate() pushes their generation out of the window.
+    seen.rotate();
+    ASSERT_TRUE(seen.contains(ids[0]));
+    seen.rotate();
+    std::size_t left{0};
+    for (auto id : ids) left += seen.contains(id);
+    ASSERT_EQ(left, 0u);  // Empty table: no false positives either.
+    ASSERT_THROW(ac::DedupFilter<>(10, 16), std::invalid_argument);
+    ASSERT_THROW(ac::DedupFilter<>(0, 4, false), std::invalid_argument);  // Nothing to size the table for.
+}
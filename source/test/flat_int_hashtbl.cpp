@@ -0,0 +1,120 @@
+#include <cstdint>        // std::int64_t
+#include <random>         // std::mt19937
+#include <stdexcept>      // std::invalid_argument, std::length_error
+#include <thread>         // std::thread
+#include <unordered_map>  // std::unordered_map
+#include <vector>         // std::vector
+
+#include "../include/flat_int_hashtbl.h"  // header file for tested functions
+#include "gtest/gtest.h"                  // gtest lib
+
+// ============================================================================
+// TESTING THE OPEN-ADDRESSING INTEGER TABLE
+// ============================================================================
+
+TEST(FlatIntHashTbl, BasicOperationsAndGrowth) {
+    ac::FlatIntHashTbl<int, int> ht;
+    ASSERT_TRUE(ht.empty());
+    for (int i{0}; i < 1000; i++) ASSERT_TRUE(ht.insert(i, 2 * i));
+    ASSERT_FALSE(ht.insert(7, 70));
+    ASSERT_EQ(ht.size(), 1000u);
+    ASSERT_GE(ht.capacity(), 2000u);
+
+    int data;
+    ASSERT_TRUE(ht.retrieve(7, data));
+    ASSERT_EQ(data, 70);
+    ASSERT_EQ(*ht.find(8), 16);
+    ASSERT_EQ(ht.find(5000), nullptr);
+    ASSERT_FALSE(ht.retrieve(-1, data));
+    ASSERT_TRUE(ht.erase(9));
+    ASSERT_FALSE(ht.erase(9));
+    ASSERT_FALSE(ht.retrieve(9, data));
+    ASSERT_EQ(ht.size(), 999u);
+
+    // Negative keys, and the empty marker, which is reserved.
+    ASSERT_TRUE(ht.insert(-5, 1));
+    ASSERT_TRUE(ht.retrieve(-5, data));
+    ASSERT_THROW(ht.insert(ht.empty_key(), 0), std::invalid_argument);
+    ASSERT_FALSE(ht.retrieve(ht.empty_key(), data));
+
+    ht.clear();
+    ASSERT_TRUE(ht.empty());
+    ASSERT_FALSE(ht.retrieve(7, data));
+}
+
+TEST(FlatIntHashTbl, OverwritingAtTheLimitDoesNotGrow) {
+    ac::FlatIntHashTbl<int, int> ht(8);
+    auto capacity = ht.capacity();
+    int n{0};
+    while (static_cast<double>(n + 1) <= capacity * 0.5) ASSERT_TRUE(ht.insert(n++, 0));
+    // Full up to the load limit: a new key would grow the table, an existing one must not.
+    for (int i{0}; i < n; i++) ASSERT_FALSE(ht.insert(i, i));
+    ASSERT_EQ(ht.capacity(), capacity);
+    ASSERT_TRUE(ht.insert(n, n));
+    ASSERT_EQ(ht.capacity(), 2 * capacity);
+    int data;
+    for (int i{0}; i <= n; i++) {
+        ASSERT_TRUE(ht.retrieve(i, data));
+        ASSERT_EQ(data, i);
+    }
+}
+
+TEST(FlatIntHashTbl, MatchesAMapUnderRandomOperations) {
+    // Few distinct keys in a small table: long runs that wrap around the end, and erases in the middle of them.
+    ac::FlatIntHashTbl<std::int64_t, int> ht(4, -1);
+    std::unordered_map<std::int64_t, int> expected;
+    std::mt19937 rng(5);
+    for (int op{0}; op < 200000; op++) {
+        std::int64_t key = static_cast<std::int64_t>(rng() % 300) * 1000003;
+        int value = static_cast<int>(rng());
+        switch (rng() % 3) {
+            case 0:
+                ASSERT_EQ(ht.insert(key, value), expected.count(key) == 0);
+                expected[key] = value;
+                break;
+            case 1:
+                ASSERT_EQ(ht.erase(key), expected.erase(key) == 1);
+                break;
+            default:
+                int data;
+                ASSERT_EQ(ht.retrieve(key, data), expected.count(key) == 1);
+                if (expected.count(key)) {
+                    ASSERT_EQ(data, expected[key]);
+                }
+        }
+        ASSERT_EQ(ht.size(), expected.size());
+    }
+}
+
+TEST(FlatIntHashTbl, ConcurrentInserts) {
+    const int n_threads = 4, keys = 50000;
+    ac::FlatIntHashTbl<int, int, true> ht(keys);
+    std::vector<std::thread> threads;
+    // Every thread inserts every key: each key is new to exactly one of them.
+    std::vector<int> fresh(n_threads, 0);
+    for (int t{0}; t < n_threads; t++) {
+        threads.emplace_back([&, t] {
+            for (int i{0}; i < keys; i++) {
+                int k = (i * 7919 + t * 13) % keys;
+                fresh[t] += ht.insert(k, k + 1);
+                int data;
+                ASSERT_TRUE(ht.retrieve(k, data));
+                ASSERT_TRUE(data == k + 1 or data == 0);  // 0 only while the data of a new key is on its way.
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+
+    int total{0};
+    for (auto f : fresh) total += f;
+    ASSERT_EQ(total, keys);
+    ASSERT_EQ(ht.size(), static_cast<std::size_t>(keys));
+    for (int k{0}; k < keys; k++) {
+        int data;
+        ASSERT_TRUE(ht.retrieve(k, data));
+        ASSERT_EQ(data, k + 1);
+    }
+    ac::FlatIntHashTbl<int, int, true> tiny(1);
+    for (int k{0}; k < static_cast<int>(tiny.capacity()); k++) tiny.insert(k, k);
+    ASSERT_THROW(tiny.insert(-1, 0), std::length_error);
+}
@@ -0,0 +1,76 @@
+#include <atomic>  // std::atomic
+#include <thread>  // std::thread
+
+#include "../include/front_cache.h"  // header file for tested functions
+#include "gtest/gtest.h"             // gtest lib
+
+// ============================================================================
+// TESTING THE PER-THREAD FRONT CACHE
+// ============================================================================
+
+TEST(FrontCache, HitsUntilTheStripeIsWritten) {
+    using Table = ac::ConcurrentHashTbl<int, int>;
+    Table ht(64, 4);
+    for (int i{0}; i < 100; i++) ht.insert(i, i);
+    ac::FrontCache<Table> cache(ht, 3000);
+    ASSERT_EQ(cache.slot_count(), 4096u);
+
+    int data;
+    ASSERT_TRUE(cache.retrieve(5, data));
+    ASSERT_EQ(data, 5);
+    ASSERT_TRUE(cache.retrieve(5, data));
+    ASSERT_EQ(cache.hits(), 1u);
+    ASSERT_EQ(cache.misses(), 1u);
+
+    // Every kind of write invalidates the copy.
+    ht.update(5, [](int &d) { d = 50; });
+    ASSERT_TRUE(cache.retrieve(5, data));
+    ASSERT_EQ(data, 50);
+    ht.insert(5, 51);
+    ASSERT_TRUE(cache.retrieve(5, data));
+    ASSERT_EQ(data, 51);
+    ht.transact(5, 6, [](int &a, int &b) { std::swap(a, b); });
+    ASSERT_TRUE(cache.retrieve(5, data));
+    ASSERT_EQ(data, 6);
+    ht.erase(5);
+    ASSERT_FALSE(cache.retrieve(5, data));
+    ASSERT_FALSE(cache.retrieve(5, data));
+    ASSERT_EQ(cache.hits(), 1u);
+
+    // Reads of the other keys keep hitting until something is written.
+    for (int round{0}; round < 3; round++)
+        for (int i{10}; i < 20; i++) ASSERT_TRUE(cache.retrieve(i, data));
+    ASSERT_EQ(cache.hits(), 1u + 2 * 10);
+    ASSERT_DOUBLE_EQ(cache.hit_ratio(), 21.0 / (21 + 6 + 10));
+    cache.clear();
+    ASSERT_EQ(cache.hits() + cache.misses(), 0u);
+}
+
+TEST(FrontCache, NeverServesAReplacedValue) {
+    using Table = ac::ConcurrentHashTbl<int, long>;
+    Table ht(64, 8);
+    for (int i{0}; i < 8; i++) ht.insert(i, 0);
+    const long writes = 20000;
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (long v{1}; v <= writes; v++) ht.update(static_cast<int>(v % 8), [&](long &d) { d = v; });
+        done = true;
+    });
+    // Values only grow, so a copy served after a newer value was read would show as a step back.
+    ac::FrontCache<Table> cache(ht);
+    long last[8] = {0};
+    while (!done) {
+        for (int k{0}; k < 8; k++) {
+            long data;
+            ASSERT_TRUE(cache.retrieve(k, data));
+            ASSERT_GE(data, last[k]);
+            last[k] = data;
+        }
+    }
+    writer.join();
+    for (int k{0}; k < 8; k++) {
+        long data;
+        ASSERT_TRUE(cache.retrieve(k, data));
+        ASSERT_EQ(data, writes - (writes - k) % 8);
+    }
+}
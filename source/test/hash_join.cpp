@@ -0,0 +1,76 @@
+#include <algorithm>  // std::sort
+#include <string>     // std::string
+#include <utility>    // std::pair
+#include <vector>     // std::vector
+
+#include "../include/hash_join.h"  // header file for tested functions
+#include "../include/hashtbl.h"    // The build side
+#include "gtest/gtest.h"           // gtest lib
+
+// ============================================================================
+// TESTING BATCHED LOOKUPS AND THE HASH JOIN
+// ============================================================================
+
+namespace {
+struct Txn {
+    int account;
+    int amount;
+};
+}  // namespace
+
+TEST(HashJoin, RetrieveMany) {
+    ac::HashTbl<int, std::string> table;
+    for (int i{0}; i < 1000; i += 2) table.insert(i, std::to_string(i));
+
+    std::vector<int> keys;
+    for (int i{0}; i < 123; i++) keys.push_back(i * 7);  // Not a multiple of the group size.
+    std::vector<const std::string *> out(keys.size());
+    auto found = table.retrieve_many(keys.data(), keys.size(), out.data());
+
+    std::size_t expected{0};
+    for (std::size_t i{0}; i < keys.size(); i++) {
+        ASSERT_EQ(out[i], table.find(keys[i]));
+        ASSERT_EQ(out[i], table.find_hashed(keys[i], std::hash<int>()(keys[i])));
+        expected += keys[i] % 2 == 0 and keys[i] < 1000;
+    }
+    ASSERT_EQ(found, expected);
+    ASSERT_EQ(table.retrieve_many(keys.data(), 0, out.data()), 0u);
+}
+
+TEST(HashJoin, MatchesNaiveLoop) {
+    ac::HashTbl<int, std::string> accounts;
+    for (int i{0}; i < 20000; i++)
+        if (i % 3) accounts.insert(i, "acct" + std::to_string(i));
+    std::vector<Txn> txns;
+    for (int i{0}; i < 50000; i++) txns.push_back(Txn{(i * 7919) % 25000, i});
+
+    std::vector<std::pair<int, const std::string *> > want;
+    for (const auto &t : txns) {
+        auto a = accounts.find(t.account);
+        if (a) want.emplace_back(t.amount, a);
+    }
+    std::sort(want.begin(), want.end());
+
+    // Without partitioning, with a budget small enough to force many partitions, and with a short prefetch distance.
+    ac::JoinOptions whole, split, near;
+    split.cache_bytes = 1024;
+    near.prefetch_distance = 1;
+    for (const auto &opt : {whole, split, near}) {
+        std::vector<std::pair<int, const std::string *> > got;
+        auto stats = ac::hash_join(
+            accounts, txns.begin(), txns.end(), [](const Txn &t) { return t.account; },
+            [&](const Txn &t, const std::string &a) { got.emplace_back(t.amount, &a); }, opt);
+        ASSERT_EQ(stats.probes, txns.size());
+        ASSERT_EQ(stats.matches, want.size());
+        if (opt.cache_bytes == 1024) {
+            ASSERT_GT(stats.partitions, 1u);
+        }
+        std::sort(got.begin(), got.end());
+        ASSERT_EQ(got, want);  // Same pairs, pointing into the table.
+    }
+
+    std::vector<Txn> none;
+    auto stats = ac::hash_join(accounts, none.begin(), none.end(), [](const Txn &t) { return t.account; },
+                               [](const Txn &, const std::string &) { FAIL(); });
+    ASSERT_EQ(stats.matches, 0u);
+}
@@ -0,0 +1,141 @@
+#include <sstream>  // std::ostringstream
+#include <string>   // std::string
+#include <thread>   // std::thread
+#include <vector>   // std::vector
+
+#include "../include/hashtbl.h"  // header file for tested functions
+#include "gtest/gtest.h"         // gtest lib
+
+// ============================================================================
+// TESTING OBSERVER POLICY
+// ============================================================================
+
+namespace {
+/// Records every hook, to check when the table calls them.
+struct CountingObserver : ac::NullObserver {
+    static constexpr bool enabled = true;
+
+    std::size_t inserts{0}, erases{0}, rehash_starts{0}, rehash_ends{0}, long_chains{0};
+    std::size_t last_old_buckets{0}, last_new_buckets{0}, last_size{0}, longest{0};
+
+    void on_insert(std::size_t) { inserts++; }
+    void on_erase(std::size_t) { erases++; }
+    void on_rehash_start(std::size_t, std::size_t) { rehash_starts++; }
+    void on_rehash_end(std::size_t old_b, std::size_t new_b, std::size_t size, std::chrono::nanoseconds) {
+        rehash_ends++;
+        last_old_buckets = old_b;
+        last_new_buckets = new_b;
+        last_size = size;
+    }
+    std::size_t long_chain_threshold() const { return 2; }
+    void on_long_chain(std::size_t, std::size_t length) {
+        long_chains++;
+        longest = std::max(longest, length);
+    }
+};
+
+/// Sends every key to bucket 0.
+struct ConstantHash {
+    std::size_t operator()(int) const { return 0; }
+};
+}  // namespace
+
+TEST(HashTblObserver, NullObserverIsDefault) {
+    ac::HashTbl<int, int> htable;
+    ac::NullObserver &obs = htable.observer();
+    (void)obs;
+    ASSERT_FALSE(ac::NullObserver::enabled);
+}
+
+TEST(HashTblObserver, InsertAndEraseCounts) {
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, CountingObserver> htable(100);
+    for (int i{0}; i < 10; i++) htable.insert(i, i);
+    htable.insert(3, 30);  // An update is not an insertion.
+    htable.erase(4);
+    htable.erase(400);  // Not found: not an erasure.
+    htable[50] = 1;     // Inserts through operator[].
+
+    ASSERT_EQ(htable.observer().inserts, 11);
+    ASSERT_EQ(htable.observer().erases, 1);
+    ASSERT_EQ(htable.observer().rehash_starts, 0);
+}
+
+TEST(HashTblObserver, RehashEvents) {
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, CountingObserver> htable(2);
+    for (int i{0}; i < 20; i++) htable.insert(i, i);
+
+    const auto &obs = htable.observer();
+    ASSERT_GT(obs.rehash_starts, 0);
+    ASSERT_EQ(obs.rehash_starts, obs.rehash_ends);
+    ASSERT_EQ(obs.last_new_buckets, htable.bucket_count());
+    ASSERT_LT(obs.last_old_buckets, obs.last_new_buckets);
+    // Rehashing moves the elements, it must not report them as new insertions.
+    ASSERT_EQ(obs.inserts, 20);
+    for (int i{0}; i < 20; i++) ASSERT_EQ(htable.at(i), i);
+}
+
+TEST(HashTblObserver, LongChainDetected) {
+    ac::HashTbl<int, int, ConstantHash, std::equal_to<int>, CountingObserver> htable(100);
+    for (int i{0}; i < 5; i++) htable.insert(i, i);
+
+    // Lists of length 3, 4 and 5 exceed the threshold of 2.
+    ASSERT_EQ(htable.observer().long_chains, 3);
+    ASSERT_EQ(htable.observer().longest, 5);
+}
+
+TEST(HashTblObserver, RehashKeepsReferences) {
+    ac::HashTbl<int, int> htable(2);
+    htable.insert(7, 70);
+    int *before = &htable.at(7);
+    for (int i{100}; i < 200; i++) htable.insert(i, i);  // Several rehashes.
+    ASSERT_EQ(before, &htable.at(7));
+    ASSERT_EQ(*before, 70);
+}
+
+TEST(HashTblObserver, ChromeTrace) {
+    std::ostringstream trace;
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::ChromeTraceObserver> htable(2);
+    htable.observer().attach(trace, "accounts");
+    htable.observer().rehash_budget = std::chrono::nanoseconds(0);  // Every rehash is over budget.
+    for (int i{0}; i < 50; i++) htable.insert(i, i);
+    htable.erase(1);
+    htable.observer().flush();
+
+    auto text = trace.str();
+    ASSERT_EQ(text.find("[\n"), 0);
+    ASSERT_NE(text.find("\"name\":\"rehash\",\"cat\":\"accounts\",\"ph\":\"X\""), std::string::npos);
+    ASSERT_NE(text.find("\"new_buckets\":"), std::string::npos);
+    ASSERT_NE(text.find("rehash_over_budget"), std::string::npos);
+    ASSERT_NE(text.find("\"inserts\":50,\"erases\":1"), std::string::npos);
+}
+
+TEST(HashTblObserver, ChromeTraceEscapesTheName) {
+    std::ostringstream trace;
+    ac::ChromeTraceObserver obs;
+    obs.attach(trace, "acc\"ts\\2024\n");
+    obs.flush();
+    ASSERT_NE(trace.str().find("\"cat\":\"acc\\\"ts\\\\2024\\u000a\""), std::string::npos) << trace.str();
+}
+
+TEST(HashTblObserver, ChromeTraceCopiesOnThreads) {
+    std::ostringstream trace;
+    using Table = ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::ChromeTraceObserver>;
+    Table original(2);
+    original.observer().attach(trace, "accounts");
+    // The copies share the writer and the totals, and rehash at the same time.
+    std::vector<Table> copies(4, original);
+    std::vector<std::thread> threads;
+    for (auto& t : copies)
+        threads.emplace_back([&t] {
+            for (int i{0}; i < 1000; i++) t.insert(i, i);
+        });
+    for (auto& th : threads) th.join();
+    original.observer().flush();
+    ASSERT_NE(trace.str().find("\"inserts\":4000,\"erases\":0"), std::string::npos);
+}
+
+TEST(HashTblObserver, LatencyObserver) {
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::LatencyObserver> htable(2);
+    for (int i{0}; i < 1000; i++) htable.insert(i, i);
+    ASSERT_GT(htable.observer().rehash_ns->count(), 0);
+}
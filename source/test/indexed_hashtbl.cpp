@@ -0,0 +1,88 @@
+#include <algorithm>  // std::sort
+#include <string>     // std::string
+#include <utility>    // std::make_pair
+#include <vector>     // std::vector
+
+#include "../driver/account.h"           // To get the account class
+#include "../include/indexed_hashtbl.h"  // header file for tested functions
+#include "gtest/gtest.h"                 // gtest lib
+
+// ============================================================================
+// TESTING SECONDARY INDEXES
+// ============================================================================
+
+namespace {
+using AcctIndexed = ac::IndexedHashTbl<Account::AcctKey, Account, KeyHash, KeyEqual>;
+
+std::vector<int> numbers(const std::vector<const Account *> &accts) {
+    std::vector<int> v;
+    for (auto a : accts) v.push_back(a->m_number);
+    std::sort(v.begin(), v.end());
+    return v;
+}
+}  // namespace
+
+TEST(IndexedHashTbl, QueriesFollowUpdates) {
+    AcctIndexed accounts;
+    Account seed[] = {{"Alex Bastos", 1, 1668, 54321, 1500.f},
+                      {"Aline Souza", 1, 1668, 45794, 530.f},
+                      {"Cristiano Ronaldo", 13, 557, 87629, 150000.f},
+                      {"Jose Lima", 1, 331, 1231, 850.f}};
+    for (auto &a : seed) accounts.insert(a.getKey(), a);
+
+    // Indexes added to a non-empty table start filled.
+    auto &by_bank = accounts.add_index([](const Account &a) { return a.m_bank_code; });
+    auto &by_branch = accounts.add_index(
+        [](const Account &a) { return std::make_pair(a.m_bank_code, a.m_branch_code); }, ac::PairHash());
+    auto &by_name = accounts.add_index([](const Account &a) { return a.m_name; });
+
+    ASSERT_EQ(numbers(by_bank.find(1)), (std::vector<int>{1231, 45794, 54321}));
+    ASSERT_EQ(numbers(by_branch.find({1, 1668})), (std::vector<int>{45794, 54321}));
+    ASSERT_EQ(by_name.count("Jose Lima"), 1u);
+    ASSERT_TRUE(by_bank.find(99).empty());
+    ASSERT_EQ(by_bank.distinct(), 2u);
+
+    // The index points at the stored value itself.
+    ASSERT_EQ(by_name.find("Cristiano Ronaldo")[0], accounts.find(seed[2].getKey()));
+
+    // Moving an account to another branch re-indexes it; the primary key is unchanged.
+    ASSERT_TRUE(accounts.update(seed[0].getKey(), [](Account &a) { a.m_branch_code = 331; }));
+    ASSERT_EQ(numbers(by_branch.find({1, 1668})), (std::vector<int>{45794}));
+    ASSERT_EQ(numbers(by_branch.find({1, 331})), (std::vector<int>{1231, 54321}));
+    ASSERT_FALSE(accounts.update(Account("Nobody").getKey(), [](Account &) {}));
+
+    // Replacing a value through insert() re-indexes it too.
+    Account renamed = seed[3];
+    renamed.m_name = "Jose Lima Filho";
+    ASSERT_FALSE(accounts.insert(seed[3].getKey(), renamed));
+    ASSERT_EQ(by_name.count("Jose Lima"), 0u);
+    ASSERT_EQ(by_name.count("Jose Lima Filho"), 1u);
+
+    ASSERT_TRUE(accounts.erase(seed[1].getKey()));
+    ASSERT_FALSE(accounts.erase(seed[1].getKey()));
+    ASSERT_EQ(numbers(by_bank.find(1)), (std::vector<int>{1231, 54321}));
+    ASSERT_TRUE(by_branch.find({1, 1668}).empty());
+    ASSERT_EQ(by_branch.distinct(), 2u);
+
+    accounts.clear();
+    ASSERT_TRUE(by_bank.find(1).empty());
+    ASSERT_EQ(by_name.distinct(), 0u);
+}
+
+TEST(IndexedHashTbl, ManyValuesPerKey) {
+    ac::IndexedHashTbl<int, int> table;
+    auto &by_mod = table.add_index([](const int &v) { return v % 10; });
+    for (int i{0}; i < 5000; i++) table.insert(i, i);  // Rehashes move nodes, not values: pointers stay valid.
+    for (int i{0}; i < 5000; i += 3) table.erase(i);
+
+    std::size_t total{0};
+    for (int m{0}; m < 10; m++) {
+        for (auto p : by_mod.find(m)) {
+            ASSERT_EQ(*p % 10, m);
+            ASSERT_NE(*p % 3, 0);
+            ASSERT_EQ(table.find(*p), p);
+        }
+        total += by_mod.count(m);
+    }
+    ASSERT_EQ(total, table.size());
+}
@@ -0,0 +1,79 @@
+#include <thread>  // std::thread
+#include <vector>  // std::vector
+
+#include "../include/latency_histogram.h"  // header file for tested functions
+#include "gtest/gtest.h"                   // gtest lib
+
+// ============================================================================
+// TESTING LATENCY HISTOGRAM
+// ============================================================================
+
+TEST(LatencyHistogram, EmptyHistogram) {
+    ac::LatencyHistogram h;
+    ASSERT_EQ(h.count(), 0);
+    ASSERT_EQ(h.max(), 0);
+    ASSERT_EQ(h.percentile(0.99), 0);
+}
+
+TEST(LatencyHistogram, SmallValuesAreExact) {
+    ac::LatencyHistogram h;
+    for (std::uint64_t v{1}; v <= 50; v++) h.record(v);
+
+    ASSERT_EQ(h.count(), 50);
+    ASSERT_EQ(h.max(), 50);
+    ASSERT_EQ(h.percentile(0.5), 25);
+    ASSERT_EQ(h.percentile(1.0), 50);
+    ASSERT_DOUBLE_EQ(h.mean(), 25.5);
+}
+
+TEST(LatencyHistogram, RelativeErrorIsBounded) {
+    ac::LatencyHistogram h;
+    for (std::uint64_t v{1}; v <= 1000000; v += 7) h.record(v);
+
+    // Every reported percentile must be within the bucket resolution (1/32) of the exact answer.
+    for (double q : {0.5, 0.9, 0.99, 0.999}) {
+        double exact = q * 1000000;
+        double got = static_cast<double>(h.percentile(q));
+        ASSERT_NEAR(got, exact, exact / 32 + 8);
+    }
+    ASSERT_EQ(h.percentile(1.0), h.max());
+}
+
+TEST(LatencyHistogram, HugeValues) {
+    ac::LatencyHistogram h;
+    h.record(~0ULL);
+    h.record(1ULL << 40);
+    ASSERT_EQ(h.max(), ~0ULL);
+    ASSERT_EQ(h.percentile(1.0), ~0ULL);
+    ASSERT_GE(h.percentile(0.5), 1ULL << 40);
+}
+
+TEST(LatencyHistogram, MergeAcrossThreads) {
+    const int n_threads = 4, per_thread = 10000;
+    std::vector<ac::LatencyHistogram> local(n_threads);
+    ac::LatencyHistogram shared;
+    std::vector<std::thread> threads;
+    for (int t{0}; t < n_threads; t++) {
+        threads.emplace_back([&, t] {
+            for (int i{0}; i < per_thread; i++) {
+                local[t].record(i);
+                shared.record(i);  // Concurrent recording into one histogram must not lose counts either.
+            }
+        });
+    }
+    for (auto &th : threads) th.join();
+
+    ac::LatencyHistogram merged;
+    for (const auto &h : local) merged.merge(h);
+    ASSERT_EQ(merged.count(), n_threads * per_thread);
+    ASSERT_EQ(shared.count(), merged.count());
+    ASSERT_EQ(merged.max(), per_thread - 1);
+    ASSERT_EQ(merged.percentile(0.5), shared.percentile(0.5));
+}
+
+TEST(LatencyHistogram, TimedKeepsResult) {
+    ac::LatencyHistogram h;
+    auto r = ac::timed(h, [] { return 42; });
+    ASSERT_EQ(r, 42);
+    ASSERT_EQ(h.count(), 1);
+}
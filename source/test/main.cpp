@@ -3,6 +3,9 @@
 #include <functional>  // std::function
 #include <iterator>    // std::begin(), std::end()
 #include <map>
+#include <type_traits>  // std::true_type, std::false_type
+#include <utility>      // std::declval
+#include <vector>
 
 #include "../driver/account.h"   // To get the account class
 #include "../include/hashtbl.h"  // header file for tested functions
@@ -262,6 +265,19 @@ TEST_F(HTTest, AssignmentOperator) {
     ASSERT_EQ(htable_copy.size(), expected.size());
 }
 
+TEST_F(HTTest, AssignmentOperatorNonEmpty) {
+    ac::HashTbl<char, int> htable{{'a', 27}, {'b', 3}, {'c', 1}};
+    ac::HashTbl<char, int> htable_copy{{'x', 2}, {'y', 1}};
+
+    // The old contents must be dropped, not added to.
+    htable_copy = htable;
+    ASSERT_EQ(htable_copy.size(), htable.size());
+    int data;
+    ASSERT_FALSE(htable_copy.retrieve('x', data));
+    ASSERT_TRUE(htable_copy.retrieve('a', data));
+    ASSERT_EQ(data, 27);
+}
+
 TEST_F(HTTest, AssignmentInitializer) {
     ac::HashTbl<char, int> htable{{'x', 27}, {'y', 3}, {'w', 1}};
     std::map<char, int> expected{{'a', 27}, {'b', 3}, {'c', 1}};
@@ -474,6 +490,106 @@ TEST_F(HTTest, Count) {
     // std::cout << "The table: \n" << htable << std::endl;
 }
 
+TEST_F(HTTest, BucketInterface) {
+    insert_accounts();
+
+    // Every key must be found in the bucket reported by bucket(), and the bucket sizes must add up to size().
+    size_t total{0};
+    for (size_t b{0}; b < ht_accounts.bucket_count(); b++) total += ht_accounts.bucket_size(b);
+    ASSERT_EQ(total, ht_accounts.size());
+
+    for (auto &e : m_accounts) {
+        auto b = ht_accounts.bucket(e.getKey());
+        ASSERT_LT(b, ht_accounts.bucket_count());
+        ASSERT_GE(ht_accounts.bucket_size(b), 1);
+        ASSERT_EQ(ht_accounts.bucket_size(b), ht_accounts.count(e.getKey()));
+    }
+}
+
+TEST_F(HTTest, EraseIf) {
+    insert_accounts();
+
+    // Purge the accounts of bank 1 and the small balances in one sweep.
+    auto removed = ht_accounts.erase_if(
+        [](const Account::AcctKey &, const Account &a) { return a.m_bank_code == 1 or a.m_balance < 200.f; });
+    ASSERT_EQ(removed, 4);
+    ASSERT_EQ(ht_accounts.size(), 4);
+
+    Account a;
+    for (auto &e : m_accounts) {
+        bool purged = e.m_bank_code == 1 or e.m_balance < 200.f;
+        ASSERT_EQ(ht_accounts.retrieve(e.getKey(), a), !purged);
+    }
+    ASSERT_EQ(ht_accounts.erase_if([](const Account::AcctKey &, const Account &) { return false; }), 0);
+    ASSERT_EQ(ht_accounts.erase_if([](const Account::AcctKey &, const Account &) { return true; }), 4);
+    ASSERT_TRUE(ht_accounts.empty());
+}
+
+namespace {
+/// Whether Table::erase() accepts two arguments of type Arg.
+template <class Table, class Arg>
+auto erase_takes_pair(int) -> decltype(std::declval<Table &>().erase(std::declval<Arg>(), std::declval<Arg>()),
+                                       std::true_type());
+template <class, class>
+std::false_type erase_takes_pair(...);
+}  // namespace
+
+TEST_F(HTTest, EraseRange) {
+    // Iterators only: two int keys are not a range.
+    static_assert(decltype(erase_takes_pair<ac::HashTbl<int, int>, int *>(0))::value, "pointers are iterators");
+    static_assert(!decltype(erase_takes_pair<ac::HashTbl<int, int>, int>(0))::value, "two keys are not a range");
+
+    ac::HashTbl<int, int> htable(3);  // Few buckets, so several keys share a bucket.
+    for (int i{0}; i < 100; i++) htable.insert(i, i);
+
+    std::vector<int> keys{5, 17, 17, 99, 1000, 42, -3, 6, 7, 8};  // Repeated and missing keys are skipped.
+    ASSERT_EQ(htable.erase(keys.begin(), keys.end()), 7);
+    ASSERT_EQ(htable.size(), 93);
+    int data;
+    for (int k : keys) ASSERT_FALSE(htable.retrieve(k, data));
+    ASSERT_TRUE(htable.retrieve(4, data));
+
+    std::vector<int> rest;
+    for (int i{0}; i < 100; i++) rest.push_back(i);
+    ASSERT_EQ(htable.erase(rest.begin(), rest.end()), 93);
+    ASSERT_TRUE(htable.empty());
+    ASSERT_EQ(htable.erase(rest.begin(), rest.begin()), 0);
+
+    int some[] = {1, 2, 3};
+    for (int k : some) htable.insert(k, k);
+    ASSERT_EQ(htable.erase(some, some + 3), 3);
+}
+
+TEST_F(HTTest, ApplyBatch) {
+    insert_accounts();
+
+    // Deposits and withdrawals, several on the same account, and one on an account not in the table.
+    struct Adjustment {
+        Account::AcctKey key;
+        float amount;
+    };
+    std::vector<Adjustment> batch;
+    for (int round{0}; round < 3; round++)
+        for (auto &e : m_accounts) batch.push_back({e.getKey(), round == 1 ? -100.f : 50.f});
+    batch.push_back({Account::AcctKey("Nobody", 1, 1, 1), 10.f});
+    std::vector<float> seen;  // Balances of target before each of its adjustments, in order.
+    auto applied = ht_accounts.apply_batch(
+        batch.begin(), batch.end(), [](const Adjustment &adj) { return adj.key; },
+        [&](const Adjustment &adj, Account &a) {
+            if (a.getKey() == target.getKey()) seen.push_back(a.m_balance);
+            a.m_balance += adj.amount;
+        });
+    ASSERT_EQ(applied, 24);
+    ASSERT_EQ(ht_accounts.size(), 8);
+    ASSERT_EQ(seen, (std::vector<float>{1500.f, 1550.f, 1450.f}));
+    for (auto &e : m_accounts) ASSERT_EQ(ht_accounts[e.getKey()].m_balance, e.m_balance);  // +50 -100 +50.
+
+    ac::HashTbl<int, int> empty;
+    ASSERT_EQ(empty.apply_batch(batch.begin(), batch.begin(), [](const Adjustment &) { return 0; },
+                                [](const Adjustment &, int &) {}),
+              0);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
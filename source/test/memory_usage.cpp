@@ -0,0 +1,133 @@
+#include <new>      // std::bad_alloc
+#include <string>   // std::string
+#include <tuple>    // std::tuple
+#include <utility>  // std::pair, std::forward
+#include <vector>   // std::vector
+
+#include "../driver/account.h"              // To get the account class
+#include "../include/counting_allocator.h"  // header file for tested functions
+#include "../include/hashtbl.h"             // header file for tested functions
+#include "gtest/gtest.h"                    // gtest lib
+
+// ============================================================================
+// TESTING MEMORY ACCOUNTING
+// ============================================================================
+
+namespace {
+struct IntTag {};
+struct AcctTag {};
+
+using CountedIntTbl = ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::NullObserver,
+                                  ac::CountingAllocator<ac::HashEntry<int, int>, IntTag> >;
+using CountedAcctTbl = ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual, ac::NullObserver,
+                                   ac::CountingAllocator<ac::HashEntry<Account::AcctKey, Account>, AcctTag> >;
+
+struct ThrowTag {};
+int construct_budget{0};  //!< Objects ThrowingAllocator builds before it throws.
+
+/// Counting allocator whose construct() throws once construct_budget objects have been built.
+template <class T>
+struct ThrowingAllocator : ac::CountingAllocator<T, ThrowTag> {
+    ThrowingAllocator() = default;
+    template <class U>
+    ThrowingAllocator(const ThrowingAllocator<U>&) {}
+    template <class U, class... Args>
+    void construct(U* p_, Args&&... args_) {
+        if (construct_budget-- <= 0) throw std::bad_alloc();
+        ::new (static_cast<void*>(p_)) U(std::forward<Args>(args_)...);
+    }
+    template <class U>
+    struct rebind {
+        using other = ThrowingAllocator<U>;
+    };
+};
+}  // namespace
+
+TEST(MemoryUsage, EmptyTable) {
+    ac::HashTbl<int, int> htable(11);
+    auto mu = htable.memory_usage();
+    ASSERT_EQ(mu.bucket_bytes, htable.bucket_count() * sizeof(ac::HashTbl<int, int>::list_type));
+    ASSERT_EQ(mu.node_bytes, 0);
+    ASSERT_EQ(mu.owned_heap_bytes, 0);
+}
+
+TEST(MemoryUsage, NodesGrowWithElements) {
+    ac::HashTbl<int, int> htable(101);
+    for (int i{0}; i < 50; i++) htable.insert(i, i);
+    auto mu = htable.memory_usage();
+    ASSERT_GE(mu.node_bytes, 50 * (sizeof(void *) + sizeof(ac::HashEntry<int, int>)));
+    ASSERT_EQ(mu.owned_heap_bytes, 0);
+    ASSERT_EQ(mu.total(), mu.bucket_bytes + mu.node_bytes);
+}
+
+TEST(MemoryUsage, OwnedHeapOfAccounts) {
+    ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual> htable;
+    Account small("Ana", 1, 2, 3, 10.f);
+    Account large(std::string(100, 'x'), 1, 2, 4, 10.f);
+    htable.insert(small.getKey(), small);
+    ASSERT_EQ(htable.memory_usage().owned_heap_bytes, 0);  // Short names live in the string itself.
+
+    htable.insert(large.getKey(), large);
+    // The long name is owned twice: by the key and by the account.
+    ASSERT_GE(htable.memory_usage().owned_heap_bytes, 2 * 100);
+    ASSERT_EQ(heap_bytes(small), 0);
+    ASSERT_GT(heap_bytes(large), 100);
+}
+
+TEST(MemoryUsage, NestedStdTypes) {
+    std::string name(100, 'x');
+    std::vector<std::pair<std::string, int> > pairs{{name, 1}};
+    ASSERT_GE(ac::heap_bytes(pairs), sizeof(pairs[0]) + 100);
+    std::vector<std::tuple<std::string> > tuples{std::make_tuple(name)};
+    ASSERT_GE(ac::heap_bytes(tuples), sizeof(tuples[0]) + 100);
+    std::pair<std::vector<std::string>, int> nested{{name, name}, 0};
+    ASSERT_GE(ac::heap_bytes(nested), 2 * sizeof(std::string) + 2 * 100);
+}
+
+TEST(CountingAllocator, BucketArrayDoesNotLeakWhenConstructionThrows) {
+    using ThrowingTbl = ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::NullObserver,
+                                    ThrowingAllocator<ac::HashEntry<int, int> > >;
+    auto &stats = ac::alloc_stats<ThrowTag>();
+    stats.reset();
+    construct_budget = 5;  // Fails on the sixth of the 11 buckets.
+    ASSERT_THROW(ThrowingTbl htable(11), std::bad_alloc);
+    ASSERT_EQ(stats.allocations, 1);
+    ASSERT_EQ(stats.deallocations, 1);
+    ASSERT_EQ(stats.bytes_in_use, 0);
+}
+
+TEST(CountingAllocator, CountsNodesAndBuckets) {
+    auto &stats = ac::alloc_stats<IntTag>();
+    {
+        CountedIntTbl htable(101);
+        stats.reset();
+        for (int i{0}; i < 50; i++) htable.insert(i, i);
+        ASSERT_EQ(stats.allocations, 50);  // One node per element, no rehash.
+        ASSERT_EQ(stats.deallocations, 0);
+
+        htable.erase(7);
+        ASSERT_EQ(stats.deallocations, 1);
+
+        for (int i{50}; i < 200; i++) htable.insert(i, i);  // Triggers a rehash: a new bucket array.
+        ASSERT_GT(stats.allocations, 200);
+        ASSERT_GE(stats.peak_bytes, stats.bytes_in_use);
+        ASSERT_GE(stats.bytes_in_use, htable.memory_usage().bucket_bytes + htable.memory_usage().node_bytes);
+    }
+    // Everything goes back to the allocator when the table is destroyed.
+    ASSERT_EQ(stats.bytes_in_use, 0);
+}
+
+TEST(CountingAllocator, RehashDoesNotReallocateNodes) {
+    auto &stats = ac::alloc_stats<AcctTag>();
+    CountedAcctTbl htable(2);
+    Account a("Ana", 1, 2, 3, 10.f);
+    stats.reset();
+    for (int i{0}; i < 100; i++) {
+        a.m_number = i;
+        htable.insert(a.getKey(), a);
+    }
+    // 100 nodes plus one bucket array per rehash; nodes are spliced, not copied.
+    auto rehashes = stats.allocations - 100;
+    ASSERT_LT(rehashes, 10);
+    ASSERT_EQ(stats.deallocations, rehashes);
+}
@@ -0,0 +1,86 @@
+#include <sstream>    // std::stringstream
+#include <stdexcept>  // std::runtime_error
+#include <vector>     // std::vector
+
+#include "../include/op_trace.h"  // header file for tested functions
+#include "gtest/gtest.h"          // gtest lib
+
+// ============================================================================
+// TESTING OPERATION TRACES
+// ============================================================================
+
+TEST(OpTrace, RoundTrip) {
+    std::vector<ac::TraceRecord> recs = {{ac::TraceOp::insert, 0, 0},
+                                         {ac::TraceOp::retrieve, 127, 10},
+                                         {ac::TraceOp::update, 128, 10},
+                                         {ac::TraceOp::erase, ~0ULL, 1ULL << 40}};
+    std::stringstream ss;
+    ac::TraceWriter writer(ss);
+    for (const auto &r : recs) writer.write(r);
+
+    ac::TraceReader reader(ss);
+    ac::TraceRecord got;
+    for (const auto &r : recs) {
+        ASSERT_TRUE(reader.next(got));
+        ASSERT_EQ(got.op, r.op);
+        ASSERT_EQ(got.key_id, r.key_id);
+        ASSERT_EQ(got.ts_ns, r.ts_ns);
+    }
+    ASSERT_FALSE(reader.next(got));
+}
+
+TEST(OpTrace, CompactRecords) {
+    std::stringstream ss;
+    ac::TraceWriter writer(ss);
+    for (std::uint64_t i{0}; i < 1000; i++) writer.write({ac::TraceOp::retrieve, i % 100, i * 100});
+    // Header + 1000 records of op (1 byte), small id (1 byte) and 100 ns delta (1 byte).
+    ASSERT_EQ(ss.str().size(), 5u + 3 * 1000);
+    ASSERT_EQ(writer.count(), 1000u);
+}
+
+TEST(OpTrace, RejectsBadInput) {
+    std::stringstream bad("JUNK\x01");
+    ASSERT_THROW(ac::TraceReader{bad}, std::runtime_error);
+
+    std::stringstream truncated;
+    ac::TraceWriter writer(truncated);
+    writer.write({ac::TraceOp::insert, 1000, 0});
+    std::string bytes = truncated.str();
+    std::stringstream cut(bytes.substr(0, bytes.size() - 2));
+    ac::TraceReader reader(cut);
+    ac::TraceRecord rec;
+    ASSERT_THROW(reader.next(rec), std::runtime_error);
+}
+
+TEST(OpTrace, RecorderInternsKeys) {
+    ac::HashTbl<int, int> table;
+    std::stringstream ss;
+    ac::TraceWriter writer(ss);
+    ac::RecordingHashTbl<ac::HashTbl<int, int> > rec(table, writer);
+
+    int data;
+    ASSERT_TRUE(rec.insert(500, 1));
+    ASSERT_TRUE(rec.insert(-7, 2));
+    ASSERT_TRUE(rec.retrieve(500, data));
+    rec.at(-7) = 3;
+    *rec.find(-7) += 1;
+    ASSERT_TRUE(rec.erase(500));
+    ASSERT_EQ(table.size(), 1);
+    ASSERT_EQ(table.at(-7), 4);
+    ASSERT_EQ(rec.distinct_keys(), 2);
+
+    ac::TraceReader reader(ss);
+    ac::TraceRecord r;
+    std::vector<ac::TraceOp> ops;
+    std::vector<std::uint64_t> ids;
+    std::uint64_t last_ts{0};
+    while (reader.next(r)) {
+        ops.push_back(r.op);
+        ids.push_back(r.key_id);
+        ASSERT_GE(r.ts_ns, last_ts);
+        last_ts = r.ts_ns;
+    }
+    ASSERT_EQ(ops, (std::vector<ac::TraceOp>{ac::TraceOp::insert, ac::TraceOp::insert, ac::TraceOp::retrieve,
+                                             ac::TraceOp::update, ac::TraceOp::update, ac::TraceOp::erase}));
+    ASSERT_EQ(ids, (std::vector<std::uint64_t>{0, 1, 0, 1, 1, 0}));
+}
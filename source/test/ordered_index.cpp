@@ -0,0 +1,78 @@
+#include <map>      // std::multimap
+#include <set>      // std::multiset
+#include <random>   // std::mt19937
+#include <tuple>    // std::make_tuple
+#include <vector>   // std::vector
+
+#include "../driver/account.h"         // To get the account class
+#include "../include/ordered_index.h"  // header file for tested functions
+#include "gtest/gtest.h"               // gtest lib
+
+// ============================================================================
+// TESTING ORDERED INDEX
+// ============================================================================
+
+TEST(OrderedIndex, RangesMatchMultimap) {
+    ac::IndexedHashTbl<int, int> table;
+    for (int i{0}; i < 3000; i++) table.insert(i, i % 500);
+    // Attached to a filled table, then kept in sync through enough changes to merge the delta several times.
+    auto &by_value = table.add_ordered_index([](const int &v) { return v; });
+
+    std::mt19937 rng(5);
+    for (int step{0}; step < 20000; step++) {
+        int key = static_cast<int>(rng() % 4000);
+        switch (rng() % 3) {
+            case 0:
+                table.insert(key, static_cast<int>(rng() % 500));
+                break;
+            case 1:
+                table.erase(key);
+                break;
+            default:
+                table.update(key, [&](int &v) { v = static_cast<int>(rng() % 500); });
+        }
+    }
+
+    std::multimap<int, const int *> expected;
+    table.primary().for_each([&](const int &, const int &v) { expected.emplace(v, &v); });
+    ASSERT_EQ(by_value.size(), expected.size());
+
+    for (int q{0}; q < 200; q++) {
+        int lo = static_cast<int>(rng() % 520) - 10, hi = lo + static_cast<int>(rng() % 60);
+        std::multiset<const int *> want, got;
+        for (auto it = expected.lower_bound(lo); it != expected.upper_bound(hi); ++it) want.insert(it->second);
+        int last = lo;
+        for (auto it = by_value.range(lo, hi).begin(); it != by_value.range(lo, hi).end(); ++it) {
+            ASSERT_GE(it.key(), last);  // In key order.
+            ASSERT_LE(it.key(), hi);
+            ASSERT_EQ(**it, it.key());
+            last = it.key();
+            got.insert(*it);
+        }
+        ASSERT_EQ(got, want);
+    }
+    ASSERT_TRUE(by_value.range(600, 700).empty());
+}
+
+TEST(OrderedIndex, AccountNumbersPerBranch) {
+    ac::IndexedHashTbl<Account::AcctKey, Account, KeyHash, KeyEqual> accounts;
+    auto &by_number = accounts.add_ordered_index(
+        [](const Account &a) { return std::make_tuple(a.m_bank_code, a.m_branch_code, a.m_number); });
+    Account seed[] = {{"Alex Bastos", 1, 1668, 54321, 1500.f},
+                      {"Aline Souza", 1, 1668, 45794, 530.f},
+                      {"Jose Lima", 1, 1668, 1231, 850.f},
+                      {"Saulo Cunha", 1, 1669, 50000, 5490.f},
+                      {"Lima Junior", 2, 1668, 50000, 150.f}};
+    for (auto &a : seed) accounts.insert(a.getKey(), a);
+
+    std::vector<int> got;
+    for (auto a : by_number.range(std::make_tuple(1, 1668, 40000), std::make_tuple(1, 1668, 60000)))
+        got.push_back(a->m_number);
+    ASSERT_EQ(got, (std::vector<int>{45794, 54321}));
+
+    accounts.erase(seed[1].getKey());
+    got.clear();
+    for (auto a : by_number.range(std::make_tuple(1, 1668, 0), std::make_tuple(1, 1668, 99999)))
+        got.push_back(a->m_number);
+    ASSERT_EQ(got, (std::vector<int>{1231, 54321}));
+}
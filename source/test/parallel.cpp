@@ -0,0 +1,150 @@
+#include <atomic>     // std::atomic
+#include <chrono>     // std::chrono::milliseconds
+#include <stdexcept>  // std::runtime_error
+#include <thread>     // std::this_thread::sleep_for
+#include <vector>     // std::vector
+
+#include "../include/hashtbl.h"      // header file for tested functions
+#include "../include/thread_pool.h"  // header file for tested functions
+#include "gtest/gtest.h"             // gtest lib
+
+// ============================================================================
+// TESTING THREAD POOL AND PARALLEL TRAVERSALS
+// ============================================================================
+
+TEST(ThreadPool, EveryIndexOnce) {
+    ac::ThreadPool pool(4);
+    ASSERT_EQ(pool.size(), 4u);
+    std::vector<std::atomic<int> > hits(10007);
+    for (auto &h : hits) h = 0;
+    pool.parallel_for(0, hits.size(), 3, [&](std::size_t lo, std::size_t hi, unsigned worker) {
+        ASSERT_LT(worker, 4u);
+        for (auto i = lo; i < hi; i++) hits[i]++;
+    });
+    for (auto &h : hits) ASSERT_EQ(h.load(), 1);
+
+    // The pool is reusable, and empty ranges are no-ops.
+    std::atomic<std::size_t> sum{0};
+    pool.parallel_for(5, 5, 0, [&](std::size_t, std::size_t, unsigned) { sum += 1000; });
+    pool.parallel_for(0, 100, 0, [&](std::size_t lo, std::size_t hi, unsigned) {
+        for (auto i = lo; i < hi; i++) sum += i;
+    });
+    ASSERT_EQ(sum.load(), 4950u);
+}
+
+TEST(ThreadPool, NestedLoopsAndExceptions) {
+    ac::ThreadPool pool(3);
+    std::atomic<int> inner{0};
+    pool.parallel_for(0, 6, 1, [&](std::size_t, std::size_t, unsigned) {
+        pool.parallel_for(0, 10, 1, [&](std::size_t lo, std::size_t hi, unsigned) { inner += hi - lo; });
+    });
+    ASSERT_EQ(inner.load(), 60);
+
+    ASSERT_THROW(pool.parallel_for(0, 100, 1,
+                                   [&](std::size_t lo, std::size_t, unsigned) {
+                                       if (lo == 42) throw std::runtime_error("chunk failed");
+                                   }),
+                 std::runtime_error);
+    // Still usable after a failed loop.
+    std::atomic<int> n{0};
+    pool.parallel_for(0, 10, 1, [&](std::size_t, std::size_t, unsigned) { n++; });
+    ASSERT_EQ(n.load(), 10);
+}
+
+TEST(ThreadPool, NestedPoolsOfDifferentSizes) {
+    ac::ThreadPool outer(4), inner(2);
+    std::atomic<unsigned> bad_inner{0}, bad_outer{0}, max_outer{0};
+    std::atomic<int> total{0};
+    outer.parallel_for(0, 40, 1, [&](std::size_t, std::size_t, unsigned worker) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));  // Lets every outer worker take chunks.
+        unsigned seen = max_outer.load();
+        while (worker > seen and !max_outer.compare_exchange_weak(seen, worker)) {
+        }
+        // The workers of the inner pool number its chunks, whichever outer worker started the loop.
+        inner.parallel_for(0, 10, 1, [&](std::size_t lo, std::size_t hi, unsigned w) {
+            if (w >= inner.size()) bad_inner++;
+            total += static_cast<int>(hi - lo);
+        });
+        // Back in the outer loop, a nested loop on the outer pool still runs as the calling worker.
+        outer.parallel_for(0, 1, 1, [&](std::size_t, std::size_t, unsigned w) {
+            if (w != worker) bad_outer++;
+        });
+    });
+    ASSERT_EQ(total.load(), 400);
+    ASSERT_EQ(bad_inner.load(), 0u);
+    ASSERT_EQ(bad_outer.load(), 0u);
+    ASSERT_GE(max_outer.load(), 2u);  // Some loops were started by workers the inner pool does not have.
+}
+
+TEST(HashTbl, ParallelForEachAndReduce) {
+    ac::ThreadPool pool(4);
+    ac::HashTbl<int, long long> ht;
+    ASSERT_EQ(ht.parallel_reduce(0LL, [](int, long long d) { return d; }, std::plus<long long>(), pool), 0);
+
+    long long expected{0};
+    for (int i{0}; i < 20000; i++) {
+        ht.insert(i, 3LL * i);
+        expected += 3LL * i;
+    }
+
+    std::atomic<long long> visited{0}, sum{0};
+    ht.parallel_for_each(
+        [&](const int &k, const long long &d) {
+            visited++;
+            sum += d - 3LL * k;  // Keys and data arrive paired.
+        },
+        pool);
+    ASSERT_EQ(visited.load(), 20000);
+    ASSERT_EQ(sum.load(), 0);
+
+    auto total = ht.parallel_reduce(0LL, [](int, long long d) { return d; },
+                                    [](long long a, long long b) { return a + b; }, pool);
+    ASSERT_EQ(total, expected);
+
+    // Non-scalar results: a histogram of the keys by their last digit.
+    auto digits = ht.parallel_reduce(
+        std::vector<int>(10, 0),
+        [](int k, long long) {
+            std::vector<int> v(10, 0);
+            v[k % 10] = 1;
+            return v;
+        },
+        [](std::vector<int> a, const std::vector<int> &b) {
+            for (std::size_t i{0}; i < a.size(); i++) a[i] += b[i];
+            return a;
+        },
+        pool);
+    for (auto d : digits) ASSERT_EQ(d, 2000);
+}
+
+TEST(HashTbl, ParallelEraseIf) {
+    ac::ThreadPool pool(4);
+    ac::HashTbl<int, int> ht;
+    for (int i{0}; i < 50000; i++) ht.insert(i, i % 7);
+
+    auto removed = ht.parallel_erase_if([](const int &, const int &d) { return d == 0; }, pool);
+    ASSERT_EQ(removed, 7143);
+    ASSERT_EQ(ht.size(), 50000u - 7143);
+    auto zeros = ht.parallel_reduce(0, [](int, int d) { return d == 0 ? 1 : 0; }, std::plus<int>(), pool);
+    ASSERT_EQ(zeros, 0);
+    int data;
+    ASSERT_TRUE(ht.retrieve(1, data));
+    ASSERT_FALSE(ht.retrieve(7, data));
+}
+
+TEST(HashTbl, ParallelApplyBatch) {
+    ac::ThreadPool pool(4);
+    ac::HashTbl<int, long> ht;
+    for (int i{0}; i < 20000; i++) ht.insert(i, 0);
+
+    // Each key gets an add and then a doubling, interleaved with the other keys: only the batch order gives 2 * (k+1).
+    std::vector<std::pair<int, int> > ops;  // (key, 0 to add key + 1 | 1 to double)
+    for (int round{0}; round < 2; round++)
+        for (int i{0}; i < 30000; i++) ops.emplace_back((i * 7919) % 30000, round);
+    auto applied = ht.parallel_apply_batch(
+        ops.begin(), ops.end(), [](const std::pair<int, int> &op) { return op.first; },
+        [](const std::pair<int, int> &op, long &d) { d = op.second ? 2 * d : d + op.first + 1; }, pool);
+    ASSERT_EQ(applied, 40000u);  // Keys 20000 and up are not in the table.
+    ASSERT_EQ(ht.size(), 20000u);
+    for (int i{0}; i < 20000; i++) ASSERT_EQ(ht[i], 2L * (i + 1));
+}
@@ -0,0 +1,94 @@
+#include <algorithm>  // std::min
+#include <map>        // std::multimap
+#include <random>     // std::mt19937
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+#include "../driver/account.h"        // To get the account class
+#include "../include/prefix_index.h"  // header file for tested functions
+#include "gtest/gtest.h"              // gtest lib
+
+// ============================================================================
+// TESTING PREFIX INDEX
+// ============================================================================
+
+TEST(PrefixIndex, PrefixesMatchMultimap) {
+    // Short strings over a small alphabet share many prefixes, so edges split and merge all the time.
+    std::mt19937 rng(3);
+    auto word = [&] {
+        std::string w;
+        for (auto len = rng() % 6; len > 0; len--) w += "ab\xe9z"[rng() % 4];
+        return w;
+    };
+    ac::IndexedHashTbl<int, std::string> table;
+    for (int i{0}; i < 500; i++) table.insert(i, word());
+    auto &by_word = table.add_prefix_index([](const std::string &s) { return s; });
+
+    for (int step{0}; step < 20000; step++) {
+        int key = static_cast<int>(rng() % 1000);
+        switch (rng() % 3) {
+            case 0:
+                table.insert(key, word());
+                break;
+            case 1:
+                table.erase(key);
+                break;
+            default:
+                table.update(key, [&](std::string &s) { s = word(); });
+        }
+    }
+
+    std::multimap<std::string, const std::string *> expected;
+    table.primary().for_each([&](const int &, const std::string &s) { expected.emplace(s, &s); });
+    ASSERT_EQ(by_word.size(), expected.size());
+
+    for (int q{0}; q < 300; q++) {
+        auto prefix = word().substr(0, 3);
+        std::vector<std::string> want;
+        for (const auto &e : expected)
+            if (e.first.compare(0, prefix.size(), prefix) == 0) want.push_back(e.first);
+        std::vector<std::string> got;
+        for (auto s : by_word.find_prefix(prefix)) got.push_back(*s);
+        ASSERT_EQ(got, want) << "prefix \"" << prefix << "\"";  // Same values, in string order.
+        ASSERT_EQ(by_word.count_prefix(prefix), want.size());
+
+        auto limit = rng() % 5;
+        ASSERT_EQ(by_word.find_prefix(prefix, limit).size(), std::min<std::size_t>(limit, want.size()));
+    }
+
+    // Once everything is gone, the trie shrinks back to its root.
+    table.clear();
+    for (int i{0}; i < 50; i++) table.insert(i, word());
+    for (int i{0}; i < 50; i++) table.erase(i);
+    ASSERT_EQ(by_word.size(), 0u);
+    ASSERT_EQ(by_word.nodes(), 1u);
+    ASSERT_TRUE(by_word.find_prefix("").empty());
+}
+
+TEST(PrefixIndex, ClientNames) {
+    ac::IndexedHashTbl<Account::AcctKey, Account, KeyHash, KeyEqual> accounts;
+    auto &by_name = accounts.add_prefix_index([](const Account &a) { return a.m_name; });
+    Account seed[] = {{"Alex Bastos", 1, 1668, 54321, 1500.f},
+                      {"Aline Souza", 1, 1668, 45794, 530.f},
+                      {"Alex Bastos", 13, 557, 87629, 150000.f},
+                      {"Ana Lima", 1, 331, 1231, 850.f},
+                      {"Bruno Dias", 1, 331, 1232, 10.f}};
+    for (auto &a : seed) accounts.insert(a.getKey(), a);
+
+    auto names = [&](const std::string &prefix, std::size_t limit) {
+        std::vector<std::string> v;
+        by_name.for_each_prefix(prefix, [&](const Account *a) { v.push_back(a->m_name); }, limit);
+        return v;
+    };
+    ASSERT_EQ(names("Al", 10), (std::vector<std::string>{"Alex Bastos", "Alex Bastos", "Aline Souza"}));
+    ASSERT_EQ(names("A", 2), (std::vector<std::string>{"Alex Bastos", "Alex Bastos"}));
+    ASSERT_EQ(names("Alex Bastos", 10).size(), 2u);
+    ASSERT_TRUE(names("Alexa", 10).empty());
+    ASSERT_EQ(by_name.count_prefix("A"), 4u);
+    ASSERT_EQ(by_name.count_prefix(""), 5u);
+
+    // Renaming moves the account to its new prefix.
+    accounts.update(seed[3].getKey(), [](Account &a) { a.m_name = "Bruna Lima"; });
+    ASSERT_EQ(names("Br", 10), (std::vector<std::string>{"Bruna Lima", "Bruno Dias"}));
+    ASSERT_EQ(by_name.count_prefix("An"), 0u);
+}
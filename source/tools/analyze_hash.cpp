@@ -0,0 +1,159 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Hash quality analyzer: runs keys through candidate KeyHash functors and reports how they spread over HashTbl.
+//
+// Usage: analyze_hash [--keys acct|int] [--n <count>] [--seed <s>] [--file <path>] [--hash xor|combine|all]
+//
+//   --keys   Key type to analyze: account keys (default) or plain ints.
+//   --n      Number of generated keys (default 200000).
+//   --seed   Seed of the account generator (default 1).
+//   --file   Read account keys from a file, one per line as "name;bank;branch;number" (not with --keys int).
+//   --hash   Which functor to analyze (default all).
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../driver/account.h"
+#include "../driver/account_gen.h"
+#include "../include/hash_utils.h"
+#include "hash_analyzer.h"
+
+namespace ac {
+/// Account keys expose the bits of the three integer fields and of the first bytes of the name.
+template <>
+struct KeyBits<Account::AcctKey> {
+    static std::size_t count(const Account::AcctKey& key_) {
+        return 3 * 32 + 8 * std::min<std::size_t>(8, std::get<0>(key_).size());
+    }
+    static Account::AcctKey flip(Account::AcctKey key_, std::size_t bit_) {
+        if (bit_ < 32) {
+            flip_field(std::get<1>(key_), bit_);
+        } else if (bit_ < 64) {
+            flip_field(std::get<2>(key_), bit_ - 32);
+        } else if (bit_ < 96) {
+            flip_field(std::get<3>(key_), bit_ - 64);
+        } else {
+            bit_ -= 96;
+            std::get<0>(key_)[bit_ / 8] ^= static_cast<char>(1u << (bit_ % 8));
+        }
+        return key_;
+    }
+
+   private:
+    /// Flips bit bit_ (< 32) of an integer field, shifting in unsigned arithmetic: 1 << 31 overflows an int.
+    template <class Field>
+    static void flip_field(Field& field_, std::size_t bit_) {
+        field_ = static_cast<Field>(static_cast<std::uint32_t>(field_) ^ (1u << bit_));
+    }
+};
+}  // namespace ac
+
+/// Candidate replacement for KeyHash: fields folded with hash_combine() instead of xor.
+struct CombineKeyHash {
+    std::size_t operator()(const Account::AcctKey& k_) const {
+        std::size_t seed{0};
+        ac::hash_combine(seed, std::get<0>(k_));
+        ac::hash_combine(seed, std::get<1>(k_));
+        ac::hash_combine(seed, std::get<2>(k_));
+        ac::hash_combine(seed, std::get<3>(k_));
+        return seed;
+    }
+};
+
+/// Candidate hash for integer keys: the key itself run through hash_mix().
+struct MixIntHash {
+    std::size_t operator()(int k_) const { return ac::hash_mix(static_cast<std::uint64_t>(k_)); }
+};
+
+int main(int argc, char* argv[]) {
+    std::string keys_kind{"acct"}, which{"all"}, file;
+    std::size_t n{200000};
+    std::uint64_t seed{1};
+
+    for (int i{1}; i < argc; i++) {
+        std::string arg{argv[i]};
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--keys")
+            keys_kind = argv[++i];
+        else if (arg == "--n")
+            n = std::stoul(argv[++i]);
+        else if (arg == "--seed")
+            seed = std::stoull(argv[++i]);
+        else if (arg == "--file")
+            file = argv[++i];
+        else if (arg == "--hash")
+            which = argv[++i];
+        else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (keys_kind == "int" and !file.empty()) {
+        std::cerr << "--file reads account keys; it cannot be used with --keys int\n";
+        return EXIT_FAILURE;
+    }
+    if (n == 0) {
+        std::cerr << "--n must be at least 1\n";
+        return EXIT_FAILURE;
+    }
+
+    bool flagged{false};
+    if (keys_kind == "int") {
+        std::vector<int> keys(n);
+        for (std::size_t i{0}; i < n; i++) keys[i] = static_cast<int>(i);
+        std::cout << ">>> Analyzing " << keys.size() << " sequential int keys.\n\n";
+
+        if (which == "all" or which == "std") {
+            auto r = ac::analyze_hash<int, std::hash<int> >("std::hash<int>", keys);
+            std::cout << r << std::endl;
+            flagged |= !r.flags.empty();
+        }
+        if (which == "all" or which == "mix") {
+            auto r = ac::analyze_hash<int, MixIntHash>("hash_mix(int)", keys);
+            std::cout << r << std::endl;
+            flagged |= !r.flags.empty();
+        }
+        return flagged ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    std::vector<Account::AcctKey> keys;
+    if (file.empty()) {
+        AccountGenerator gen(seed);
+        for (std::size_t i{0}; i < n; i++) keys.push_back(gen.next().getKey());
+        std::cout << ">>> Analyzing " << keys.size() << " generated account keys (seed " << seed << ").\n\n";
+    } else {
+        std::ifstream ifs(file);
+        if (!ifs) {
+            std::cerr << "Cannot open " << file << "\n";
+            return EXIT_FAILURE;
+        }
+        keys = read_account_keys(ifs);
+        if (keys.empty()) {
+            std::cerr << "No account keys in " << file << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << ">>> Analyzing " << keys.size() << " account keys from \"" << file << "\".\n\n";
+    }
+
+    if (which == "all" or which == "xor") {
+        auto r = ac::analyze_hash<Account::AcctKey, KeyHash, KeyEqual>("KeyHash (xor)", keys);
+        std::cout << r << std::endl;
+        flagged |= !r.flags.empty();
+    }
+    if (which == "all" or which == "combine") {
+        auto r = ac::analyze_hash<Account::AcctKey, CombineKeyHash, KeyEqual>("hash_combine", keys);
+        std::cout << r << std::endl;
+        flagged |= !r.flags.empty();
+    }
+
+    // A non-zero exit lets scripts refuse a functor that raised any warning.
+    return flagged ? EXIT_FAILURE : EXIT_SUCCESS;
+}
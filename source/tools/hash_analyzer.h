@@ -0,0 +1,183 @@
+// @author: Jonas, Neylane e Selan.
+
+#ifndef _HASH_ANALYZER_H_
+#define _HASH_ANALYZER_H_
+
+#include <algorithm>  // std::max, std::min
+#include <chrono>     // std::chrono::steady_clock
+#include <cmath>      // std::sqrt, std::fabs
+#include <cstdint>    // std::uint64_t
+#include <iomanip>    // std::setw, std::setprecision
+#include <iostream>   // std::ostream
+#include <sstream>    // std::ostringstream
+#include <stdexcept>  // std::invalid_argument
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+#include "hashtbl.h"
+
+namespace ac {
+/**
+ * @brief Describes how to flip single input bits of a key, so the analyzer can measure avalanche. Specialize it for
+ * every key type handed to analyze_hash(); the default handles integral keys.
+ */
+template <class KeyType>
+struct KeyBits {
+    static std::size_t count(const KeyType&) { return 8 * sizeof(KeyType); }
+    static KeyType flip(KeyType key_, std::size_t bit_) {
+        return static_cast<KeyType>(key_ ^ (static_cast<KeyType>(1) << bit_));
+    }
+};
+
+/// Distribution of the keys over one table size.
+struct ChainStats {
+    std::size_t buckets;  //!< Number of buckets (after the table picked its prime size).
+    double load;          //!< Keys per bucket.
+    double chi_square;    //!< Pearson statistic of the bucket counts against a uniform distribution.
+    double z_score;       //!< Chi-square normalized by its expectation: |z| > 3 means the spread is not uniform.
+    std::size_t max_chain;  //!< Longest collision list.
+    double mean_chain;      //!< Average length of the non-empty collision lists (what a successful lookup walks).
+};
+
+/// Everything the analyzer measured for one hash functor.
+struct HashReport {
+    std::string name;                //!< Label of the functor.
+    std::size_t n_keys;              //!< Number of keys analyzed.
+    std::size_t n_distinct;          //!< Number of distinct full hash values (64 bits).
+    double ns_per_key;               //!< Time spent in the functor per key.
+    double avalanche_mean;           //!< Average fraction of output bits flipped by one input bit (ideal: 0.5).
+    double avalanche_worst_bias;     //!< Largest |P(output bit flips) - 0.5| over all input/output bit pairs.
+    std::vector<ChainStats> chains;  //!< One entry per table size tried.
+    std::vector<std::string> flags;  //!< Human readable warnings; empty means the functor looks fine.
+};
+
+/// Knobs of the analyzer.
+struct AnalyzerConfig {
+    std::vector<double> loads{0.5, 1.0, 2.0, 4.0};  //!< Table sizes to try, expressed as keys per bucket.
+    std::size_t avalanche_samples{2000};            //!< Keys used for the avalanche test.
+    double max_z{3.0};                              //!< Chi-square z-score above which a flag is raised.
+    double max_bias{0.1};                           //!< Avalanche bias above which a flag is raised.
+};
+
+/**
+ * @brief Runs a set of keys through a hash functor and through the reduction used by HashTbl, and reports how good the
+ * resulting distribution is.
+ *
+ * @param name_ Label printed in the report.
+ * @param keys_ Keys to analyze, at least one. Duplicated keys are allowed but they skew the chi-square.
+ * @param cfg_ Analyzer settings.
+ * @return The measurements and the flags raised.
+ * @throw std::invalid_argument if keys_ is empty: there is no distribution to measure.
+ */
+template <class KeyType, class KeyHash, class KeyEqual = std::equal_to<KeyType> >
+HashReport analyze_hash(const std::string& name_, const std::vector<KeyType>& keys_,
+                        const AnalyzerConfig& cfg_ = AnalyzerConfig()) {
+    if (keys_.empty()) throw std::invalid_argument("analyze_hash: no keys to analyze");
+    HashReport report;
+    report.name = name_;
+    report.n_keys = keys_.size();
+    KeyHash hashFunc;
+
+    // Hashing speed. Storing the results keeps the calls alive and feeds the distinct-hash count below.
+    std::vector<std::uint64_t> hashes(keys_.size());
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i{0}; i < keys_.size(); i++) hashes[i] = hashFunc(keys_[i]);
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    report.ns_per_key = elapsed / keys_.size();
+
+    std::sort(hashes.begin(), hashes.end());
+    report.n_distinct = std::unique(hashes.begin(), hashes.end()) - hashes.begin();
+
+    // Avalanche: flip every input bit of a sample of keys and count which output bits change.
+    const std::size_t out_bits = 8 * sizeof(std::size_t);
+    std::vector<std::vector<std::size_t> > flips;
+    std::size_t trials{0}, total_flipped{0};
+    std::size_t step = std::max<std::size_t>(1, keys_.size() / std::max<std::size_t>(1, cfg_.avalanche_samples));
+    for (std::size_t k{0}; k < keys_.size(); k += step) {
+        std::size_t h = hashFunc(keys_[k]);
+        std::size_t n_bits = KeyBits<KeyType>::count(keys_[k]);
+        if (flips.size() < n_bits) flips.resize(n_bits, std::vector<std::size_t>(out_bits + 1, 0));
+        for (std::size_t bit{0}; bit < n_bits; bit++) {
+            std::size_t diff = h ^ hashFunc(KeyBits<KeyType>::flip(keys_[k], bit));
+            flips[bit][out_bits]++;  // Last slot counts the trials of this input bit.
+            for (std::size_t o{0}; o < out_bits; o++) {
+                if ((diff >> o) & 1) {
+                    flips[bit][o]++;
+                    total_flipped++;
+                }
+            }
+            trials++;
+        }
+    }
+    report.avalanche_mean = trials ? static_cast<double>(total_flipped) / (trials * out_bits) : 0;
+    report.avalanche_worst_bias = 0;
+    for (const auto& row : flips) {
+        if (row[out_bits] == 0) continue;
+        for (std::size_t o{0}; o < out_bits; o++) {
+            double p = static_cast<double>(row[o]) / row[out_bits];
+            report.avalanche_worst_bias = std::max(report.avalanche_worst_bias, std::fabs(p - 0.5));
+        }
+    }
+
+    // Chain lengths, measured on real tables so the prime sizes and the modulo reduction are the ones in production.
+    for (auto load : cfg_.loads) {
+        auto wanted = static_cast<std::size_t>(keys_.size() / load);
+        HashTbl<KeyType, char, KeyHash, KeyEqual> table(std::max<std::size_t>(2, wanted));
+        table.max_load_factor(static_cast<float>(keys_.size() + 1));  // Never rehash: keep the size we asked for.
+        for (const auto& key : keys_) table.insert(key, 0);
+
+        ChainStats stats{table.bucket_count(), 0, 0, 0, 0, 0};
+        double expected = static_cast<double>(table.size()) / stats.buckets;
+        std::size_t non_empty{0};
+        for (std::size_t b{0}; b < stats.buckets; b++) {
+            auto len = table.bucket_size(b);
+            stats.chi_square += (len - expected) * (len - expected) / expected;
+            stats.max_chain = std::max(stats.max_chain, len);
+            if (len) non_empty++;
+        }
+        double dof = stats.buckets - 1.0;
+        stats.load = expected;
+        stats.z_score = (stats.chi_square - dof) / std::sqrt(2 * dof);
+        stats.mean_chain = non_empty ? static_cast<double>(table.size()) / non_empty : 0;
+        report.chains.push_back(stats);
+
+        if (stats.z_score > cfg_.max_z) {
+            std::ostringstream oss;
+            oss << "non-uniform buckets at load " << std::setprecision(2) << stats.load << " (z = " << stats.z_score
+                << ", max chain " << stats.max_chain << ")";
+            report.flags.push_back(oss.str());
+        }
+    }
+
+    if (report.n_distinct < report.n_keys)
+        report.flags.push_back(std::to_string(report.n_keys - report.n_distinct) + " full 64-bit hash collisions");
+    if (report.avalanche_worst_bias > cfg_.max_bias) {
+        std::ostringstream oss;
+        oss << "weak mixing: mean avalanche " << std::setprecision(3) << report.avalanche_mean << ", worst bit bias "
+            << report.avalanche_worst_bias << " (fields are probably combined without mixing, e.g. by xor)";
+        report.flags.push_back(oss.str());
+    }
+
+    return report;
+}
+
+/// Prints a report in a human readable layout.
+inline std::ostream& operator<<(std::ostream& os_, const HashReport& r_) {
+    os_ << ">>> Hash \"" << r_.name << "\": " << r_.n_keys << " keys, " << r_.n_distinct << " distinct hashes, "
+        << std::fixed << std::setprecision(2) << r_.ns_per_key << " ns/key\n";
+    os_ << "    avalanche: mean " << std::setprecision(3) << r_.avalanche_mean << " (ideal 0.500), worst bias "
+        << r_.avalanche_worst_bias << "\n";
+    os_ << "    " << std::setw(10) << "buckets" << std::setw(8) << "load" << std::setw(14) << "chi-square"
+        << std::setw(10) << "z" << std::setw(11) << "max chain" << std::setw(12) << "mean chain" << "\n";
+    for (const auto& c : r_.chains) {
+        os_ << "    " << std::setw(10) << c.buckets << std::setw(8) << std::setprecision(2) << c.load << std::setw(14)
+            << std::setprecision(1) << c.chi_square << std::setw(10) << std::setprecision(2) << c.z_score
+            << std::setw(11) << c.max_chain << std::setw(12) << std::setprecision(3) << c.mean_chain << "\n";
+    }
+    if (r_.flags.empty()) os_ << "    OK: no weakness detected.\n";
+    for (const auto& f : r_.flags) os_ << "    WARNING: " << f << "\n";
+    return os_ << std::defaultfloat;
+}
+
+}  // namespace ac
+#endif
@@ -0,0 +1,249 @@
+// @author: Jonas, Neylane e Selan.
+//
+// Trace replayer: drives a table implementation with an operation trace (see op_trace.h) and reports throughput and
+// latency per operation.
+//
+// Usage: replay_trace --trace <file> [--table hashtbl|unordered_map|all] [--threads <t>] [--paced] [--seed <s>]
+//
+//   --trace    Trace to replay, as written by `driver_hash --load --record <file>`.
+//   --table    Implementation to drive (default all, one after the other).
+//   --threads  Number of replay threads (default 1). Operations are split by key id, so each key keeps its order.
+//   --paced    Keep the recorded timing between operations instead of replaying at full speed.
+//   --seed     Seed of the account generator that turns key ids into accounts (default 1).
+//
+// Traces hold key ids, not keys: id i is replayed as the i-th generated account. Replays start from an empty table.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../driver/account.h"
+#include "../driver/account_gen.h"
+#include "../include/hashtbl.h"
+#include "../include/latency_histogram.h"
+#include "../include/op_trace.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+const int n_ops = 4;
+const char* op_names[n_ops] = {"insert", "retrieve", "erase", "update"};
+
+/// A table the trace can be replayed against. Implementations must accept calls from several threads.
+class ReplayTarget {
+   public:
+    virtual ~ReplayTarget() = default;
+    /// Applies one operation on acct_'s key. Returns true when the key was found (or created, for inserts).
+    virtual bool apply(ac::TraceOp op_, const Account& acct_) = 0;
+    virtual std::size_t size() = 0;
+};
+
+/// HashTbl behind a single lock, as the services use it.
+class HashTblTarget : public ReplayTarget {
+   public:
+    bool apply(ac::TraceOp op_, const Account& acct_) override {
+        Account found;
+        std::lock_guard<std::mutex> guard(m_lock);
+        switch (op_) {
+            case ac::TraceOp::insert:
+                return m_table.insert(acct_.getKey(), acct_);
+            case ac::TraceOp::retrieve:
+                return m_table.retrieve(acct_.getKey(), found);
+            case ac::TraceOp::erase:
+                return m_table.erase(acct_.getKey());
+            default: {  // Read-modify-write of the balance, in place: one lookup, as on the other targets.
+                auto data = m_table.find(acct_.getKey());
+                if (!data) return false;
+                data->m_balance += 1.f;
+                return true;
+            }
+        }
+    }
+    std::size_t size() override { return m_table.size(); }
+
+   private:
+    std::mutex m_lock;
+    ac::HashTbl<Account::AcctKey, Account, KeyHash, KeyEqual> m_table;
+};
+
+/// std::unordered_map behind a single lock, as the reference point.
+class UnorderedMapTarget : public ReplayTarget {
+   public:
+    bool apply(ac::TraceOp op_, const Account& acct_) override {
+        std::lock_guard<std::mutex> guard(m_lock);
+        switch (op_) {
+            case ac::TraceOp::insert:
+                return m_map.insert(std::make_pair(acct_.getKey(), acct_)).second;
+            case ac::TraceOp::retrieve:
+                return m_map.find(acct_.getKey()) != m_map.end();
+            case ac::TraceOp::erase:
+                return m_map.erase(acct_.getKey()) != 0;
+            default: {
+                auto it = m_map.find(acct_.getKey());
+                if (it == m_map.end()) return false;
+                it->second.m_balance += 1.f;
+                return true;
+            }
+        }
+    }
+    std::size_t size() override { return m_map.size(); }
+
+   private:
+    std::mutex m_lock;
+    std::unordered_map<Account::AcctKey, Account, KeyHash, KeyEqual> m_map;
+};
+
+/// What one replay thread measured.
+struct ReplayStats {
+    ac::LatencyHistogram latencies[n_ops];  //!< Latency of the operations, in ns.
+    std::size_t hits[n_ops] = {0, 0, 0, 0};
+    std::uint64_t max_lag_ns{0};  //!< Paced replays: how late the worst operation started.
+};
+
+/// Body of a replay thread.
+void replay(ReplayTarget& target, const std::vector<ac::TraceRecord>& ops, const std::vector<Account>& accounts,
+            bool paced, Clock::time_point start, ReplayStats& stats) {
+    for (const auto& rec : ops) {
+        if (paced) {
+            auto due = start + std::chrono::nanoseconds(rec.ts_ns);
+            auto now = Clock::now();
+            // Sleeping is too coarse for short gaps, so only long ones sleep and the rest is spun.
+            if (due - now > std::chrono::microseconds(100))
+                std::this_thread::sleep_until(due - std::chrono::microseconds(50));
+            while ((now = Clock::now()) < due) {
+            }
+            auto lag = std::chrono::duration_cast<std::chrono::nanoseconds>(now - due).count();
+            stats.max_lag_ns = std::max(stats.max_lag_ns, static_cast<std::uint64_t>(lag));
+        }
+        int k = static_cast<int>(rec.op);
+        bool hit;
+        {
+            ac::ScopedLatency timer(stats.latencies[k]);
+            hit = target.apply(rec.op, accounts[rec.key_id]);
+        }
+        if (hit) stats.hits[k]++;
+    }
+}
+
+/// Replays the partitioned trace against target and prints the report.
+void run(const std::string& name, ReplayTarget& target, const std::vector<std::vector<ac::TraceRecord> >& parts,
+         const std::vector<Account>& accounts, bool paced) {
+    std::vector<ReplayStats> stats(parts.size());
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for (std::size_t t{0}; t < parts.size(); t++)
+        threads.emplace_back(replay, std::ref(target), std::cref(parts[t]), std::cref(accounts), paced, start,
+                             std::ref(stats[t]));
+    for (auto& th : threads) th.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << ">>> " << name << ":\n"
+              << std::setw(10) << "operation" << std::setw(12) << "ops" << std::setw(8) << "hit%" << std::setw(10)
+              << "p50 ns" << std::setw(10) << "p90 ns" << std::setw(10) << "p99 ns" << std::setw(11) << "p99.9 ns"
+              << std::setw(11) << "max ns" << "\n";
+    std::size_t total_ops{0};
+    std::uint64_t max_lag{0};
+    for (auto& s : stats) max_lag = std::max(max_lag, s.max_lag_ns);
+    for (int k{0}; k < n_ops; k++) {
+        ac::LatencyHistogram all;
+        std::size_t hits{0};
+        for (auto& s : stats) {
+            all.merge(s.latencies[k]);
+            hits += s.hits[k];
+        }
+        if (all.count() == 0) continue;
+        total_ops += all.count();
+        std::cout << std::setw(10) << op_names[k] << std::setw(12) << all.count() << std::setw(8) << std::fixed
+                  << std::setprecision(1) << 100.0 * hits / all.count() << std::setw(10) << all.percentile(0.5)
+                  << std::setw(10) << all.percentile(0.9) << std::setw(10) << all.percentile(0.99) << std::setw(11)
+                  << all.percentile(0.999) << std::setw(11) << all.max() << "\n";
+    }
+    std::cout << "    " << total_ops << " operations in " << std::setprecision(3) << elapsed << " s ("
+              << total_ops / elapsed / 1e6 << " Mops/s), final size " << target.size();
+    if (paced) std::cout << ", worst lag " << max_lag / 1000.0 << " us";
+    std::cout << "\n\n" << std::defaultfloat;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string trace_path, which{"all"};
+    unsigned n_threads{1};
+    bool paced{false};
+    std::uint64_t seed{1};
+
+    for (int i{1}; i < argc; i++) {
+        std::string arg{argv[i]};
+        if (arg == "--paced") {
+            paced = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--trace")
+            trace_path = argv[++i];
+        else if (arg == "--table")
+            which = argv[++i];
+        else if (arg == "--threads")
+            n_threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (arg == "--seed")
+            seed = std::stoull(argv[++i]);
+        else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (trace_path.empty() or n_threads == 0 or (which != "all" and which != "hashtbl" and which != "unordered_map")) {
+        std::cerr << "Usage: " << argv[0]
+                  << " --trace <file> [--table hashtbl|unordered_map|all] [--threads <t>] [--paced] [--seed <s>]\n";
+        return EXIT_FAILURE;
+    }
+
+    // The whole trace is decoded up front, so the replay measures the tables and not the decoder.
+    std::ifstream ifs(trace_path, std::ios::binary);
+    if (!ifs) {
+        std::cerr << "Cannot open " << trace_path << "\n";
+        return EXIT_FAILURE;
+    }
+    std::vector<std::vector<ac::TraceRecord> > parts(n_threads);
+    std::uint64_t n_records{0}, n_keys{0}, duration_ns{0};
+    try {
+        ac::TraceReader reader(ifs);
+        ac::TraceRecord rec;
+        while (reader.next(rec)) {
+            parts[rec.key_id % n_threads].push_back(rec);
+            n_keys = std::max(n_keys, rec.key_id + 1);
+            duration_ns = rec.ts_ns;
+            n_records++;
+        }
+    } catch (const std::runtime_error& e) {
+        std::cerr << trace_path << ": " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    AccountGenerator gen(seed);
+    std::vector<Account> accounts = gen.generate(n_keys);
+    std::cout << ">>> Replaying " << n_records << " operations on " << n_keys << " keys (recorded over "
+              << duration_ns / 1e9 << " s) with " << n_threads << " thread(s), "
+              << (paced ? "original pacing" : "full speed") << ".\n\n";
+
+    if (which == "all" or which == "hashtbl") {
+        HashTblTarget target;
+        run("HashTbl", target, parts, accounts, paced);
+    }
+    if (which == "all" or which == "unordered_map") {
+        UnorderedMapTarget target;
+        run("std::unordered_map", target, parts, accounts, paced);
+    }
+    return EXIT_SUCCESS;
+}